@@ -1252,9 +1252,10 @@ static void ComputeLineNumbers(DiagnosticsEngine &Diag, ContentCache *FI,
   const unsigned char *End = (const unsigned char *)Buffer->getBufferEnd();
   unsigned I = 0;
   while (true) {
-    // Skip over the contents of the line.
-    while (Buf[I] != '\n' && Buf[I] != '\r' && Buf[I] != '\0')
-      ++I;
+    // Skip over the contents of the line. The buffer is null terminated, so
+    // this always finds a character.
+    StringRef Rest((const char *)Buf + I, End - Buf - I + 1);
+    I += Rest.find_first_of(StringRef("\n\r\0", 3));
 
     if (Buf[I] == '\n' || Buf[I] == '\r') {
       // If this is \r\n, skip both characters.
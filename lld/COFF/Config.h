@@ -105,6 +105,7 @@ struct Configuration {
   bool debugSymtab = false;
   bool showTiming = false;
   bool showSummary = false;
+  bool printArenaUsage = false;
   unsigned debugTypes = static_cast<unsigned>(DebugType::None);
   std::vector<std::string> natvisFiles;
   llvm::SmallString<128> pdbAltPath;
@@ -1137,6 +1137,9 @@ void LinkerDriver::link(ArrayRef<const char *> argsArr) {
 
   config->showSummary = args.hasArg(OPT_summary);
 
+  config->printArenaUsage = args.hasArg(OPT_print_arena_usage);
+  recordPhaseMemory = config->printArenaUsage;
+
   ScopedTimer t(Timer::root());
   // Handle --version, which is an lld extension. This option is a bit odd
   // because it doesn't start with "/", but we deliberately chose "--" to
@@ -1974,6 +1977,21 @@ void LinkerDriver::link(ArrayRef<const char *> argsArr) {
   Timer::root().stop();
   if (config->showTiming)
     Timer::root().print();
+
+  if (config->printArenaUsage) {
+    size_t numSymbols = 0;
+    symtab->forEachSymbol([&](Symbol *) { ++numSymbols; });
+    message("input files: " + Twine(ObjFile::instances.size()));
+    message("chunks: " + Twine(symtab->getChunks().size()));
+    message("symbols: " + Twine(numSymbols));
+
+    std::string s;
+    raw_string_ostream os(s);
+    printArenaUsage(os);
+    os << "\n";
+    Timer::root().printMemory(os);
+    message(StringRef(os.str()).rtrim('\n'));
+  }
 }
 
 } // namespace coff
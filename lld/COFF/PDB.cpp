@@ -72,6 +72,7 @@ static ExitOnError exitOnErr;
 static Timer totalPdbLinkTimer("PDB Emission (Cumulative)", Timer::root());
 
 static Timer addObjectsTimer("Add Objects", totalPdbLinkTimer);
+static Timer typeHashingTimer("Type Hashing", addObjectsTimer);
 static Timer typeMergingTimer("Type Merging", addObjectsTimer);
 static Timer symbolMergingTimer("Symbol Merging", addObjectsTimer);
 static Timer globalsLayoutTimer("Globals Stream Layout", totalPdbLinkTimer);
@@ -105,6 +106,10 @@ public:
   /// Link info for each import file in the symbol table into the PDB.
   void addImportFilesToPDB(ArrayRef<OutputSection *> outputSections);
 
+  /// Compute global type hashes for all object files that lack a usable
+  /// .debug$H section, in parallel, so that mergeDebugT doesn't have to.
+  void precomputeGlobalTypeHashes();
+
   /// Link CodeView from a single object file into the target (output) PDB.
   /// When a precompiled headers object is linked, its TPI map might be provided
   /// externally.
@@ -185,6 +190,10 @@ private:
   /// far.
   std::map<uint32_t, CVIndexMap> precompTypeIndexMappings;
 
+  /// Global type hashes computed by precomputeGlobalTypeHashes(). Each entry
+  /// is removed by mergeDebugT() when it merges the file.
+  llvm::DenseMap<const ObjFile *, std::vector<GloballyHashedType>> ghashes;
+
   // For statistics
   uint64_t globalSymbols = 0;
   uint64_t moduleSymbols = 0;
@@ -324,12 +333,47 @@ static void addTypeInfo(pdb::TpiStreamBuilder &tpiBuilder,
   // Start the TPI or IPI stream header.
   tpiBuilder.setVersionHeader(pdb::PdbTpiV80);
 
-  // Flatten the in memory type table and hash each type.
-  typeTable.ForEachRecord([&](TypeIndex ti, const CVType &type) {
-    auto hash = pdb::hashTypeRecord(type);
+  // Flatten the in memory type table and hash each type. Hashing is
+  // independent for each record, so do that in parallel and add the records
+  // in index order afterwards.
+  std::vector<CVType> types;
+  types.reserve(typeTable.size());
+  typeTable.ForEachRecord(
+      [&](TypeIndex ti, const CVType &type) { types.push_back(type); });
+
+  std::vector<uint32_t> hashes(types.size());
+  parallelForEachN(0, types.size(), [&](size_t i) {
+    auto hash = pdb::hashTypeRecord(types[i]);
     if (auto e = hash.takeError())
       fatal("type hashing error");
-    tpiBuilder.addTypeRecord(type.RecordData, *hash);
+    hashes[i] = *hash;
+  });
+
+  for (size_t i = 0, e = types.size(); i != e; ++i)
+    tpiBuilder.addTypeRecord(types[i].RecordData, hashes[i]);
+}
+
+void PDBLinker::precomputeGlobalTypeHashes() {
+  ScopedTimer t(typeHashingTimer);
+
+  // Objects using a PCH object or a type server are merged differently and
+  // keep hashing their types on demand in mergeDebugT.
+  std::vector<ObjFile *> files;
+  for (ObjFile *file : ObjFile::instances) {
+    if (!file->debugTypesObj || getDebugH(file))
+      continue;
+    TpiSource::TpiKind kind = file->debugTypesObj->kind;
+    if (kind != TpiSource::Regular && kind != TpiSource::PCH)
+      continue;
+    files.push_back(file);
+    ghashes[file];
+  }
+
+  // Each file's records are hashed in order, since a record's global hash
+  // depends on the hashes of the records it refers to. Files are independent.
+  parallelForEach(files, [&](ObjFile *file) {
+    ghashes.find(file)->second =
+        GloballyHashedType::hashTypes(*file->debugTypes);
   });
 }
 
@@ -394,9 +438,16 @@ PDBLinker::mergeDebugT(ObjFile *file, CVIndexMap *objectIndexMap) {
   if (config->debugGHashes) {
     ArrayRef<GloballyHashedType> hashes;
     std::vector<GloballyHashedType> ownedHashes;
+    auto it = ghashes.find(file);
     if (Optional<ArrayRef<uint8_t>> debugH = getDebugH(file))
       hashes = getHashesFromDebugH(*debugH);
-    else {
+    else if (it != ghashes.end()) {
+      // Take ownership and drop the entry, so the hashes are freed once this
+      // file is merged.
+      ownedHashes = std::move(it->second);
+      ghashes.erase(it);
+      hashes = ownedHashes;
+    } else {
       ownedHashes = GloballyHashedType::hashTypes(types);
       hashes = ownedHashes;
     }
@@ -1273,6 +1324,11 @@ void PDBLinker::addObjectsToPDB() {
 
   createModuleDBI(builder);
 
+  // Hash all types up front in parallel. Merging below still visits files in
+  // command line order, so type indices are assigned deterministically.
+  if (config->debugGHashes)
+    precomputeGlobalTypeHashes();
+
   for (ObjFile *file : ObjFile::instances)
     addObjFile(file);
 
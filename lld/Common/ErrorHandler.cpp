@@ -33,6 +33,13 @@ static std::mutex mu;
 // if the last messages was multi-line. Otherwise "".
 static StringRef sep;
 
+// The innermost ErrorSuppressor of the current thread.
+static LLVM_THREAD_LOCAL ErrorSuppressor *suppressor = nullptr;
+
+ErrorSuppressor::ErrorSuppressor() : prev(suppressor) { suppressor = this; }
+
+ErrorSuppressor::~ErrorSuppressor() { suppressor = prev; }
+
 static StringRef getSeparator(const Twine &msg) {
   if (StringRef(msg.str()).contains('\n'))
     return "\n";
@@ -171,6 +178,11 @@ void ErrorHandler::warn(const Twine &msg) {
 }
 
 void ErrorHandler::error(const Twine &msg) {
+  if (suppressor) {
+    ++suppressor->count;
+    return;
+  }
+
   // If Visual Studio-style error message mode is enabled,
   // this particular error is printed out as two errors.
   if (vsDiagnostics) {
@@ -204,6 +216,7 @@ void ErrorHandler::error(const Twine &msg) {
 }
 
 void ErrorHandler::fatal(const Twine &msg) {
+  suppressor = nullptr;
   error(msg);
   exitLld(1);
 }
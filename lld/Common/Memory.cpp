@@ -7,6 +7,13 @@
 //===----------------------------------------------------------------------===//
 
 #include "lld/Common/Memory.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/TimeProfiler.h"
+#include "llvm/Support/raw_ostream.h"
+#include <mutex>
 
 using namespace llvm;
 using namespace lld;
@@ -15,8 +22,107 @@ BumpPtrAllocator lld::bAlloc;
 StringSaver lld::saver{bAlloc};
 std::vector<SpecificAllocBase *> lld::SpecificAllocBase::instances;
 
+// make<T> creates the arena for T on first use, which may happen on several
+// threads at once.
+static std::mutex instancesMutex;
+
+lld::SpecificAllocBase::SpecificAllocBase() {
+  std::lock_guard<std::mutex> lock(instancesMutex);
+  instances.push_back(this);
+}
+
 void lld::freeArena() {
   for (SpecificAllocBase *alloc : SpecificAllocBase::instances)
     alloc->reset();
   bAlloc.Reset();
 }
+
+// Returns the resident set size of the current process.
+static uint64_t getResidentSize() {
+#if defined(__linux__)
+  ErrorOr<std::unique_ptr<MemoryBuffer>> mbOrErr =
+      MemoryBuffer::getFileAsStream("/proc/self/statm");
+  if (!mbOrErr)
+    return 0;
+  // The second field is the number of resident pages.
+  StringRef resident = (*mbOrErr)->getBuffer().split(' ').second;
+  uint64_t pages;
+  if (resident.split(' ').first.getAsInteger(10, pages))
+    return 0;
+  return pages * sys::Process::getPageSizeEstimate();
+#else
+  return 0;
+#endif
+}
+
+MemoryUsage lld::getMemoryUsage() {
+  MemoryUsage usage;
+  usage.arenaBytes = bAlloc.getTotalMemory();
+  for (SpecificAllocBase *alloc : SpecificAllocBase::instances) {
+    usage.arenaBytes += alloc->getTotalMemory();
+    usage.arenaObjects += alloc->getBytesAllocated() / alloc->getObjectSize();
+  }
+  usage.rss = getResidentSize();
+  return usage;
+}
+
+namespace {
+struct PhaseSample {
+  StringRef phase;
+  MemoryUsage usage;
+};
+} // namespace
+
+bool lld::recordPhaseMemory = false;
+static std::vector<PhaseSample> phaseSamples;
+
+void lld::samplePhaseMemory(StringRef phase) {
+  bool trace = timeTraceProfilerEnabled();
+  if (!trace && !recordPhaseMemory)
+    return;
+
+  MemoryUsage usage = getMemoryUsage();
+  if (trace)
+    timeTraceProfilerCounter("Memory", {{"arena bytes", usage.arenaBytes},
+                                        {"arena objects", usage.arenaObjects},
+                                        {"rss", usage.rss}});
+  if (recordPhaseMemory)
+    phaseSamples.push_back({phase, usage});
+}
+
+void lld::printArenaUsage(raw_ostream &os) {
+  std::vector<SpecificAllocBase *> allocs;
+  for (SpecificAllocBase *alloc : SpecificAllocBase::instances)
+    if (alloc->getTotalMemory())
+      allocs.push_back(alloc);
+  llvm::stable_sort(allocs, [](SpecificAllocBase *a, SpecificAllocBase *b) {
+    return a->getTotalMemory() > b->getTotalMemory();
+  });
+
+  os << "       Bytes      Objects  Type\n";
+  for (SpecificAllocBase *alloc : allocs)
+    os << format("%12" PRIu64 " %12" PRIu64 "  ",
+                  (uint64_t)alloc->getTotalMemory(),
+                  (uint64_t)(alloc->getBytesAllocated() /
+                             alloc->getObjectSize()))
+       << alloc->getTypeName() << "\n";
+  os << format("%12" PRIu64 "            -  ",
+                (uint64_t)bAlloc.getTotalMemory())
+     << "<untyped arena and strings>\n";
+
+  MemoryUsage usage = getMemoryUsage();
+  os << format("%12" PRIu64 " %12" PRIu64 "  ", usage.arenaBytes,
+               usage.arenaObjects)
+     << "<total arena>\n";
+  if (usage.rss)
+    os << format("%12" PRIu64 "            -  ", usage.rss)
+       << "<resident set size>\n";
+
+  if (phaseSamples.empty())
+    return;
+  os << "\n Arena bytes          RSS  After phase\n";
+  for (const PhaseSample &s : phaseSamples)
+    os << format("%12" PRIu64 " %12" PRIu64 "  ", s.usage.arenaBytes,
+                 s.usage.rss)
+       << s.phase << "\n";
+}
@@ -8,17 +8,24 @@
 
 #include "lld/Common/Timer.h"
 #include "lld/Common/ErrorHandler.h"
+#include "lld/Common/Memory.h"
 #include "llvm/Support/Format.h"
 
 using namespace lld;
 using namespace llvm;
 
-ScopedTimer::ScopedTimer(Timer &t) : t(&t) { t.start(); }
+ScopedTimer::ScopedTimer(Timer &t) : t(&t) {
+  if (recordPhaseMemory)
+    t.sampleMemory(true);
+  t.start();
+}
 
 void ScopedTimer::stop() {
   if (!t)
     return;
   t->stop();
+  if (recordPhaseMemory)
+    t->sampleMemory(false);
   t = nullptr;
 }
 
@@ -38,6 +45,18 @@ void Timer::stop() {
   total += (std::chrono::high_resolution_clock::now() - startTime);
 }
 
+void Timer::sampleMemory(bool starting) {
+  MemoryUsage usage = getMemoryUsage();
+  peakRss = std::max(peakRss, usage.rss);
+  if (starting) {
+    startArenaBytes = usage.arenaBytes;
+    startArenaObjects = usage.arenaObjects;
+    return;
+  }
+  arenaBytes += usage.arenaBytes - startArenaBytes;
+  arenaObjects += usage.arenaObjects - startArenaObjects;
+}
+
 Timer &Timer::root() {
   static Timer rootTimer("Total Link Time");
   return rootTimer;
@@ -77,3 +96,17 @@ void Timer::print(int depth, double totalDuration, bool recurse) const {
       child->print(depth + 1, totalDuration);
   }
 }
+
+void Timer::printMemory(raw_ostream &os) const {
+  os << " Arena bytes      Objects     Peak RSS  Timer\n";
+  for (const auto &child : children)
+    child->printMemory(os, 0);
+}
+
+void Timer::printMemory(raw_ostream &os, int depth) const {
+  os << format("%12" PRId64 " %12" PRId64 " %12" PRIu64 "  ", arenaBytes,
+               arenaObjects, peakRss)
+     << std::string(depth * 2, ' ') << name << "\n";
+  for (const auto &child : children)
+    child->printMemory(os, depth + 1);
+}
@@ -99,7 +99,7 @@ using SectionPair =
 
 // Take the edge list in Config->CallGraphProfile, resolve symbol names to
 // Symbols, and generate a graph between InputSections with the provided
-// weights.
+// weights. Node weights from Config->CallGraphSamples are added on top.
 CallGraphSort::CallGraphSort() {
   MapVector<SectionPair, uint64_t> &profile = config->callGraphProfile;
   DenseMap<const InputSectionBase *, int> secToCluster;
@@ -143,6 +143,16 @@ CallGraphSort::CallGraphSort() {
       toC.bestPred.weight = weight;
     }
   }
+
+  // Sampled sections are hot even if no edge reaches them. Their sample count
+  // adds to the weight, so they are placed by density along with the rest of
+  // the graph, ahead of all sections the profile did not mention.
+  for (std::pair<const InputSectionBase *, uint64_t> &c :
+       config->callGraphSamples) {
+    const auto *sec = cast<InputSectionBase>(c.first->repl);
+    clusters[getOrCreateNode(sec)].weight += c.second;
+  }
+
   for (Cluster &c : clusters)
     c.initialWeight = c.weight;
 }
@@ -67,6 +67,9 @@ enum class SeparateSegmentKind { None, Code, Loadable };
 // For -z *stack
 enum class GnuStackKind { None, Exec, NoExec };
 
+// For --compress-debug-sections.
+enum class DebugCompressionKind { None, Zlib, Zstd };
+
 struct SymbolVersion {
   llvm::StringRef name;
   bool isExternCpp;
@@ -113,6 +116,7 @@ struct Configuration {
   llvm::StringRef sysroot;
   llvm::StringRef thinLTOCacheDir;
   llvm::StringRef thinLTOIndexOnlyArg;
+  llvm::StringRef timeTraceFile;
   std::pair<llvm::StringRef, llvm::StringRef> thinLTOObjectSuffixReplace;
   std::pair<llvm::StringRef, llvm::StringRef> thinLTOPrefixReplace;
   std::string rpath;
@@ -127,6 +131,7 @@ struct Configuration {
   llvm::MapVector<std::pair<const InputSectionBase *, const InputSectionBase *>,
                   uint64_t>
       callGraphProfile;
+  llvm::MapVector<const InputSectionBase *, uint64_t> callGraphSamples;
   bool allowMultipleDefinition;
   bool allowShlibUndefined;
   bool androidPackDynRelocs;
@@ -138,7 +143,6 @@ struct Configuration {
   bool bsymbolicFunctions;
   bool callGraphProfileSort;
   bool checkSections;
-  bool compressDebugSections;
   bool cref;
   bool defineCommon;
   bool demangle = true;
@@ -163,6 +167,7 @@ struct Configuration {
   bool hasDynSymTab;
   bool ignoreDataAddressEquality;
   bool ignoreFunctionAddressEquality;
+  bool incremental;
   bool ltoCSProfileGenerate;
   bool ltoDebugPassManager;
   bool ltoNewPassManager;
@@ -178,6 +183,7 @@ struct Configuration {
   bool pacPlt;
   bool picThunk;
   bool pie;
+  bool printArenaUsage;
   bool printGcSections;
   bool printIcfSections;
   bool relocatable;
@@ -186,11 +192,13 @@ struct Configuration {
   bool singleRoRx;
   bool shared;
   bool isStatic = false;
+  bool streamOutput;
   bool sysvHash = false;
   bool target1Rel;
   bool trace;
   bool thinLTOEmitImportsFiles;
   bool thinLTOIndexOnly;
+  bool timeTraceEnabled;
   bool tocOptimize;
   bool undefinedVersion;
   bool useAndroidRelrTags = false;
@@ -229,6 +237,7 @@ struct Configuration {
   Target2Policy target2;
   ARMVFPArgKind armVFPArgs = ARMVFPArgKind::Default;
   BuildIdKind buildId = BuildIdKind::None;
+  DebugCompressionKind compressDebugSections = DebugCompressionKind::None;
   SeparateSegmentKind zSeparate;
   ELFKind ekind = ELFNoneKind;
   uint16_t emachine = llvm::ELF::EM_NONE;
@@ -241,7 +250,9 @@ struct Configuration {
   unsigned ltoo;
   unsigned optimize;
   unsigned thinLTOJobs;
+  unsigned timeTraceGranularity;
   int32_t splitStackAdjustSize;
+  int64_t thinLTOMemoryLimit; // In megabytes.
 
   // The following config options do not directly correspond to any
   // particular command line options.
@@ -56,6 +56,7 @@
 #include "llvm/Support/Path.h"
 #include "llvm/Support/TarWriter.h"
 #include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/TimeProfiler.h"
 #include "llvm/Support/raw_ostream.h"
 #include <cstdlib>
 #include <utility>
@@ -431,6 +432,36 @@ static void checkZOptions(opt::InputArgList &args) {
       error("unknown -z value: " + StringRef(arg->getValue()));
 }
 
+// Write the time trace recorded by --time-trace to a file.
+static void writeTimeTrace() {
+  std::string path = config->timeTraceFile;
+  if (path.empty())
+    path = (config->outputFile + ".time-trace").str();
+
+  std::error_code ec;
+  raw_fd_ostream os(path, ec, sys::fs::OF_Text);
+  if (ec) {
+    error("cannot open " + path + ": " + ec.message());
+    return;
+  }
+  timeTraceProfilerWrite(os);
+}
+
+// Print the report requested by --print-arena-usage.
+static void reportArenaUsage() {
+  size_t numSymbols = 0;
+  symtab->forEachSymbol([&](Symbol *) { ++numSymbols; });
+  message("input files: " + Twine(objectFiles.size() + sharedFiles.size() +
+                                   bitcodeFiles.size()));
+  message("input sections: " + Twine(inputSections.size()));
+  message("symbols: " + Twine(numSymbols));
+
+  std::string s;
+  raw_string_ostream os(s);
+  lld::printArenaUsage(os);
+  message(StringRef(os.str()).rtrim('\n'));
+}
+
 void LinkerDriver::main(ArrayRef<const char *> argsArr) {
   ELFOptTable parser;
   opt::InputArgList args = parser.parse(argsArr.slice(1));
@@ -486,37 +517,54 @@ void LinkerDriver::main(ArrayRef<const char *> argsArr) {
   if (args.hasArg(OPT_version))
     return;
 
-  initLLVM();
-  createFiles(args);
-  if (errorCount())
-    return;
+  if (config->timeTraceEnabled)
+    timeTraceProfilerInitialize(config->timeTraceGranularity);
+  recordPhaseMemory = config->printArenaUsage;
+
+  {
+    llvm::TimeTraceScope timeScope("ExecuteLinker", config->outputFile);
+
+    // Don't return early from this block: the time trace below must be
+    // written even if the link fails.
+    initLLVM();
+    createFiles(args);
+    if (!errorCount()) {
+      inferMachineType();
+      setConfigs(args);
+      checkOptions();
+    }
 
-  inferMachineType();
-  setConfigs(args);
-  checkOptions();
-  if (errorCount())
-    return;
+    // The Target instance handles target-specific stuff, such as applying
+    // relocations or writing a PLT section. It also contains target-dependent
+    // values such as a default image base address.
+    if (!errorCount()) {
+      target = getTarget();
 
-  // The Target instance handles target-specific stuff, such as applying
-  // relocations or writing a PLT section. It also contains target-dependent
-  // values such as a default image base address.
-  target = getTarget();
+      switch (config->ekind) {
+      case ELF32LEKind:
+        link<ELF32LE>(args);
+        break;
+      case ELF32BEKind:
+        link<ELF32BE>(args);
+        break;
+      case ELF64LEKind:
+        link<ELF64LE>(args);
+        break;
+      case ELF64BEKind:
+        link<ELF64BE>(args);
+        break;
+      default:
+        llvm_unreachable("unknown Config->EKind");
+      }
+    }
+  }
 
-  switch (config->ekind) {
-  case ELF32LEKind:
-    link<ELF32LE>(args);
-    return;
-  case ELF32BEKind:
-    link<ELF32BE>(args);
-    return;
-  case ELF64LEKind:
-    link<ELF64LE>(args);
-    return;
-  case ELF64BEKind:
-    link<ELF64BE>(args);
-    return;
-  default:
-    llvm_unreachable("unknown Config->EKind");
+  if (config->printArenaUsage)
+    reportArenaUsage();
+
+  if (config->timeTraceEnabled) {
+    writeTimeTrace();
+    timeTraceProfilerCleanup();
   }
 }
 
@@ -757,6 +805,134 @@ static void readCallGraph(MemoryBufferRef mb) {
   }
 }
 
+// Reads a sampled address profile collected from a previous build of the
+// output. Each line is either "<address> <count>" for an instruction pointer
+// sample or "<from> <to> <count>" for a taken branch (e.g. from LBR), where
+// addresses are hexadecimal virtual addresses in the profiled binary.
+// Addresses are mapped back to function symbols of that binary, and from there
+// by name to the input sections of this link. Local symbols are told apart by
+// the STT_FILE symbol preceding them in the binary, which is matched against
+// the source file name of each input file. Sampled sections become hot nodes
+// for the call graph sort and branches between them become its edges.
+template <class ELFT>
+static void readCallGraphSamples(MemoryBufferRef mb, MemoryBufferRef binary) {
+  Expected<std::unique_ptr<ObjectFile>> objOrErr =
+      ObjectFile::createObjectFile(binary);
+  if (!objOrErr) {
+    error(binary.getBufferIdentifier() + ": " +
+          toString(objOrErr.takeError()));
+    return;
+  }
+  auto *obj = dyn_cast<ELFObjectFileBase>(objOrErr->get());
+  if (!obj) {
+    error(binary.getBufferIdentifier() + ": not an ELF file");
+    return;
+  }
+
+  // A function of the profiled binary. `file` is the name of the source file
+  // of a local symbol, and empty for a global one.
+  struct FuncRange {
+    uint64_t start;
+    uint64_t size;
+    StringRef file;
+    StringRef name;
+    bool resolved = false;
+    InputSectionBase *sec = nullptr;
+  };
+  std::vector<FuncRange> funcs;
+  StringRef file;
+  for (ELFSymbolRef sym : obj->symbols()) {
+    Expected<uint64_t> addr = sym.getAddress();
+    Expected<StringRef> name = sym.getName();
+    if (!addr || !name) {
+      consumeError(addr.takeError());
+      consumeError(name.takeError());
+      continue;
+    }
+    if (sym.getELFType() == STT_FILE)
+      file = *name;
+    else if (sym.getELFType() == STT_FUNC && !name->empty())
+      funcs.push_back({*addr, sym.getSize(),
+                       sym.getBinding() == STB_LOCAL ? file : StringRef(),
+                       *name});
+  }
+  llvm::stable_sort(funcs, [](const FuncRange &a, const FuncRange &b) {
+    return a.start < b.start;
+  });
+
+  // Build a map from (source file, symbol name) to symbol. Global symbols
+  // have an empty source file name. A null symbol means that the name is
+  // ambiguous.
+  DenseMap<std::pair<StringRef, StringRef>, Symbol *> map;
+  for (InputFile *f : objectFiles) {
+    StringRef sourceFile = cast<ObjFile<ELFT>>(f)->sourceFile;
+    for (Symbol *sym : f->getSymbols()) {
+      auto res = map.try_emplace(
+          {sym->isLocal() ? sourceFile : StringRef(), sym->getName()}, sym);
+      if (!res.second && res.first->second != sym)
+        res.first->second = nullptr;
+    }
+  }
+
+  // Symbols that are global in the input may have become local in the
+  // binary, e.g. because of hidden visibility, so fall back to global
+  // symbols. Sections that were garbage collected are ignored.
+  auto findSection = [&](uint64_t addr) -> InputSectionBase * {
+    auto it = llvm::upper_bound(
+        funcs, addr, [](uint64_t a, const FuncRange &f) { return a < f.start; });
+    if (it == funcs.begin())
+      return nullptr;
+    FuncRange &f = *std::prev(it);
+    if (f.size && addr - f.start >= f.size)
+      return nullptr;
+
+    // Cache lookups since a profile usually samples the same functions many
+    // times.
+    if (f.resolved)
+      return f.sec;
+    f.resolved = true;
+    auto mapIt = map.find({f.file, f.name});
+    if (mapIt == map.end() && !f.file.empty())
+      mapIt = map.find({StringRef(), f.name});
+    if (mapIt == map.end())
+      return nullptr;
+    if (Defined *dr = dyn_cast_or_null<Defined>(mapIt->second))
+      if (auto *sec = dyn_cast_or_null<InputSectionBase>(dr->section))
+        if (sec->repl->isLive())
+          f.sec = sec;
+    return f.sec;
+  };
+
+  auto parseAddr = [](StringRef s, uint64_t &addr) {
+    s.consume_front("0x");
+    return to_integer(s, addr, 16);
+  };
+
+  for (StringRef line : args::getLines(mb)) {
+    SmallVector<StringRef, 3> fields;
+    line.split(fields, ' ', -1, false);
+    uint64_t from, to, count;
+
+    if (fields.size() == 2 && parseAddr(fields[0], from) &&
+        to_integer(fields[1], count)) {
+      if (InputSectionBase *sec = findSection(from))
+        config->callGraphSamples[sec] += count;
+      continue;
+    }
+
+    if (fields.size() == 3 && parseAddr(fields[0], from) &&
+        parseAddr(fields[1], to) && to_integer(fields[2], count)) {
+      if (InputSectionBase *fromSec = findSection(from))
+        if (InputSectionBase *toSec = findSection(to))
+          config->callGraphProfile[std::make_pair(fromSec, toSec)] += count;
+      continue;
+    }
+
+    error(mb.getBufferIdentifier() + ": parse error");
+    return;
+  }
+}
+
 template <class ELFT> static void readCallGraphsFromObjectFiles() {
   for (auto file : objectFiles) {
     auto *obj = cast<ObjFile<ELFT>>(file);
@@ -775,15 +951,20 @@ template <class ELFT> static void readCallGraphsFromObjectFiles() {
   }
 }
 
-static bool getCompressDebugSections(opt::InputArgList &args) {
+static DebugCompressionKind getCompressDebugSections(opt::InputArgList &args) {
   StringRef s = args.getLastArgValue(OPT_compress_debug_sections, "none");
   if (s == "none")
-    return false;
+    return DebugCompressionKind::None;
+  if (s == "zstd") {
+    if (!zstd::isAvailable())
+      error("--compress-debug-sections: zstd is not available");
+    return DebugCompressionKind::Zstd;
+  }
   if (s != "zlib")
     error("unknown --compress-debug-sections value: " + s);
   if (!zlib::isAvailable())
     error("--compress-debug-sections: zlib is not available");
-  return true;
+  return DebugCompressionKind::Zlib;
 }
 
 static StringRef getAliasSpelling(opt::Arg *arg) {
@@ -885,6 +1066,7 @@ static void readConfigs(opt::InputArgList &args) {
       args.hasArg(OPT_ignore_data_address_equality);
   config->ignoreFunctionAddressEquality =
       args.hasArg(OPT_ignore_function_address_equality);
+  config->incremental = args.hasFlag(OPT_incremental, OPT_no_incremental, false);
   config->init = args.getLastArgValue(OPT_init, "_init");
   config->ltoAAPipeline = args.getLastArgValue(OPT_lto_aa_pipeline);
   config->ltoCSProfileGenerate = args.hasArg(OPT_lto_cs_profile_generate);
@@ -920,6 +1102,8 @@ static void readConfigs(opt::InputArgList &args) {
       args.hasFlag(OPT_print_icf_sections, OPT_no_print_icf_sections, false);
   config->printGcSections =
       args.hasFlag(OPT_print_gc_sections, OPT_no_print_gc_sections, false);
+  config->printArenaUsage =
+      args.hasFlag(OPT_print_arena_usage, OPT_no_print_arena_usage, false);
   config->printSymbolOrder =
       args.getLastArgValue(OPT_print_symbol_order);
   config->rpath = getRpath(args);
@@ -932,6 +1116,8 @@ static void readConfigs(opt::InputArgList &args) {
   config->soName = args.getLastArgValue(OPT_soname);
   config->sortSection = getSortSection(args);
   config->splitStackAdjustSize = args::getInteger(args, OPT_split_stack_adjust_size, 16384);
+  config->streamOutput =
+      args.hasFlag(OPT_stream_output, OPT_no_stream_output, false);
   config->strip = getStrip(args);
   config->sysroot = args.getLastArgValue(OPT_sysroot);
   config->target1Rel = args.hasFlag(OPT_target1_rel, OPT_target1_abs, false);
@@ -945,10 +1131,17 @@ static void readConfigs(opt::InputArgList &args) {
                              args.hasArg(OPT_thinlto_index_only_eq);
   config->thinLTOIndexOnlyArg = args.getLastArgValue(OPT_thinlto_index_only_eq);
   config->thinLTOJobs = args::getInteger(args, OPT_thinlto_jobs, -1u);
+  config->thinLTOMemoryLimit =
+      args::getInteger(args, OPT_thinlto_memory_limit, 0);
   config->thinLTOObjectSuffixReplace =
       getOldNewOptions(args, OPT_thinlto_object_suffix_replace_eq);
   config->thinLTOPrefixReplace =
       getOldNewOptions(args, OPT_thinlto_prefix_replace_eq);
+  config->timeTraceEnabled =
+      args.hasFlag(OPT_time_trace, OPT_no_time_trace, false);
+  config->timeTraceFile = args.getLastArgValue(OPT_time_trace_file);
+  config->timeTraceGranularity =
+      args::getInteger(args, OPT_time_trace_granularity, 500);
   config->trace = args.hasArg(OPT_trace);
   config->undefined = args::getStrings(args, OPT_undefined);
   config->undefinedVersion =
@@ -1005,6 +1198,8 @@ static void readConfigs(opt::InputArgList &args) {
     error("--lto-partitions: number of threads must be > 0");
   if (config->thinLTOJobs == 0)
     error("--thinlto-jobs: number of threads must be > 0");
+  if (config->thinLTOMemoryLimit < 0)
+    error("--thinlto-memory-limit: limit must be >= 0");
 
   if (config->splitStackAdjustSize < 0)
     error("--split-stack-adjust-size: size must be >= 0");
@@ -1050,6 +1245,9 @@ static void readConfigs(opt::InputArgList &args) {
     if (args.hasArg(OPT_call_graph_ordering_file))
       error("--symbol-ordering-file and --call-graph-order-file "
             "may not be used together");
+    if (args.hasArg(OPT_call_graph_samples))
+      error("--symbol-ordering-file and --call-graph-samples "
+            "may not be used together");
     if (Optional<MemoryBufferRef> buffer = readFile(arg->getValue())){
       config->symbolOrderingFile = getSymbolOrderingFile(*buffer);
       // Also need to disable CallGraphProfileSort to prevent
@@ -1162,6 +1360,19 @@ static bool isFormatBinary(StringRef s) {
 }
 
 void LinkerDriver::createFiles(opt::InputArgList &args) {
+  // Files are parsed one by one below. Open the input files up front and
+  // let a thread pool read them in, so that we don't wait for the disk on
+  // each of them in turn.
+  if (threadsEnabled) {
+    std::vector<StringRef> paths;
+    for (auto *arg : args.filtered(OPT_INPUT))
+      paths.push_back(arg->getValue());
+    if (paths.size() > 1) {
+      prefetchPool = std::make_unique<ThreadPool>();
+      prefetchFiles(paths, *prefetchPool);
+    }
+  }
+
   // For --{push,pop}-state.
   std::vector<std::tuple<bool, bool, bool>> stack;
 
@@ -1752,9 +1963,22 @@ template <class ELFT> void LinkerDriver::link(opt::InputArgList &args) {
   // symbols that we need to the symbol table. This process might
   // add files to the link, via autolinking, these files are always
   // appended to the Files vector.
+  //
+  // Symbol resolution must be done in command line order for the output
+  // to be deterministic, but reading symbol names and hashing them is
+  // not. We do that for all object files in parallel beforehand.
+  if (threadsEnabled)
+    parallelForEach(files, [](InputFile *file) {
+      if (file->kind() == InputFile::ObjKind && file->ekind == config->ekind)
+        cast<ObjFile<ELFT>>(file)->preParse();
+    });
+
   for (size_t i = 0; i < files.size(); ++i)
     parseFile(files[i]);
 
+  // Sample memory usage after each major phase.
+  samplePhaseMemory("parse input files");
+
   // Now that we have every file, we can decide if we will need a
   // dynamic symbol table.
   // We need one if we were asked to export dynamic symbols or if we are
@@ -1846,6 +2070,7 @@ template <class ELFT> void LinkerDriver::link(opt::InputArgList &args) {
   // With this the symbol table should be complete. After this, no new names
   // except a few linker-synthesized ones will be added to the symbol table.
   compileBitcodeFiles<ELFT>();
+  samplePhaseMemory("LTO");
   if (errorCount())
     return;
 
@@ -1938,6 +2163,7 @@ template <class ELFT> void LinkerDriver::link(opt::InputArgList &args) {
   // Garbage collection and removal of shared symbols from unused shared objects.
   markLive<ELFT>();
   demoteSharedSymbols();
+  samplePhaseMemory("garbage collection");
 
   // Make copies of any input sections that need to be copied into each
   // partition.
@@ -1983,11 +2209,21 @@ template <class ELFT> void LinkerDriver::link(opt::InputArgList &args) {
     if (auto *arg = args.getLastArg(OPT_call_graph_ordering_file))
       if (Optional<MemoryBufferRef> buffer = readFile(arg->getValue()))
         readCallGraph(*buffer);
+    if (auto *arg = args.getLastArg(OPT_call_graph_samples)) {
+      StringRef binary = args.getLastArgValue(OPT_call_graph_samples_binary,
+                                              config->outputFile);
+      if (Optional<MemoryBufferRef> buffer = readFile(arg->getValue()))
+        if (Optional<MemoryBufferRef> binBuffer = readFile(binary))
+          readCallGraphSamples<ELFT>(*buffer, *binBuffer);
+    }
     readCallGraphsFromObjectFiles<ELFT>();
   }
 
+  samplePhaseMemory("ICF and call graph");
+
   // Write the result to the file.
   writeResult<ELFT>();
+  samplePhaseMemory("write output");
 }
 
 } // namespace elf
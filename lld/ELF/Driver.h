@@ -17,6 +17,7 @@
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/StringSet.h"
 #include "llvm/Option/ArgList.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/raw_ostream.h"
 
 namespace lld {
@@ -45,6 +46,9 @@ private:
   // For LTO.
   std::unique_ptr<BitcodeCompiler> lto;
 
+  // Reads input files in the background while createFiles() parses them.
+  std::unique_ptr<llvm::ThreadPool> prefetchPool;
+
   std::vector<InputFile *> files;
 };
 
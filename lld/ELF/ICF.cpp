@@ -84,6 +84,7 @@
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/BinaryFormat/ELF.h"
 #include "llvm/Object/ELF.h"
+#include "llvm/Support/TimeProfiler.h"
 #include "llvm/Support/xxhash.h"
 #include <algorithm>
 #include <atomic>
@@ -125,6 +126,9 @@ private:
   // We repeat the main loop while `Repeat` is true.
   std::atomic<bool> repeat;
 
+  // The number of equivalence classes created by the last iteration.
+  std::atomic<size_t> numClasses{0};
+
   // The main loop counter.
   int cnt = 0;
 
@@ -221,6 +225,7 @@ void ICF<ELFT>::segregate(size_t begin, size_t end, bool constant) {
     // class ID because every group ends with a unique index.
     for (size_t i = begin; i < mid; ++i)
       sections[i]->eqClass[next] = mid;
+    ++numClasses;
 
     // If we created a group, we need to iterate the main loop again.
     if (mid != end)
@@ -445,6 +450,8 @@ static void print(const Twine &s) {
 
 // The main function of ICF.
 template <class ELFT> void ICF<ELFT>::run() {
+  llvm::TimeTraceScope timeScope("ICF", StringRef());
+
   // Collect sections to merge.
   for (InputSectionBase *sec : inputSections) {
     auto *s = cast<InputSection>(sec);
@@ -473,16 +480,26 @@ template <class ELFT> void ICF<ELFT>::run() {
   });
 
   // Compare static contents and assign unique IDs for each static content.
-  forEachClass([&](size_t begin, size_t end) { segregate(begin, end, true); });
+  {
+    llvm::TimeTraceScope timeScope("ICF constant pass", StringRef());
+    forEachClass(
+        [&](size_t begin, size_t end) { segregate(begin, end, true); });
+  }
 
   // Split groups by comparing relocations until convergence is obtained.
+  // The trace records the number of classes each iteration starts with.
   do {
+    llvm::TimeTraceScope timeScope("ICF iteration", [&] {
+      return (Twine(cnt) + ": " + Twine(numClasses) + " classes").str();
+    });
     repeat = false;
+    numClasses = 0;
     forEachClass(
         [&](size_t begin, size_t end) { segregate(begin, end, false); });
   } while (repeat);
 
-  log("ICF needed " + Twine(cnt) + " iterations");
+  log("ICF needed " + Twine(cnt) + " iterations and found " +
+      Twine(numClasses) + " classes");
 
   // Merge sections by the equivalence class.
   forEachClassRange(0, sections.size(), [&](size_t begin, size_t end) {
@@ -100,21 +100,50 @@ InputFile::InputFile(Kind k, MemoryBufferRef m)
     ++nextGroupId;
 }
 
-Optional<MemoryBufferRef> readFile(StringRef path) {
+// Files opened by prefetchFiles() that readFile() has not returned yet.
+static StringMap<std::unique_ptr<MemoryBuffer>> prefetchedFiles;
+
+static StringRef applyChroot(StringRef path) {
   // The --chroot option changes our virtual root directory.
   // This is useful when you are dealing with files created by --reproduce.
   if (!config->chroot.empty() && path.startswith("/"))
-    path = saver.save(config->chroot + path);
+    return saver.save(config->chroot + path);
+  return path;
+}
+
+void prefetchFiles(ArrayRef<StringRef> paths, ThreadPool &pool) {
+  std::vector<StringRef> realPaths;
+  for (StringRef path : paths)
+    realPaths.push_back(applyChroot(path));
 
+  std::vector<Expected<std::unique_ptr<MemoryBuffer>>> mbs =
+      MemoryBuffer::getFiles(realPaths, pool, /*RequiresNullTerminator=*/false);
+  for (size_t i = 0; i < mbs.size(); ++i) {
+    if (mbs[i])
+      prefetchedFiles[realPaths[i]] = std::move(*mbs[i]);
+    else
+      consumeError(mbs[i].takeError()); // readFile() reports the error.
+  }
+}
+
+Optional<MemoryBufferRef> readFile(StringRef path) {
+  path = applyChroot(path);
   log(path);
 
-  auto mbOrErr = MemoryBuffer::getFile(path, -1, false);
-  if (auto ec = mbOrErr.getError()) {
-    error("cannot open " + path + ": " + ec.message());
-    return None;
+  std::unique_ptr<MemoryBuffer> mb;
+  auto it = prefetchedFiles.find(path);
+  if (it != prefetchedFiles.end()) {
+    mb = std::move(it->second);
+    prefetchedFiles.erase(it);
+  } else {
+    auto mbOrErr = MemoryBuffer::getFile(path, -1, false);
+    if (auto ec = mbOrErr.getError()) {
+      error("cannot open " + path + ": " + ec.message());
+      return None;
+    }
+    mb = std::move(*mbOrErr);
   }
 
-  std::unique_ptr<MemoryBuffer> &mb = *mbOrErr;
   MemoryBufferRef mbref = mb->getMemBufferRef();
   make<std::unique_ptr<MemoryBuffer>>(std::move(mb)); // take MB ownership
 
@@ -390,6 +419,30 @@ template <class ELFT> void ObjFile<ELFT>::parse(bool ignoreComdats) {
   initializeSymbols();
 }
 
+template <class ELFT> void ObjFile<ELFT>::preParse() {
+  // Reading symbol names and hashing them is a large part of the cost of
+  // symbol resolution, and it is independent of other files. Compute the
+  // keys here so that initializeSymbols() only needs to do hash table
+  // lookups. If the file is broken, we give up and let parse() report it.
+  ArrayRef<Elf_Sym> eSyms = this->getGlobalELFSyms<ELFT>();
+  std::vector<CachedHashStringRef> keys;
+  keys.reserve(eSyms.size());
+
+  for (const Elf_Sym &eSym : eSyms) {
+    if (eSym.getBinding() == STB_LOCAL) {
+      keys.push_back(CachedHashStringRef("", 0));
+      continue;
+    }
+    Expected<StringRef> nameOrErr = eSym.getName(this->stringTable);
+    if (!nameOrErr) {
+      consumeError(nameOrErr.takeError());
+      return;
+    }
+    keys.push_back(SymbolTable::getKey(*nameOrErr));
+  }
+  globalKeys = std::move(keys);
+}
+
 // Sections with SHT_GROUP and comdat bits define comdat section groups.
 // They are identified and deduplicated by group name. This function
 // returns a group name.
@@ -985,10 +1038,17 @@ template <class ELFT> void ObjFile<ELFT>::initializeSymbols() {
 
   // Our symbol table may have already been partially initialized
   // because of LazyObjFile.
-  for (size_t i = 0, end = eSyms.size(); i != end; ++i)
-    if (!this->symbols[i] && eSyms[i].getBinding() != STB_LOCAL)
+  for (size_t i = 0, end = eSyms.size(); i != end; ++i) {
+    if (this->symbols[i] || eSyms[i].getBinding() == STB_LOCAL)
+      continue;
+    if (!globalKeys.empty() && i >= this->firstGlobal)
+      this->symbols[i] = symtab->insert(globalKeys[i - this->firstGlobal]);
+    else
       this->symbols[i] =
           symtab->insert(CHECK(eSyms[i].getName(this->stringTable), this));
+  }
+  globalKeys.clear();
+  globalKeys.shrink_to_fit();
 
   // Fill this->Symbols. A symbol is either local or global.
   for (size_t i = 0, end = eSyms.size(); i != end; ++i) {
@@ -26,6 +26,7 @@
 
 namespace llvm {
 class TarWriter;
+class ThreadPool;
 namespace lto {
 class InputFile;
 }
@@ -51,6 +52,10 @@ extern std::unique_ptr<llvm::TarWriter> tar;
 // Opens a given file.
 llvm::Optional<MemoryBufferRef> readFile(StringRef path);
 
+// Opens the given files using a thread pool and keeps reading them in in the
+// background. readFile() then returns the already opened buffers.
+void prefetchFiles(ArrayRef<StringRef> paths, llvm::ThreadPool &pool);
+
 // Add symbols in File to the symbol table.
 void parseFile(InputFile *file);
 
@@ -204,6 +209,11 @@ public:
 
   void parse(bool ignoreComdats = false);
 
+  // Does the part of parse() that depends only on this file. Unlike
+  // parse(), this function doesn't touch any global state, so it is safe
+  // to call it for multiple files concurrently.
+  void preParse();
+
   StringRef getShtGroupSignature(ArrayRef<Elf_Shdr> sections,
                                  const Elf_Shdr &sec);
 
@@ -277,6 +287,11 @@ private:
   // .shstrtab contents.
   StringRef sectionStringTable;
 
+  // Symbol table keys of global symbols computed by preParse(). The Nth
+  // element corresponds to the (firstGlobal + N)th ELF symbol. Empty if
+  // preParse() was not called.
+  std::vector<llvm::CachedHashStringRef> globalKeys;
+
   // Debugging information to retrieve source file and line for error
   // reporting. Linker may find reasonable number of errors in a
   // single object file, so we cache debugging information in order to
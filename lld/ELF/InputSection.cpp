@@ -30,6 +30,10 @@
 #include <set>
 #include <vector>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 using namespace llvm;
 using namespace llvm::ELF;
 using namespace llvm::object;
@@ -78,15 +82,15 @@ InputSectionBase::InputSectionBase(InputFile *file, uint64_t flags,
     fatal(toString(this) + ": sh_addralign is not a power of 2");
   this->alignment = v;
 
-  // In ELF, each section can be compressed by zlib, and if compressed,
-  // section name may be mangled by appending "z" (e.g. ".zdebug_info").
-  // If that's the case, demangle section name so that we can handle a
-  // section as if it weren't compressed.
+  // In ELF, each section can be compressed by zlib or zstd, and if
+  // compressed, section name may be mangled by appending "z" (e.g.
+  // ".zdebug_info"). If that's the case, demangle section name so that we can
+  // handle a section as if it weren't compressed.
   if ((flags & SHF_COMPRESSED) || name.startswith(".zdebug")) {
-    if (!zlib::isAvailable())
-      error(toString(file) + ": contains a compressed section, " +
-            "but zlib is not available");
     parseCompressedHeader();
+    if (uncompressedSize >= 0 && !compression::isAvailable(getCompression()))
+      error(toString(file) + ": contains a compressed section, but " +
+            compression::getName(getCompression()) + " is not available");
   }
 }
 
@@ -150,7 +154,8 @@ void InputSectionBase::uncompress() const {
     uncompressedBuf = bAlloc.Allocate<char>(size);
   }
 
-  if (Error e = zlib::uncompress(toStringRef(rawData), uncompressedBuf, size))
+  if (Error e = compression::uncompress(getCompression(), toStringRef(rawData),
+                                       uncompressedBuf, size))
     fatal(toString(this) +
           ": uncompress failed: " + llvm::toString(std::move(e)));
   rawData = makeArrayRef((uint8_t *)uncompressedBuf, size);
@@ -206,7 +211,7 @@ OutputSection *SectionBase::getOutputSection() {
 }
 
 // When a section is compressed, `rawData` consists with a header followed
-// by zlib-compressed data. This function parses a header to initialize
+// by zlib- or zstd-compressed data. This function parses a header to initialize
 // `uncompressedSize` member and remove the header from `rawData`.
 void InputSectionBase::parseCompressedHeader() {
   using Chdr64 = typename ELF64LE::Chdr;
@@ -245,11 +250,13 @@ void InputSectionBase::parseCompressedHeader() {
     }
 
     auto *hdr = reinterpret_cast<const Chdr64 *>(rawData.data());
-    if (hdr->ch_type != ELFCOMPRESS_ZLIB) {
+    if (hdr->ch_type != ELFCOMPRESS_ZLIB && hdr->ch_type != ELFCOMPRESS_ZSTD) {
       error(toString(this) + ": unsupported compression type");
       return;
     }
 
+    zstdCompressed = hdr->ch_type == ELFCOMPRESS_ZSTD;
+
     uncompressedSize = hdr->ch_size;
     alignment = std::max<uint32_t>(hdr->ch_addralign, 1);
     rawData = rawData.slice(sizeof(*hdr));
@@ -263,11 +270,13 @@ void InputSectionBase::parseCompressedHeader() {
   }
 
   auto *hdr = reinterpret_cast<const Chdr32 *>(rawData.data());
-  if (hdr->ch_type != ELFCOMPRESS_ZLIB) {
+  if (hdr->ch_type != ELFCOMPRESS_ZLIB && hdr->ch_type != ELFCOMPRESS_ZSTD) {
     error(toString(this) + ": unsupported compression type");
     return;
   }
 
+  zstdCompressed = hdr->ch_type == ELFCOMPRESS_ZSTD;
+
   uncompressedSize = hdr->ch_size;
   alignment = std::max<uint32_t>(hdr->ch_addralign, 1);
   rawData = rawData.slice(sizeof(*hdr));
@@ -1121,8 +1130,9 @@ template <class ELFT> void InputSection::writeTo(uint8_t *buf) {
   // to the buffer.
   if (uncompressedSize >= 0) {
     size_t size = uncompressedSize;
-    if (Error e = zlib::uncompress(toStringRef(rawData),
-                                   (char *)(buf + outSecOff), size))
+    if (Error e = compression::uncompress(getCompression(),
+                                          toStringRef(rawData),
+                                          (char *)(buf + outSecOff), size))
       fatal(toString(this) +
             ": uncompress failed: " + llvm::toString(std::move(e)));
     uint8_t *bufEnd = buf + outSecOff + size;
@@ -1206,11 +1216,28 @@ void EhInputSection::split(ArrayRef<RelTy> rels) {
 }
 
 static size_t findNull(StringRef s, size_t entSize) {
-  // Optimize the common case.
+  // Optimize the common case. find() uses memchr, which is vectorized.
   if (entSize == 1)
     return s.find(0);
 
-  for (unsigned i = 0, n = s.size(); i != n; i += entSize) {
+  size_t i = 0;
+  size_t n = s.size();
+
+  // For UTF-16 and UTF-32 strings, skip eight bytes at a time as long as
+  // they contain no null character. A lane of v is zero if and only if
+  // subtracting one from it borrows from its most significant bit while
+  // that bit was clear.
+  if (entSize == 2 || entSize == 4) {
+    uint64_t ones = (entSize == 2) ? 0x0001000100010001 : 0x0000000100000001;
+    uint64_t highs = ones << (entSize * 8 - 1);
+    for (; i + 8 <= n; i += 8) {
+      uint64_t v = read64le(s.data() + i);
+      if ((v - ones) & ~v & highs)
+        break;
+    }
+  }
+
+  for (; i + entSize <= n; i += entSize) {
     const char *b = s.begin() + i;
     if (std::all_of(b, b + entSize, [](char c) { return c == 0; }))
       return i;
@@ -1229,13 +1256,33 @@ void MergeInputSection::splitStrings(ArrayRef<uint8_t> data, size_t entSize) {
   bool isAlloc = flags & SHF_ALLOC;
   StringRef s = toStringRef(data);
 
+#ifdef __SSE2__
+  // Sections such as .debug_str consist of many short strings. Rather than
+  // calling memchr() for each of them, find the null bytes of 16 bytes at a
+  // time and split at each of them.
+  if (entSize == 1) {
+    const __m128i zero = _mm_setzero_si128();
+    for (size_t i = 0; i + 16 <= s.size(); i += 16) {
+      __m128i v =
+          _mm_loadu_si128(reinterpret_cast<const __m128i *>(s.data() + i));
+      for (uint32_t mask = _mm_movemask_epi8(_mm_cmpeq_epi8(v, zero)); mask;
+           mask &= mask - 1) {
+        size_t end = i + countTrailingZeros(mask) + 1;
+        pieces.emplace_back(off, xxh3_64bits(s.slice(off, end)), !isAlloc);
+        off = end;
+      }
+    }
+    s = s.substr(off);
+  }
+#endif
+
   while (!s.empty()) {
     size_t end = findNull(s, entSize);
     if (end == StringRef::npos)
       fatal(toString(this) + ": string is not null terminated");
     size_t size = end + entSize;
 
-    pieces.emplace_back(off, xxHash64(s.substr(0, size)), !isAlloc);
+    pieces.emplace_back(off, xxh3_64bits(s.substr(0, size)), !isAlloc);
     s = s.substr(size);
     off += size;
   }
@@ -1250,7 +1297,7 @@ void MergeInputSection::splitNonStrings(ArrayRef<uint8_t> data,
   bool isAlloc = flags & SHF_ALLOC;
 
   for (size_t i = 0; i != size; i += entSize)
-    pieces.emplace_back(i, xxHash64(data.slice(i, entSize)), !isAlloc);
+    pieces.emplace_back(i, xxh3_64bits(data.slice(i, entSize)), !isAlloc);
 }
 
 template <class ELFT>
@@ -17,6 +17,7 @@
 #include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/TinyPtrVector.h"
 #include "llvm/Object/ELF.h"
+#include "llvm/Support/Compression.h"
 
 namespace lld {
 namespace elf {
@@ -54,7 +55,7 @@ public:
 
   unsigned sectionKind : 3;
 
-  // The next two bit fields are only used by InputSectionBase, but we
+  // The next three bit fields are only used by InputSectionBase, but we
   // put them here so the struct packs better.
 
   unsigned bss : 1;
@@ -62,6 +63,9 @@ public:
   // Set for sections that should not be folded by ICF.
   unsigned keepUnique : 1;
 
+  // Set if the compressed contents in rawData are zstd rather than zlib.
+  unsigned zstdCompressed : 1;
+
   // The 1-indexed partition that this section is assigned to by the garbage
   // collector, or 0 if this section is dead. Normally there is only one
   // partition, so this will either be 0 or 1.
@@ -96,7 +100,8 @@ protected:
               uint64_t entsize, uint64_t alignment, uint32_t type,
               uint32_t info, uint32_t link)
       : name(name), repl(this), sectionKind(sectionKind), bss(false),
-        keepUnique(false), partition(0), alignment(alignment), flags(flags),
+        keepUnique(false), zstdCompressed(false), partition(0),
+        alignment(alignment), flags(flags),
         entsize(entsize), type(type), link(link), info(info) {}
 };
 
@@ -204,6 +209,11 @@ protected:
   void parseCompressedHeader();
   void uncompress() const;
 
+  llvm::compression::Format getCompression() const {
+    return zstdCompressed ? llvm::compression::Format::Zstd
+                          : llvm::compression::Format::Zlib;
+  }
+
   mutable ArrayRef<uint8_t> rawData;
 
   // This field stores the uncompressed size of the compressed data in rawData,
@@ -31,6 +31,7 @@
 #include "llvm/Support/Error.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Threading.h"
 #include <algorithm>
 #include <cstddef>
 #include <memory>
@@ -137,8 +138,12 @@ BitcodeCompiler::BitcodeCompiler() {
     backend = lto::createWriteIndexesThinBackend(
         config->thinLTOPrefixReplace.first, config->thinLTOPrefixReplace.second,
         config->thinLTOEmitImportsFiles, indexFile.get(), onIndexWrite);
-  } else if (config->thinLTOJobs != -1U) {
-    backend = lto::createInProcessThinBackend(config->thinLTOJobs);
+  } else if (config->thinLTOJobs != -1U || config->thinLTOMemoryLimit) {
+    unsigned jobs = config->thinLTOJobs != -1U
+                        ? config->thinLTOJobs
+                        : llvm::heavyweight_hardware_concurrency();
+    backend = lto::createInProcessThinBackend(
+        jobs, uint64_t(config->thinLTOMemoryLimit) << 20);
   }
 
   ltoObj = std::make_unique<lto::LTO>(createConfig(), backend,
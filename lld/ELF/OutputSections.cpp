@@ -258,21 +258,29 @@ template <class ELFT> void OutputSection::maybeCompress() {
   using Elf_Chdr = typename ELFT::Chdr;
 
   // Compress only DWARF debug sections.
-  if (!config->compressDebugSections || (flags & SHF_ALLOC) ||
-      !name.startswith(".debug_"))
+  if (config->compressDebugSections == DebugCompressionKind::None ||
+      (flags & SHF_ALLOC) || !name.startswith(".debug_"))
     return;
 
+  bool useZstd = config->compressDebugSections == DebugCompressionKind::Zstd;
+
   // Create a section header.
   zDebugHeader.resize(sizeof(Elf_Chdr));
   auto *hdr = reinterpret_cast<Elf_Chdr *>(zDebugHeader.data());
-  hdr->ch_type = ELFCOMPRESS_ZLIB;
+  hdr->ch_type = useZstd ? ELFCOMPRESS_ZSTD : ELFCOMPRESS_ZLIB;
   hdr->ch_size = size;
   hdr->ch_addralign = alignment;
 
-  // Write section contents to a temporary buffer and compress it.
+  // Write section contents to a temporary buffer and compress it. Large
+  // sections are compressed in independent chunks, on all threads unless
+  // --no-threads is given. The chunking does not depend on the number of
+  // threads, so neither does the output.
   std::vector<uint8_t> buf(size);
   writeTo<ELFT>(buf.data());
-  if (Error e = zlib::compress(toStringRef(buf), compressedData))
+  compression::Format format =
+      useZstd ? compression::Format::Zstd : compression::Format::Zlib;
+  if (Error e = compression::compressParallel(format, toStringRef(buf),
+                                              compressedData, threadsEnabled))
     fatal("compress failed: " + llvm::toString(std::move(e)));
 
   // Update section headers.
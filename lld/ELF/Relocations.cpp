@@ -52,6 +52,7 @@
 #include "lld/Common/ErrorHandler.h"
 #include "lld/Common/Memory.h"
 #include "lld/Common/Strings.h"
+#include "lld/Common/Threads.h"
 #include "llvm/ADT/SmallSet.h"
 #include "llvm/Support/Endian.h"
 #include "llvm/Support/raw_ostream.h"
@@ -1161,34 +1162,83 @@ static void processRelocAux(InputSectionBase &sec, RelExpr expr, RelType type,
               getLocation(sec, sym, offset));
 }
 
+namespace {
+// The part of the information about a relocation that can be computed
+// without side effects. scanReloc() needs it first, and because it doesn't
+// depend on the order in which relocations are visited, we can compute it
+// for many sections in parallel. See scanRelocations().
+struct PreScannedReloc {
+  uint64_t offset;
+  int64_t addend;
+  RelExpr expr;
+  RelType type;
+  uint32_t symIndex;
+  // If true, expr and addend were not computed, and scanReloc() has to.
+  bool deferred;
+};
+} // namespace
+
+// If errors is null, only the relocation type and offset are computed.
 template <class ELFT, class RelTy>
-static void scanReloc(InputSectionBase &sec, OffsetGetter &getOffset, RelTy *&i,
-                      RelTy *end) {
+static PreScannedReloc preScanReloc(InputSectionBase &sec,
+                                    OffsetGetter &getOffset, RelTy *&i,
+                                    RelTy *end, ErrorSuppressor *errors) {
   const RelTy &rel = *i;
-  uint32_t symIndex = rel.getSymbol(config->isMips64EL);
-  Symbol &sym = sec.getFile<ELFT>()->getSymbol(symIndex);
-  RelType type;
+  PreScannedReloc r;
+  r.symIndex = rel.getSymbol(config->isMips64EL);
+  r.deferred = true;
 
   // Deal with MIPS oddity.
   if (config->mipsN32Abi) {
-    type = getMipsN32RelType(i, end);
+    r.type = getMipsN32RelType(i, end);
   } else {
-    type = rel.getType(config->isMips64EL);
+    r.type = rel.getType(config->isMips64EL);
     ++i;
   }
 
   // Get an offset in an output section this relocation is applied to.
-  uint64_t offset = getOffset.get(rel.r_offset);
-  if (offset == uint64_t(-1))
+  r.offset = getOffset.get(rel.r_offset);
+  if (r.offset == uint64_t(-1) || !errors)
+    return r;
+
+  // getRelExpr() reports unknown relocation types. Here, such errors would
+  // come out in a nondeterministic order, even for relocations that
+  // scanReloc() skips because of an undefined symbol. So if there are any,
+  // we leave the relocation to scanReloc(), which reports them again in
+  // order.
+  uint64_t numErrors = errors->getCount();
+  Symbol &sym = sec.getFile<ELFT>()->getSymbol(r.symIndex);
+  const uint8_t *relocatedAddr = sec.data().begin() + rel.r_offset;
+  r.expr = target->getRelExpr(r.type, sym, relocatedAddr);
+
+  // Read an addend. "Hint" relocations are ignored by scanReloc().
+  if (oneof<R_HINT, R_NONE>(r.expr))
+    r.addend = 0;
+  else
+    r.addend = computeAddend<ELFT>(rel, end, sec, r.expr, sym.isLocal());
+  r.deferred = errors->getCount() != numErrors;
+  return r;
+}
+
+template <class ELFT, class RelTy>
+static void scanReloc(InputSectionBase &sec, RelTy &rel,
+                      const PreScannedReloc &r, RelTy *&i, RelTy *end) {
+  if (r.offset == uint64_t(-1))
     return;
 
+  uint32_t symIndex = r.symIndex;
+  Symbol &sym = sec.getFile<ELFT>()->getSymbol(symIndex);
+  RelType type = r.type;
+  uint64_t offset = r.offset;
+
   // Error if the target symbol is undefined. Symbol index 0 may be used by
   // marker relocations, e.g. R_*_NONE and R_ARM_V4BX. Don't error on them.
   if (symIndex != 0 && maybeReportUndefined(sym, sec, rel.r_offset))
     return;
 
   const uint8_t *relocatedAddr = sec.data().begin() + rel.r_offset;
-  RelExpr expr = target->getRelExpr(type, sym, relocatedAddr);
+  RelExpr expr =
+      r.deferred ? target->getRelExpr(type, sym, relocatedAddr) : r.expr;
 
   // Ignore "hint" relocations because they are only markers for relaxation.
   if (oneof<R_HINT, R_NONE>(expr))
@@ -1216,7 +1266,9 @@ static void scanReloc(InputSectionBase &sec, OffsetGetter &getOffset, RelTy *&i,
   }
 
   // Read an addend.
-  int64_t addend = computeAddend<ELFT>(rel, end, sec, expr, sym.isLocal());
+  int64_t addend =
+      r.deferred ? computeAddend<ELFT>(rel, end, sec, expr, sym.isLocal())
+                 : r.addend;
 
   // Relax relocations.
   //
@@ -1385,14 +1437,43 @@ static void scanReloc(InputSectionBase &sec, OffsetGetter &getOffset, RelTy *&i,
 }
 
 template <class ELFT, class RelTy>
-static void scanRelocs(InputSectionBase &sec, ArrayRef<RelTy> rels) {
+static std::vector<PreScannedReloc> preScanRelocs(InputSectionBase &sec,
+                                                  ArrayRef<RelTy> rels) {
+  OffsetGetter getOffset(sec);
+  ErrorSuppressor errors;
+  std::vector<PreScannedReloc> ret;
+  ret.reserve(rels.size());
+  for (auto i = rels.begin(), end = rels.end(); i != end;)
+    ret.push_back(preScanReloc<ELFT>(sec, getOffset, i, end, &errors));
+  return ret;
+}
+
+template <class ELFT>
+static std::vector<PreScannedReloc> preScanRelocations(InputSectionBase &s) {
+  if (s.areRelocsRela)
+    return preScanRelocs<ELFT>(s, s.relas<ELFT>());
+  return preScanRelocs<ELFT>(s, s.rels<ELFT>());
+}
+
+// If Pre is not empty, it contains results of preScanRelocs() for Rels.
+template <class ELFT, class RelTy>
+static void scanRelocs(InputSectionBase &sec, ArrayRef<RelTy> rels,
+                       ArrayRef<PreScannedReloc> pre) {
   OffsetGetter getOffset(sec);
 
   // Not all relocations end up in Sec.Relocations, but a lot do.
   sec.relocations.reserve(rels.size());
 
-  for (auto i = rels.begin(), end = rels.end(); i != end;)
-    scanReloc<ELFT>(sec, getOffset, i, end);
+  for (auto i = rels.begin(), end = rels.end(); i != end;) {
+    const RelTy &rel = *i;
+    if (pre.empty()) {
+      PreScannedReloc r = preScanReloc<ELFT>(sec, getOffset, i, end, nullptr);
+      scanReloc<ELFT>(sec, rel, r, i, end);
+    } else {
+      size_t idx = i++ - rels.begin();
+      scanReloc<ELFT>(sec, rel, pre[idx], i, end);
+    }
+  }
 
   // Sort relocations by offset for more efficient searching for
   // R_RISCV_PCREL_HI20 and R_PPC64_ADDR64.
@@ -1404,11 +1485,55 @@ static void scanRelocs(InputSectionBase &sec, ArrayRef<RelTy> rels) {
                       });
 }
 
-template <class ELFT> void scanRelocations(InputSectionBase &s) {
+template <class ELFT>
+static void scanRelocations(InputSectionBase &s,
+                            ArrayRef<PreScannedReloc> pre) {
   if (s.areRelocsRela)
-    scanRelocs<ELFT>(s, s.relas<ELFT>());
+    scanRelocs<ELFT>(s, s.relas<ELFT>(), pre);
   else
-    scanRelocs<ELFT>(s, s.rels<ELFT>());
+    scanRelocs<ELFT>(s, s.rels<ELFT>(), pre);
+}
+
+template <class ELFT> void scanRelocations(InputSectionBase &s) {
+  scanRelocations<ELFT>(s, {});
+}
+
+template <class ELFT>
+void scanRelocations(ArrayRef<InputSectionBase *> sections) {
+  // MIPS N32 combines consecutive relocations into one, so relocations and
+  // pre-scanned relocations don't correspond one-to-one. We don't bother to
+  // handle that.
+  if (!threadsEnabled || config->emachine == EM_MIPS) {
+    for (InputSectionBase *sec : sections)
+      scanRelocations<ELFT>(*sec);
+    return;
+  }
+
+  // Scanning relocations creates GOT and PLT entries, dynamic relocations,
+  // etc., so it has to be done in a fixed order for the output to be
+  // deterministic. However, the first half of it (reading relocations and
+  // classifying them) is free of side effects. We do that part for a batch
+  // of sections in parallel and then feed the results to the second half
+  // sequentially in the original order. The output is therefore identical
+  // to what we would get with a single thread. Batches are bounded by the
+  // number of relocations to limit the memory used for pre-scanned results.
+  const size_t maxBatchRelocs = 1 << 20;
+  std::vector<std::vector<PreScannedReloc>> pre;
+
+  for (size_t begin = 0, end = 0; begin < sections.size(); begin = end) {
+    size_t numRelocs = 0;
+    while (end < sections.size() && numRelocs < maxBatchRelocs)
+      numRelocs += sections[end++]->numRelocations;
+
+    ArrayRef<InputSectionBase *> batch = sections.slice(begin, end - begin);
+    pre.clear();
+    pre.resize(batch.size());
+    parallelForEachN(0, batch.size(), [&](size_t i) {
+      pre[i] = preScanRelocations<ELFT>(*batch[i]);
+    });
+    for (size_t i = 0, e = batch.size(); i != e; ++i)
+      scanRelocations<ELFT>(*batch[i], pre[i]);
+  }
 }
 
 static bool mergeCmp(const InputSection *a, const InputSection *b) {
@@ -1835,6 +1960,10 @@ template void scanRelocations<ELF32LE>(InputSectionBase &);
 template void scanRelocations<ELF32BE>(InputSectionBase &);
 template void scanRelocations<ELF64LE>(InputSectionBase &);
 template void scanRelocations<ELF64BE>(InputSectionBase &);
+template void scanRelocations<ELF32LE>(ArrayRef<InputSectionBase *>);
+template void scanRelocations<ELF32BE>(ArrayRef<InputSectionBase *>);
+template void scanRelocations<ELF64LE>(ArrayRef<InputSectionBase *>);
+template void scanRelocations<ELF64BE>(ArrayRef<InputSectionBase *>);
 template void reportUndefinedSymbols<ELF32LE>();
 template void reportUndefinedSymbols<ELF32BE>();
 template void reportUndefinedSymbols<ELF64LE>();
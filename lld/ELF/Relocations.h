@@ -113,6 +113,10 @@ struct Relocation {
 // the diagnostics.
 template <class ELFT> void scanRelocations(InputSectionBase &);
 
+// Same as calling the above function for each section in order, but uses
+// multiple threads if available.
+template <class ELFT> void scanRelocations(ArrayRef<InputSectionBase *>);
+
 template <class ELFT> void reportUndefinedSymbols();
 
 void addIRelativeRelocs();
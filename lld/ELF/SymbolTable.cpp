@@ -33,9 +33,9 @@ SymbolTable *symtab;
 
 void SymbolTable::wrap(Symbol *sym, Symbol *real, Symbol *wrap) {
   // Swap symbols as instructed by -wrap.
-  int &idx1 = symMap[CachedHashStringRef(sym->getName())];
-  int &idx2 = symMap[CachedHashStringRef(real->getName())];
-  int &idx3 = symMap[CachedHashStringRef(wrap->getName())];
+  int &idx1 = symMap[sym->getName()];
+  int &idx2 = symMap[real->getName()];
+  int &idx3 = symMap[wrap->getName()];
 
   idx2 = idx1;
   idx1 = idx3;
@@ -48,8 +48,13 @@ void SymbolTable::wrap(Symbol *sym, Symbol *real, Symbol *wrap) {
   real->setName(s);
 }
 
-// Find an existing symbol or create a new one.
-Symbol *SymbolTable::insert(StringRef name) {
+// Keys carry the hash that symMap uses, so that a name hashed once, possibly
+// on another thread by getKey(), is not hashed again on insertion.
+static CachedHashStringRef makeKey(StringRef name) {
+  return CachedHashStringRef(name, FlatStringMap<int>::hash(name));
+}
+
+CachedHashStringRef SymbolTable::getKey(StringRef name) {
   // <name>@@<version> means the symbol is the default version. In that
   // case <name>@@<version> will be used to resolve references to <name>.
   //
@@ -59,8 +64,13 @@ Symbol *SymbolTable::insert(StringRef name) {
   size_t pos = name.find('@');
   if (pos != StringRef::npos && pos + 1 < name.size() && name[pos + 1] == '@')
     name = name.take_front(pos);
+  return makeKey(name);
+}
 
-  auto p = symMap.insert({CachedHashStringRef(name), (int)symVector.size()});
+// Find an existing symbol or create a new one.
+Symbol *SymbolTable::insert(CachedHashStringRef key) {
+  StringRef name = key.val();
+  auto p = symMap.try_emplace_hash(name, key.hash(), (int)symVector.size());
   int &symIndex = p.first->second;
   bool isNew = p.second;
 
@@ -94,7 +104,7 @@ Symbol *SymbolTable::addSymbol(const Symbol &newSym) {
 }
 
 Symbol *SymbolTable::find(StringRef name) {
-  auto it = symMap.find(CachedHashStringRef(name));
+  auto it = symMap.find(name, makeKey(name).hash());
   if (it == symMap.end())
     return nullptr;
   Symbol *sym = symVector[it->second];
@@ -14,6 +14,7 @@
 #include "lld/Common/Strings.h"
 #include "llvm/ADT/CachedHashString.h"
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/FlatStringMap.h"
 #include "llvm/ADT/STLExtras.h"
 
 namespace lld {
@@ -41,7 +42,13 @@ public:
         fn(sym);
   }
 
-  Symbol *insert(StringRef name);
+  // Returns the key under which a symbol of a given name is stored. The key
+  // carries the hash used by the symbol map, so insert() doesn't rehash it.
+  // This function is thread-safe.
+  static llvm::CachedHashStringRef getKey(StringRef name);
+
+  Symbol *insert(StringRef name) { return insert(getKey(name)); }
+  Symbol *insert(llvm::CachedHashStringRef key);
 
   Symbol *addSymbol(const Symbol &newSym);
 
@@ -73,9 +80,13 @@ private:
   // The default hashing of StringRef produces different results on 32 and 64
   // bit systems so we use a map to a vector. That is arbitrary, deterministic
   // but a bit inefficient.
-  // FIXME: Experiment with passing in a custom hashing or sorting the symbols
-  // once symbol resolution is finished.
-  llvm::DenseMap<llvm::CachedHashStringRef, int> symMap;
+  //
+  // This is the hottest map in the linker. FlatStringMap keeps short names
+  // inline next to their indices, so most lookups read one group of control
+  // bytes and one entry, without chasing a pointer to the key. Longer names
+  // are not copied: like the symbols, the map refers to the names kept alive
+  // by the input files and the string saver.
+  llvm::FlatStringMap<int, llvm::FlatStringMapUnownedKeys> symMap;
   std::vector<Symbol *> symVector;
 
   // A map from demangled symbol names to their symbol objects.
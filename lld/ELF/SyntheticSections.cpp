@@ -2620,41 +2620,48 @@ readPubNamesAndTypes(const LLDDwarfObj<ELFT> &obj,
   return ret;
 }
 
-// Create a list of symbols from a given list of symbol names and types
-// by uniquifying them by name.
-static std::vector<GdbIndexSection::GdbSymbol>
-createSymbols(ArrayRef<std::vector<GdbIndexSection::NameAttrEntry>> nameAttrs,
-              const std::vector<GdbIndexSection::GdbChunk> &chunks) {
+namespace {
+// Creates a list of symbols from lists of symbol names and types by
+// uniquifying them by name. Names are added in batches of input files so
+// that the names of all files don't have to be kept in memory at once.
+class GdbSymbolBuilder {
   using GdbSymbol = GdbIndexSection::GdbSymbol;
   using NameAttrEntry = GdbIndexSection::NameAttrEntry;
 
-  // For each chunk, compute the number of compilation units preceding it.
-  uint32_t cuIdx = 0;
-  std::vector<uint32_t> cuIdxs(chunks.size());
-  for (uint32_t i = 0, e = chunks.size(); i != e; ++i) {
-    cuIdxs[i] = cuIdx;
-    cuIdx += chunks[i].compilationUnits.size();
+public:
+  GdbSymbolBuilder() : map(numShards), symbols(numShards) {
+    if (threadsEnabled)
+      concurrency =
+          std::min<size_t>(PowerOf2Floor(hardware_concurrency()), numShards);
   }
 
-  // The number of symbols we will handle in this function is of the order
-  // of millions for very large executables, so we use multi-threading to
-  // speed it up.
-  size_t numShards = 32;
+  // Adds names read from consecutive input files. cuIdxs[i] is the number
+  // of compilation units preceding the file of nameAttrs[i].
+  void add(ArrayRef<std::vector<NameAttrEntry>> nameAttrs,
+           ArrayRef<uint32_t> cuIdxs);
+
+  std::vector<GdbSymbol> finish();
+
+private:
+  // The number of symbols we will handle is of the order of millions for
+  // very large executables, so we use multi-threading to speed it up.
+  const size_t numShards = 32;
   size_t concurrency = 1;
-  if (threadsEnabled)
-    concurrency =
-        std::min<size_t>(PowerOf2Floor(hardware_concurrency()), numShards);
 
   // A sharded map to uniquify symbols by name.
-  std::vector<DenseMap<CachedHashStringRef, size_t>> map(numShards);
+  std::vector<DenseMap<CachedHashStringRef, size_t>> map;
+  std::vector<std::vector<GdbSymbol>> symbols;
+};
+} // namespace
+
+void GdbSymbolBuilder::add(ArrayRef<std::vector<NameAttrEntry>> nameAttrs,
+                           ArrayRef<uint32_t> cuIdxs) {
   size_t shift = 32 - countTrailingZeros(numShards);
 
   // Instantiate GdbSymbols while uniqufying them by name.
-  std::vector<std::vector<GdbSymbol>> symbols(numShards);
   parallelForEachN(0, concurrency, [&](size_t threadId) {
-    uint32_t i = 0;
-    for (ArrayRef<NameAttrEntry> entries : nameAttrs) {
-      for (const NameAttrEntry &ent : entries) {
+    for (size_t i = 0, e = nameAttrs.size(); i != e; ++i) {
+      for (const NameAttrEntry &ent : nameAttrs[i]) {
         size_t shardId = ent.name.hash() >> shift;
         if ((shardId & (concurrency - 1)) != threadId)
           continue;
@@ -2669,9 +2676,13 @@ createSymbols(ArrayRef<std::vector<GdbIndexSection::NameAttrEntry>> nameAttrs,
         idx = symbols[shardId].size() + 1;
         symbols[shardId].push_back({ent.name, {v}, 0, 0});
       }
-      ++i;
     }
   });
+}
+
+std::vector<GdbIndexSection::GdbSymbol> GdbSymbolBuilder::finish() {
+  // The maps are no longer needed.
+  map.clear();
 
   size_t numSymbols = 0;
   for (ArrayRef<GdbSymbol> v : symbols)
@@ -2681,9 +2692,11 @@ createSymbols(ArrayRef<std::vector<GdbIndexSection::NameAttrEntry>> nameAttrs,
   // contents to Ret.
   std::vector<GdbSymbol> ret;
   ret.reserve(numSymbols);
-  for (std::vector<GdbSymbol> &vec : symbols)
+  for (std::vector<GdbSymbol> &vec : symbols) {
     for (GdbSymbol &sym : vec)
       ret.push_back(std::move(sym));
+    vec = std::vector<GdbSymbol>();
+  }
 
   // CU vectors and symbol names are adjacent in the output file.
   // We can compute their offsets in the output file now.
@@ -2712,23 +2725,44 @@ template <class ELFT> GdbIndexSection *GdbIndexSection::create() {
       s->markDead();
 
   std::vector<GdbChunk> chunks(sections.size());
-  std::vector<std::vector<NameAttrEntry>> nameAttrs(sections.size());
-
-  parallelForEachN(0, sections.size(), [&](size_t i) {
-    ObjFile<ELFT> *file = sections[i]->getFile<ELFT>();
-    DWARFContext dwarf(std::make_unique<LLDDwarfObj<ELFT>>(file));
-
-    chunks[i].sec = sections[i];
-    chunks[i].compilationUnits = readCuList(dwarf);
-    chunks[i].addressAreas = readAddressAreas(dwarf, sections[i]);
-    nameAttrs[i] = readPubNamesAndTypes<ELFT>(
-        static_cast<const LLDDwarfObj<ELFT> &>(dwarf.getDWARFObj()),
-        chunks[i].compilationUnits);
-  });
+  GdbSymbolBuilder builder;
+  uint32_t cuIdx = 0;
+
+  // Names and attributes read from .debug_gnu_pub{names,types} take much
+  // more memory than anything else here. Read them for a batch of files at
+  // a time and hand them over to the symbol builder before reading the next
+  // batch. Each file's DWARFContext is also destroyed as soon as the file
+  // has been read.
+  const size_t batchSize = 256;
+  for (size_t begin = 0; begin < sections.size(); begin += batchSize) {
+    size_t end = std::min(begin + batchSize, sections.size());
+    std::vector<std::vector<NameAttrEntry>> nameAttrs(end - begin);
+
+    parallelForEachN(begin, end, [&](size_t i) {
+      ObjFile<ELFT> *file = sections[i]->getFile<ELFT>();
+      DWARFContext dwarf(std::make_unique<LLDDwarfObj<ELFT>>(file));
+
+      chunks[i].sec = sections[i];
+      chunks[i].compilationUnits = readCuList(dwarf);
+      chunks[i].addressAreas = readAddressAreas(dwarf, sections[i]);
+      nameAttrs[i - begin] = readPubNamesAndTypes<ELFT>(
+          static_cast<const LLDDwarfObj<ELFT> &>(dwarf.getDWARFObj()),
+          chunks[i].compilationUnits);
+    });
+
+    // For each chunk, compute the number of compilation units preceding it.
+    std::vector<uint32_t> cuIdxs(end - begin);
+    for (size_t i = begin; i != end; ++i) {
+      cuIdxs[i - begin] = cuIdx;
+      cuIdx += chunks[i].compilationUnits.size();
+    }
+
+    builder.add(nameAttrs, cuIdxs);
+  }
 
   auto *ret = make<GdbIndexSection>();
   ret->chunks = std::move(chunks);
-  ret->symbols = createSymbols(nameAttrs, ret->chunks);
+  ret->symbols = builder.finish();
   ret->initOutputSize();
   return ret;
 }
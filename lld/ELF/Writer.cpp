@@ -27,6 +27,7 @@
 #include "llvm/ADT/StringSwitch.h"
 #include "llvm/Support/RandomNumberGenerator.h"
 #include "llvm/Support/SHA1.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/xxhash.h"
 #include <climits>
 
@@ -84,6 +85,9 @@ private:
 
   uint64_t fileSize;
   uint64_t sectionHeaderOff;
+
+  // Hash values of 1MB chunks of the output computed by --stream-output.
+  std::vector<uint8_t> buildIdChunkHashes;
 };
 } // anonymous namespace
 
@@ -1198,8 +1202,9 @@ findOrphanPos(std::vector<BaseCommand *>::iterator b,
 // Builds section order for handling --symbol-ordering-file.
 static DenseMap<const InputSectionBase *, int> buildSectionOrder() {
   DenseMap<const InputSectionBase *, int> sectionOrder;
-  // Use the rarely used option -call-graph-ordering-file to sort sections.
-  if (!config->callGraphProfile.empty())
+  // Use the rarely used options -call-graph-ordering-file and
+  // -call-graph-samples to sort sections.
+  if (!config->callGraphProfile.empty() || !config->callGraphSamples.empty())
     return computeCallGraphProfileOrder();
 
   if (config->symbolOrderingFile.empty())
@@ -1746,7 +1751,9 @@ template <class ELFT> void Writer<ELFT>::finalizeSections() {
   // after processSymbolAssignments() because it needs to know whether a
   // linker-script-defined symbol is absolute.
   if (!config->relocatable) {
-    forEachRelSec(scanRelocations<ELFT>);
+    std::vector<InputSectionBase *> relSecs;
+    forEachRelSec([&](InputSectionBase &sec) { relSecs.push_back(&sec); });
+    scanRelocations<ELFT>(relSecs);
     reportUndefinedSymbols<ELFT>();
   }
 
@@ -2592,8 +2599,14 @@ template <class ELFT> void Writer<ELFT>::openFile() {
     return;
   }
 
-  unlinkAsync(config->outputFile);
+  // With --incremental, the existing output is updated in place if its size
+  // has not changed, so we must not remove it beforehand. Otherwise a new
+  // file is created as usual.
   unsigned flags = 0;
+  if (config->incremental)
+    flags |= FileOutputBuffer::F_modify;
+  else
+    unlinkAsync(config->outputFile);
   if (!config->relocatable)
     flags |= FileOutputBuffer::F_executable;
   if (!config->mmapOutputFile)
@@ -2651,20 +2664,6 @@ template <class ELFT> void Writer<ELFT>::writeTrapInstr() {
   }
 }
 
-// Write section contents to a mmap'ed file.
-template <class ELFT> void Writer<ELFT>::writeSections() {
-  // In -r or -emit-relocs mode, write the relocation sections first as in
-  // ELf_Rel targets we might find out that we need to modify the relocated
-  // section while doing it.
-  for (OutputSection *sec : outputSections)
-    if (sec->type == SHT_REL || sec->type == SHT_RELA)
-      sec->writeTo<ELFT>(Out::bufferStart + sec->offset);
-
-  for (OutputSection *sec : outputSections)
-    if (sec->type != SHT_REL && sec->type != SHT_RELA)
-      sec->writeTo<ELFT>(Out::bufferStart + sec->offset);
-}
-
 // Split one uint8 array into small pieces of uint8 arrays.
 static std::vector<ArrayRef<uint8_t>> split(ArrayRef<uint8_t> arr,
                                             size_t chunkSize) {
@@ -2698,6 +2697,145 @@ computeHash(llvm::MutableArrayRef<uint8_t> hashBuf,
   hashFn(hashBuf.data(), hashes);
 }
 
+// Returns a function to compute a --build-id hash, or nullptr if the build
+// ID is not a hash of the output file.
+static std::function<void(uint8_t *dest, ArrayRef<uint8_t> arr)>
+getBuildIdHashFn(size_t hashSize) {
+  switch (config->buildId) {
+  case BuildIdKind::Fast:
+    return [](uint8_t *dest, ArrayRef<uint8_t> arr) {
+      write64le(dest, xxHash64(arr));
+    };
+  case BuildIdKind::Md5:
+    return [=](uint8_t *dest, ArrayRef<uint8_t> arr) {
+      memcpy(dest, MD5::hash(arr).data(), hashSize);
+    };
+  case BuildIdKind::Sha1:
+    return [=](uint8_t *dest, ArrayRef<uint8_t> arr) {
+      memcpy(dest, SHA1::hash(arr).data(), hashSize);
+    };
+  default:
+    return nullptr;
+  }
+}
+
+namespace {
+// For --stream-output. This class processes the parts of the output file
+// that are complete while later output sections are still being written.
+// Each complete 1MB chunk is hashed for --build-id in the background, in
+// the same way as computeHash() does, and then handed back to the output
+// buffer so that it can be written back to disk and released early. Without
+// a hash to compute, chunks are handed back on the calling thread.
+class OutputStreamer {
+public:
+  OutputStreamer(FileOutputBuffer &buffer, ArrayRef<uint8_t> data,
+                 size_t hashSize,
+                 std::function<void(uint8_t *, ArrayRef<uint8_t>)> hashFn)
+      : buffer(buffer), chunks(split(data, chunkSize)), size(data.size()),
+        hashSize(hashSize), hashFn(hashFn) {
+    if (hashFn) {
+      hashes.resize(chunks.size() * hashSize);
+      if (threadsEnabled)
+        pool = std::make_unique<ThreadPool>();
+    }
+  }
+
+  // Called when all bytes before `end` have their final contents.
+  void complete(uint64_t end) {
+    size_t n = end >= size ? chunks.size() : end / chunkSize;
+
+    for (; numQueued < n; ++numQueued) {
+      size_t i = numQueued;
+      if (pool)
+        pool->async([=] { processChunk(i); });
+      else
+        processChunk(i);
+    }
+  }
+
+  // Waits for all chunks to be processed and returns the concatenation of
+  // their hash values.
+  std::vector<uint8_t> finish() {
+    complete(UINT64_MAX);
+    if (pool)
+      pool->wait();
+    return std::move(hashes);
+  }
+
+private:
+  void processChunk(size_t i) {
+    if (hashFn)
+      hashFn(hashes.data() + i * hashSize, chunks[i]);
+    buffer.finalizeRange(i * chunkSize, chunks[i].size());
+  }
+
+  static const size_t chunkSize = 1024 * 1024;
+
+  FileOutputBuffer &buffer;
+  std::vector<ArrayRef<uint8_t>> chunks;
+  uint64_t size;
+  size_t hashSize;
+  std::function<void(uint8_t *, ArrayRef<uint8_t>)> hashFn;
+  std::vector<uint8_t> hashes;
+  std::unique_ptr<ThreadPool> pool;
+  size_t numQueued = 0;
+};
+} // namespace
+
+// Write section contents to a mmap'ed file.
+template <class ELFT> void Writer<ELFT>::writeSections() {
+  // In -r or -emit-relocs mode, write the relocation sections first as in
+  // ELf_Rel targets we might find out that we need to modify the relocated
+  // section while doing it.
+  std::vector<OutputSection *> sections;
+  for (OutputSection *sec : outputSections)
+    if (sec->type == SHT_REL || sec->type == SHT_RELA)
+      sections.push_back(sec);
+  for (OutputSection *sec : outputSections)
+    if (sec->type != SHT_REL && sec->type != SHT_RELA)
+      sections.push_back(sec);
+
+  if (!config->streamOutput) {
+    for (OutputSection *sec : sections)
+      sec->writeTo<ELFT>(Out::bufferStart + sec->offset);
+    return;
+  }
+
+  // The output file is final up to the lowest offset that the remaining
+  // sections write to. frontier[i] is that offset before sections[i] is
+  // written. EhFrameSection::writeTo() also writes .eh_frame_hdr, which is
+  // usually placed before .eh_frame.
+  std::vector<uint64_t> frontier(sections.size() + 1, fileSize);
+  for (size_t i = sections.size(); i > 0; --i) {
+    OutputSection *sec = sections[i - 1];
+    frontier[i - 1] = frontier[i];
+    if (sec->type != SHT_NOBITS && sec->size)
+      frontier[i - 1] = std::min(frontier[i - 1], sec->offset);
+    for (Partition &part : partitions)
+      if (part.ehFrameHdr && part.ehFrameHdr->getParent() &&
+          part.ehFrame->getParent() == sec)
+        frontier[i - 1] =
+            std::min(frontier[i - 1], part.ehFrameHdr->getParent()->offset);
+  }
+
+  // Only a build ID computed from the contents needs the chunk hashes.
+  size_t hashSize = 0;
+  if (mainPart->buildId && mainPart->buildId->getParent() &&
+      config->buildId != BuildIdKind::Hexstring &&
+      config->buildId != BuildIdKind::Uuid)
+    hashSize = mainPart->buildId->hashSize;
+
+  OutputStreamer streamer(*buffer, {Out::bufferStart, size_t(fileSize)},
+                          hashSize,
+                          hashSize ? getBuildIdHashFn(hashSize) : nullptr);
+  streamer.complete(frontier[0]);
+  for (size_t i = 0, e = sections.size(); i != e; ++i) {
+    sections[i]->writeTo<ELFT>(Out::bufferStart + sections[i]->offset);
+    streamer.complete(frontier[i + 1]);
+  }
+  buildIdChunkHashes = streamer.finish();
+}
+
 template <class ELFT> void Writer<ELFT>::writeBuildId() {
   if (!mainPart->buildId || !mainPart->buildId->getParent())
     return;
@@ -2713,28 +2851,19 @@ template <class ELFT> void Writer<ELFT>::writeBuildId() {
   std::vector<uint8_t> buildId(hashSize);
   llvm::ArrayRef<uint8_t> buf{Out::bufferStart, size_t(fileSize)};
 
-  switch (config->buildId) {
-  case BuildIdKind::Fast:
-    computeHash(buildId, buf, [](uint8_t *dest, ArrayRef<uint8_t> arr) {
-      write64le(dest, xxHash64(arr));
-    });
-    break;
-  case BuildIdKind::Md5:
-    computeHash(buildId, buf, [&](uint8_t *dest, ArrayRef<uint8_t> arr) {
-      memcpy(dest, MD5::hash(arr).data(), hashSize);
-    });
-    break;
-  case BuildIdKind::Sha1:
-    computeHash(buildId, buf, [&](uint8_t *dest, ArrayRef<uint8_t> arr) {
-      memcpy(dest, SHA1::hash(arr).data(), hashSize);
-    });
-    break;
-  case BuildIdKind::Uuid:
+  if (config->buildId == BuildIdKind::Uuid) {
     if (auto ec = llvm::getRandomBytes(buildId.data(), hashSize))
       error("entropy source failure: " + ec.message());
-    break;
-  default:
-    llvm_unreachable("unknown BuildIdKind");
+  } else {
+    auto hashFn = getBuildIdHashFn(hashSize);
+    if (!hashFn)
+      llvm_unreachable("unknown BuildIdKind");
+
+    // With --stream-output, writeSections() has hashed the chunks already.
+    if (!buildIdChunkHashes.empty())
+      hashFn(buildId.data(), buildIdChunkHashes);
+    else
+      computeHash(buildId, buf, hashFn);
   }
   for (Partition &part : partitions)
     part.buildId->writeBuildId(buildId);
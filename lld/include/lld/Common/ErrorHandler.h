@@ -109,6 +109,23 @@ private:
 /// Returns the default error handler.
 ErrorHandler &errorHandler();
 
+/// While an object of this class is alive, errors reported on the thread that
+/// created it are neither printed nor counted; getCount() returns how many
+/// there were. A parallel pass uses this to leave the items that have errors
+/// to a serial pass, which reports them in a deterministic order. Fatal
+/// errors are not suppressed.
+class ErrorSuppressor {
+public:
+  ErrorSuppressor();
+  ~ErrorSuppressor();
+  uint64_t getCount() const { return count; }
+
+private:
+  friend class ErrorHandler;
+  ErrorSuppressor *prev;
+  uint64_t count = 0;
+};
+
 void enableColors(bool enable);
 
 inline void error(const Twine &msg) { errorHandler().error(msg); }
@@ -22,12 +22,19 @@
 #define LLD_COMMON_MEMORY_H
 
 #include "llvm/Support/Allocator.h"
+#include "llvm/Support/ConcurrentBumpPtrAllocator.h"
 #include "llvm/Support/StringSaver.h"
+#include "llvm/Support/TypeName.h"
 #include <vector>
 
+namespace llvm {
+class raw_ostream;
+}
+
 namespace lld {
 
-// Use this arena if your object doesn't have a destructor.
+// Use this arena if your object doesn't have a destructor. It must only be
+// used from one thread at a time.
 extern llvm::BumpPtrAllocator bAlloc;
 extern llvm::StringSaver saver;
 
@@ -36,24 +43,64 @@ void freeArena();
 // These two classes are hack to keep track of all
 // SpecificBumpPtrAllocator instances.
 struct SpecificAllocBase {
-  SpecificAllocBase() { instances.push_back(this); }
+  SpecificAllocBase();
   virtual ~SpecificAllocBase() = default;
   virtual void reset() = 0;
+  virtual llvm::StringRef getTypeName() const = 0;
+  virtual size_t getTotalMemory() const = 0;
+  virtual size_t getBytesAllocated() const = 0;
+  virtual size_t getObjectSize() const = 0;
   static std::vector<SpecificAllocBase *> instances;
 };
 
 template <class T> struct SpecificAlloc : public SpecificAllocBase {
   void reset() override { alloc.DestroyAll(); }
-  llvm::SpecificBumpPtrAllocator<T> alloc;
+  llvm::StringRef getTypeName() const override {
+    return llvm::getTypeName<T>();
+  }
+  size_t getTotalMemory() const override { return alloc.getTotalMemory(); }
+  size_t getBytesAllocated() const override {
+    return alloc.getBytesAllocated();
+  }
+  size_t getObjectSize() const override { return sizeof(T); }
+  llvm::ConcurrentSpecificBumpPtrAllocator<T> alloc;
 };
 
 // Use this arena if your object has a destructor.
 // Your destructor will be invoked from freeArena().
+// This may be called from several threads at once, e.g. from parallelForEach.
 template <typename T, typename... U> T *make(U &&... args) {
   static SpecificAlloc<T> alloc;
   return new (alloc.alloc.Allocate()) T(std::forward<U>(args)...);
 }
 
+// A snapshot of the memory used by the linker.
+struct MemoryUsage {
+  // Bytes reserved by bAlloc and by all make<T> arenas.
+  uint64_t arenaBytes = 0;
+  // Number of objects created by make<T>.
+  uint64_t arenaObjects = 0;
+  // Resident set size of the process, or 0 if it is not available.
+  uint64_t rss = 0;
+};
+
+MemoryUsage getMemoryUsage();
+
+// Samples the memory usage at the end of a phase of the link. The sample is
+// recorded as a counter event in the time trace, if one is being recorded,
+// and kept for printArenaUsage() if recordPhaseMemory is set. Nothing is
+// sampled otherwise. The ELF driver calls this, as it uses the time trace
+// rather than ScopedTimer to mark its phases.
+void samplePhaseMemory(llvm::StringRef phase);
+
+// If set, memory usage is kept for the report at the end of each phase and
+// at each ScopedTimer boundary.
+extern bool recordPhaseMemory;
+
+// Prints arena usage per object type, largest first, followed by the totals
+// and by the samples taken by samplePhaseMemory().
+void printArenaUsage(llvm::raw_ostream &os);
+
 } // namespace lld
 
 #endif
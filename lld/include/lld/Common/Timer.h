@@ -16,6 +16,10 @@
 #include <map>
 #include <memory>
 
+namespace llvm {
+class raw_ostream;
+}
+
 namespace lld {
 
 class Timer;
@@ -42,12 +46,27 @@ public:
 
   double millis() const;
 
+  // Prints the memory usage sampled under each timer. See sampleMemory().
+  void printMemory(llvm::raw_ostream &os) const;
+
 private:
+  friend struct ScopedTimer;
+
   explicit Timer(llvm::StringRef name);
   void print(int depth, double totalDuration, bool recurse = true) const;
+  void printMemory(llvm::raw_ostream &os, int depth) const;
+
+  // If recordPhaseMemory is set, ScopedTimer calls this when it starts and
+  // stops the timer to record how much the arenas grew while it was running.
+  void sampleMemory(bool starting);
 
   std::chrono::time_point<std::chrono::high_resolution_clock> startTime;
   std::chrono::nanoseconds total;
+  uint64_t startArenaBytes = 0;
+  uint64_t startArenaObjects = 0;
+  int64_t arenaBytes = 0;
+  int64_t arenaObjects = 0;
+  uint64_t peakRss = 0;
   std::vector<Timer *> children;
   std::string name;
   Timer *parent;
@@ -0,0 +1,23 @@
+# REQUIRES: x86
+## /print-arena-usage prints the arena usage by object type, followed by how
+## much the arenas grew under each timer and the peak RSS seen by it.
+
+# RUN: llvm-mc -filetype=obj -triple=x86_64-windows-msvc %s -o %t.obj
+# RUN: lld-link /entry:main /subsystem:console /opt:ref /opt:icf \
+# RUN:   /out:%t.exe %t.obj /print-arena-usage | FileCheck %s
+
+# CHECK:      input files: 1
+# CHECK-NEXT: chunks: {{[0-9]+}}
+# CHECK-NEXT: symbols: {{[0-9]+}}
+# CHECK-NEXT:        Bytes      Objects  Type
+# CHECK:      {{ +[0-9]+ +[0-9]+}}  <total arena>
+# CHECK:       Arena bytes      Objects     Peak RSS  Timer
+# CHECK-NEXT: {{ +[0-9]+ +[0-9]+ +[0-9]+}}  Input File Reading
+# CHECK-NEXT: {{ +[0-9]+ +[0-9]+ +[0-9]+}}  GC
+# CHECK-NEXT: {{ +[0-9]+ +[0-9]+ +[0-9]+}}  ICF
+# CHECK-NEXT: {{ +[0-9]+ +[0-9]+ +[0-9]+}}  Code Layout
+# CHECK-NEXT: {{ +[0-9]+ +[0-9]+ +[0-9]+}}  Commit Output File
+
+.globl main
+main:
+  ret
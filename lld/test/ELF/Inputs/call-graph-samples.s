@@ -0,0 +1,27 @@
+.file "b.c"
+
+.section .text.b_entry,"ax",@progbits
+.p2align 4
+.globl b_entry
+.type b_entry,@function
+b_entry:
+  call hot
+  ret
+  .fill 10, 1, 0xcc
+.size b_entry, 16
+
+.section .text.hot,"ax",@progbits
+.p2align 4
+.type hot,@function
+hot:
+  ret
+  .fill 15, 1, 0xcc
+.size hot, 16
+
+.section .text.dead,"ax",@progbits
+.p2align 4
+.type dead,@function
+dead:
+  ret
+  .fill 15, 1, 0xcc
+.size dead, 16
@@ -0,0 +1,51 @@
+# REQUIRES: x86
+## Samples are mapped to the functions of the profiled binary, and local
+## functions are told apart by the STT_FILE symbol preceding them. Both input
+## files define a local function named hot; only the one of a.c is sampled.
+## Samples in a function that was garbage collected are ignored.
+
+# RUN: llvm-mc -filetype=obj -triple=x86_64 %s -o %t1.o
+# RUN: llvm-mc -filetype=obj -triple=x86_64 %p/Inputs/call-graph-samples.s \
+# RUN:   -o %t2.o
+
+## In the profiled binary, hot of a.c is at 0x10010, hot of b.c is at
+## 0x10030 and dead is at 0x10040.
+# RUN: ld.lld -Ttext=0x10000 %t1.o %t2.o -o %t.prof
+# RUN: llvm-readelf -s %t.prof | FileCheck --check-prefix=PROF %s
+
+# PROF:      FILE {{.*}} a.c
+# PROF-NEXT: 0000000000010010 16 FUNC LOCAL DEFAULT {{.*}} hot
+# PROF:      FILE {{.*}} b.c
+# PROF-NEXT: 0000000000010030 16 FUNC LOCAL DEFAULT {{.*}} hot
+# PROF-NEXT: 0000000000010040 16 FUNC LOCAL DEFAULT {{.*}} dead
+
+# RUN: echo "0x10014 1000" > %t.samples
+# RUN: echo "0x10041 5000" >> %t.samples
+# RUN: ld.lld -Ttext=0x10000 --gc-sections %t1.o %t2.o -o %t \
+# RUN:   --call-graph-samples=%t.samples --call-graph-samples-binary=%t.prof
+# RUN: llvm-readelf -s %t | FileCheck %s
+
+# CHECK:      FILE {{.*}} a.c
+# CHECK-NEXT: 0000000000010000 16 FUNC LOCAL DEFAULT {{.*}} hot
+# CHECK:      FILE {{.*}} b.c
+# CHECK-NEXT: 0000000000010030 16 FUNC LOCAL DEFAULT {{.*}} hot
+# CHECK-NOT:  dead
+
+.file "a.c"
+
+.section .text._start,"ax",@progbits
+.globl _start
+.type _start,@function
+_start:
+  call hot
+  call b_entry
+  ret
+.size _start, .-_start
+
+.section .text.hot,"ax",@progbits
+.p2align 4
+.type hot,@function
+hot:
+  ret
+  .fill 15, 1, 0xcc
+.size hot, 16
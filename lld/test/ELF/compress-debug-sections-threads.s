@@ -0,0 +1,22 @@
+# REQUIRES: x86, zlib
+## Debug sections larger than a chunk (1 MiB) are compressed in independent
+## chunks. The chunks are the same with and without threads, so the output
+## must not depend on --threads.
+
+# RUN: llvm-mc -filetype=obj -triple=x86_64 %s -o %t.o
+# RUN: ld.lld %t.o --compress-debug-sections=zlib --threads -o %t1
+# RUN: ld.lld %t.o --compress-debug-sections=zlib --no-threads -o %t2
+# RUN: cmp %t1 %t2
+# RUN: llvm-readobj -S %t1 | FileCheck %s
+
+# CHECK:      Name: .debug_info
+# CHECK-NEXT: Type: SHT_PROGBITS
+# CHECK-NEXT: Flags [
+# CHECK-NEXT:   SHF_COMPRESSED (0x800)
+# CHECK-NEXT: ]
+
+## 2.5 MiB, so that there are three chunks and the last one is partial.
+.section .debug_info,"",@progbits
+.rept 163840
+.ascii "0123456789abcdef"
+.endr
@@ -0,0 +1,59 @@
+# REQUIRES: x86, zlib, zstd
+## --compress-debug-sections=zstd compresses .debug_* sections into
+## SHF_COMPRESSED sections whose ch_type is ELFCOMPRESS_ZSTD (2). Sections that
+## are not debug sections are left alone.
+
+# RUN: llvm-mc -filetype=obj -triple=x86_64 %s -o %t.o
+# RUN: ld.lld %t.o --compress-debug-sections=zstd -o %t
+# RUN: llvm-readobj -S %t | FileCheck %s --check-prefix=SEC
+# RUN: llvm-objdump -s -j .debug_str %t | FileCheck %s --check-prefix=HDR
+# RUN: llvm-dwarfdump --debug-str %t | FileCheck %s --check-prefix=STR
+
+# SEC:      Name: .debug_str
+# SEC-NEXT: Type: SHT_PROGBITS
+# SEC-NEXT: Flags [
+# SEC-NEXT:   SHF_COMPRESSED (0x800)
+# SEC-NEXT:   SHF_MERGE (0x10)
+# SEC-NEXT:   SHF_STRINGS (0x20)
+# SEC-NEXT: ]
+# SEC:      Name: .comment
+# SEC-NEXT: Type: SHT_PROGBITS
+# SEC-NEXT: Flags [
+# SEC-NEXT:   SHF_MERGE (0x10)
+# SEC-NEXT:   SHF_STRINGS (0x20)
+# SEC-NEXT: ]
+
+## Elf64_Chdr: ch_type = ELFCOMPRESS_ZSTD, ch_reserved = 0 and ch_size = 513.
+# HDR:      Contents of section .debug_str:
+# HDR-NEXT: 0000 02000000 00000000 01020000 00000000
+
+# STR: .debug_str contents:
+# STR-NEXT: 0x00000000: "{{A{512}}}"
+
+## zstd compressed input sections are decompressed, and can be written out
+## with either format. llvm-mc only compresses a section if that makes it
+## smaller, so the string below is long and repetitive.
+# RUN: llvm-mc -filetype=obj -triple=x86_64 -compress-debug-sections=zstd %s \
+# RUN:   -o %t.zstd.o
+# RUN: ld.lld %t.zstd.o -o %t.none
+# RUN: llvm-readobj -S %t.none | FileCheck %s --check-prefix=NONE
+# RUN: llvm-dwarfdump --debug-str %t.none | FileCheck %s --check-prefix=STR
+# RUN: ld.lld %t.zstd.o --compress-debug-sections=zlib -o %t.zlib
+# RUN: llvm-objdump -s -j .debug_str %t.zlib | FileCheck %s --check-prefix=ZLIB
+# RUN: llvm-dwarfdump --debug-str %t.zlib | FileCheck %s --check-prefix=STR
+
+# NONE:      Name: .debug_str
+# NONE-NEXT: Type: SHT_PROGBITS
+# NONE-NEXT: Flags [
+# NONE-NEXT:   SHF_MERGE (0x10)
+# NONE-NEXT:   SHF_STRINGS (0x20)
+# NONE-NEXT: ]
+
+# ZLIB:      Contents of section .debug_str:
+# ZLIB-NEXT: 0000 01000000 00000000 01020000 00000000
+
+.section .debug_str,"MS",@progbits,1
+.rept 64
+.ascii "AAAAAAAA"
+.endr
+.byte 0
@@ -0,0 +1,33 @@
+# REQUIRES: x86
+## --incremental updates an existing output of the same size in place. The
+## result must be the same as that of a regular link, and the output must be
+## newer than its inputs even if no byte of it changed.
+
+# RUN: llvm-mc -filetype=obj -triple=x86_64 %s -o %t1.o
+# RUN: llvm-mc -filetype=obj -triple=x86_64 --defsym=CHANGED=1 %s -o %t2.o
+
+# RUN: ld.lld %t2.o -o %t.ref
+# RUN: ld.lld --incremental %t1.o -o %t.out
+# RUN: ld.lld --incremental %t2.o -o %t.out
+# RUN: cmp %t.ref %t.out
+
+## Relinking the same input does not change a byte, but still updates the
+## modification time.
+# RUN: touch -t 200001010000 %t.out
+# RUN: ld.lld --incremental %t2.o -o %t.out
+# RUN: cmp %t.ref %t.out
+# RUN: %python -c "import os, sys; sys.exit(os.path.getmtime(sys.argv[1]) < 1e9)" %t.out
+
+## A different size falls back to a regular link.
+# RUN: ld.lld --incremental --build-id %t1.o -o %t.out
+# RUN: ld.lld --build-id %t1.o -o %t.ref
+# RUN: cmp %t.ref %t.out
+
+.globl _start
+_start:
+.ifdef CHANGED
+  movl $2, %eax
+.else
+  movl $1, %eax
+.endif
+  ret
@@ -0,0 +1,52 @@
+; REQUIRES: x86
+;; --thinlto-memory-limit changes when the ThinLTO backend jobs run, but not
+;; what they produce.
+
+; RUN: opt -module-summary %s -o %t1.o
+; RUN: opt -module-summary %p/Inputs/thinlto-memory-limit.ll -o %t2.o
+
+; RUN: ld.lld --thinlto-jobs=2 -shared %t1.o %t2.o -o %t.ref
+; RUN: ld.lld --thinlto-jobs=2 --thinlto-memory-limit=1 -shared %t1.o %t2.o \
+; RUN:   -o %t
+; RUN: cmp %t.ref %t
+
+;; Without a limit, both jobs run at once.
+; RUN: ld.lld --thinlto-jobs=2 -shared %t1.o %t2.o -o %t \
+; RUN:   --time-trace --time-trace-file=%t.json
+; RUN: FileCheck %s --check-prefix=PARALLEL < %t.json
+; PARALLEL: "name":"ThinLTO backend jobs","args":{"running":2,
+
+;; Each job is estimated to need more than the 1 MiB limit, so they run one
+;; at a time.
+; RUN: ld.lld --thinlto-jobs=2 --thinlto-memory-limit=1 -shared %t1.o %t2.o \
+; RUN:   -mllvm -thinlto-backend-bytes-per-bitcode-byte=1048576 -o %t \
+; RUN:   --time-trace --time-trace-file=%t.json
+; RUN: FileCheck %s --check-prefix=SERIAL < %t.json
+; RUN: cmp %t.ref %t
+; SERIAL-NOT: "running":2,
+; SERIAL:     "name":"ThinLTO backend jobs","args":{"running":1,
+; SERIAL-NOT: "running":2,
+
+;; --thinlto-memory-limit alone also selects the in-process backend with one
+;; job per core.
+; RUN: ld.lld --thinlto-memory-limit=1024 -shared %t1.o %t2.o -o %t
+; RUN: cmp %t.ref %t
+
+; RUN: not ld.lld --thinlto-memory-limit=-1 -shared %t1.o %t2.o -o %t 2>&1 \
+; RUN:   | FileCheck %s --check-prefix=NEGATIVE
+; NEGATIVE: error: --thinlto-memory-limit: limit must be >= 0
+
+; RUN: not ld.lld --thinlto-memory-limit=foo -shared %t1.o %t2.o -o %t 2>&1 \
+; RUN:   | FileCheck %s --check-prefix=NOTNUM
+; NOTNUM: error: --thinlto-memory-limit=: number expected, but got 'foo'
+
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+declare void @g()
+
+define void @f() {
+entry:
+  call void @g()
+  ret void
+}
@@ -0,0 +1,38 @@
+# REQUIRES: x86
+## Symbol table keys of object files are computed in parallel when threads
+## are enabled. Check that symbol resolution and the output do not depend on
+## it.
+
+# RUN: llvm-mc -filetype=obj -triple=x86_64 %s -o %t.o
+# RUN: echo '.globl f1, w; f1: call f2; w: ret; .comm c,4,4' | \
+# RUN:   llvm-mc -filetype=obj -triple=x86_64 - -o %t1.o
+# RUN: echo '.globl f2; .weak w; f2: call f3; w: ret; .comm c,8,8' | \
+# RUN:   llvm-mc -filetype=obj -triple=x86_64 - -o %t2.o
+# RUN: echo '.globl f3; f3: call f4; call undef' | \
+# RUN:   llvm-mc -filetype=obj -triple=x86_64 - -o %t3.o
+# RUN: echo '.globl f4; .weak f5; f4: call f5; f5: ret; .comm c,16,16' | \
+# RUN:   llvm-mc -filetype=obj -triple=x86_64 - -o %t4.o
+# RUN: echo '.globl f5; f5: call f6' | \
+# RUN:   llvm-mc -filetype=obj -triple=x86_64 - -o %t5.o
+# RUN: echo '.globl f6; f6: call f7; f1: ret' | \
+# RUN:   llvm-mc -filetype=obj -triple=x86_64 - -o %t6.o
+# RUN: echo '.globl f7; .weak f1; f7: ret; f1: ret' | \
+# RUN:   llvm-mc -filetype=obj -triple=x86_64 - -o %t7.o
+
+# RUN: ld.lld --no-threads -shared %t.o %t1.o %t2.o %t3.o %t4.o %t5.o %t6.o \
+# RUN:   %t7.o -o %t.serial
+# RUN: ld.lld --threads -shared %t.o %t1.o %t2.o %t3.o %t4.o %t5.o %t6.o \
+# RUN:   %t7.o -o %t.parallel
+# RUN: cmp %t.serial %t.parallel
+# RUN: llvm-nm -S %t.parallel | FileCheck %s
+
+# CHECK-DAG: {{[0-9a-f]+}} 0000000000000010 B c
+# CHECK-DAG: T f1
+# CHECK-DAG: t f1
+# CHECK-DAG: T f5
+# CHECK-DAG: T w
+# CHECK-DAG: U undef
+
+.globl _start
+_start:
+  call f1
@@ -0,0 +1,24 @@
+# REQUIRES: x86
+## --print-arena-usage prints the arena usage by object type, followed by the
+## memory usage sampled at the end of each phase of the link.
+
+# RUN: llvm-mc -filetype=obj -triple=x86_64 %s -o %t.o
+# RUN: ld.lld --print-arena-usage %t.o -o %t | FileCheck %s
+# RUN: ld.lld --print-arena-usage --no-print-arena-usage %t.o -o %t | \
+# RUN:   count 0
+
+# CHECK:      input files: 1
+# CHECK-NEXT: input sections: {{[0-9]+}}
+# CHECK-NEXT: symbols: {{[0-9]+}}
+# CHECK-NEXT:        Bytes      Objects  Type
+# CHECK:      {{ +[0-9]+ +[0-9]+}}  <total arena>
+# CHECK:       Arena bytes          RSS  After phase
+# CHECK-NEXT: {{ +[0-9]+ +[0-9]+}}  parse input files
+# CHECK-NEXT: {{ +[0-9]+ +[0-9]+}}  LTO
+# CHECK-NEXT: {{ +[0-9]+ +[0-9]+}}  garbage collection
+# CHECK-NEXT: {{ +[0-9]+ +[0-9]+}}  ICF and call graph
+# CHECK-NEXT: {{ +[0-9]+ +[0-9]+}}  write output
+
+.globl _start
+_start:
+  ret
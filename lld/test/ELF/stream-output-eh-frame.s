@@ -0,0 +1,40 @@
+# REQUIRES: x86
+## The .eh_frame_hdr contents are written with .eh_frame. Place more than
+## 1MB between the two, so that the chunks of .eh_frame_hdr are complete
+## only once .eh_frame is written, and check that --stream-output computes
+## the same build ID as without it.
+
+# RUN: llvm-mc -filetype=obj -triple=x86_64 %s -o %t.o
+# RUN: echo "SECTIONS { \
+# RUN:   .eh_frame_hdr : { *(.eh_frame_hdr) } \
+# RUN:   .big : { *(.big) } \
+# RUN:   .eh_frame : { *(.eh_frame) } \
+# RUN:   .text : { *(.text) } }" > %t.script
+
+# RUN: ld.lld --eh-frame-hdr --build-id=sha1 -T %t.script %t.o -o %t.ref
+# RUN: ld.lld --eh-frame-hdr --build-id=sha1 --stream-output --no-threads \
+# RUN:   -T %t.script %t.o -o %t
+# RUN: cmp %t.ref %t
+# RUN: ld.lld --eh-frame-hdr --build-id=sha1 --stream-output \
+# RUN:   -T %t.script %t.o -o %t
+# RUN: cmp %t.ref %t
+
+# RUN: llvm-readobj --sections %t | FileCheck %s
+# CHECK: Name: .eh_frame_hdr
+# CHECK: Name: .big
+# CHECK: Name: .eh_frame
+
+.globl _start
+_start:
+  .cfi_startproc
+  call foo
+  ret
+  .cfi_endproc
+
+foo:
+  .cfi_startproc
+  ret
+  .cfi_endproc
+
+.section .big,"a",@progbits
+  .fill 0x180000, 1, 0x5a
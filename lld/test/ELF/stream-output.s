@@ -0,0 +1,45 @@
+# REQUIRES: x86
+## --stream-output writes back and hashes parts of the output while later
+## sections are still being written. The output must be the same as without
+## it, with or without a build ID and with or without threads.
+
+# RUN: llvm-mc -filetype=obj -triple=x86_64 %s -o %t.o
+
+# RUN: ld.lld %t.o -o %t.ref
+# RUN: ld.lld --stream-output %t.o -o %t
+# RUN: cmp %t.ref %t
+# RUN: ld.lld --stream-output --no-threads %t.o -o %t
+# RUN: cmp %t.ref %t
+
+# RUN: ld.lld --build-id=sha1 %t.o -o %t.ref
+# RUN: ld.lld --build-id=sha1 --stream-output %t.o -o %t
+# RUN: cmp %t.ref %t
+# RUN: ld.lld --build-id=sha1 --stream-output --no-threads %t.o -o %t
+# RUN: cmp %t.ref %t
+
+# RUN: ld.lld --build-id=fast %t.o -o %t.ref
+# RUN: ld.lld --build-id=fast --stream-output %t.o -o %t
+# RUN: cmp %t.ref %t
+
+# RUN: ld.lld --build-id=0x12345678 %t.o -o %t.ref
+# RUN: ld.lld --build-id=0x12345678 --stream-output %t.o -o %t
+# RUN: cmp %t.ref %t
+
+## A UUID is random, so only check that one is written.
+# RUN: ld.lld --build-id=uuid --stream-output %t.o -o %t
+# RUN: llvm-readobj --notes %t | FileCheck %s
+# CHECK: Build ID:
+
+## Several chunks of 1MB in sections of different types.
+.globl _start
+_start:
+  ret
+
+.section .text.big,"ax",@progbits
+  .fill 0x180000, 1, 0xcc
+
+.data
+  .fill 0x120000, 1, 0x5a
+
+.bss
+  .zero 0x100000
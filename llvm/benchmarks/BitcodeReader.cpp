@@ -0,0 +1,99 @@
+#include "benchmark/benchmark.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/raw_ostream.h"
+#include <random>
+
+using namespace llvm;
+
+// The bitcode of a module with 4000 functions of about 200 instructions each,
+// a mix of arithmetic, memory accesses and calls.
+static const SmallVector<char, 0> &getBitcode() {
+  static SmallVector<char, 0> Bitcode = [] {
+    LLVMContext Ctx;
+    Module M("bench", Ctx);
+    Type *I64 = Type::getInt64Ty(Ctx);
+    FunctionType *FTy =
+        FunctionType::get(I64, {I64, I64->getPointerTo()}, false);
+    std::mt19937 Gen(42);
+    Function *Prev = nullptr;
+    for (unsigned I = 0; I < 4000; ++I) {
+      Function *F = Function::Create(FTy, GlobalValue::ExternalLinkage,
+                                     "f" + Twine(I), M);
+      IRBuilder<> B(BasicBlock::Create(Ctx, "entry", F));
+      Value *Acc = F->getArg(0);
+      Value *P = F->getArg(1);
+      for (unsigned J = 0; J < 100; ++J) {
+        switch (Gen() % 4) {
+        case 0:
+          Acc = B.CreateAdd(Acc, B.getInt64(Gen() % 100000));
+          break;
+        case 1:
+          Acc = B.CreateXor(
+              Acc, B.CreateLoad(I64, B.CreateGEP(I64, P, B.getInt64(J))));
+          break;
+        case 2:
+          B.CreateStore(Acc, B.CreateGEP(I64, P, Acc));
+          break;
+        case 3:
+          if (Prev)
+            Acc = B.CreateCall(Prev, {Acc, P});
+          break;
+        }
+      }
+      B.CreateRet(Acc);
+      Prev = F;
+    }
+
+    SmallVector<char, 0> Buffer;
+    raw_svector_ostream OS(Buffer);
+    WriteBitcodeToFile(M, OS);
+    return Buffer;
+  }();
+  return Bitcode;
+}
+
+static void setDecodeThreads(unsigned Threads) {
+  auto *Opt = static_cast<cl::opt<unsigned> *>(
+      cl::getRegisteredOptions().lookup("bitcode-decode-threads"));
+  *Opt = Threads;
+}
+
+// Parse the whole module with function bodies decoded on the given number of
+// threads, or while parsing for 0.
+static void BM_ParseBitcode(benchmark::State &State) {
+  const SmallVector<char, 0> &Bitcode = getBitcode();
+  setDecodeThreads(State.range(0));
+  for (auto _ : State) {
+    auto Ctx = std::make_unique<LLVMContext>();
+    Expected<std::unique_ptr<Module>> M = parseBitcodeFile(
+        MemoryBufferRef(StringRef(Bitcode.data(), Bitcode.size()), "bench"),
+        *Ctx);
+    if (!M) {
+      State.SkipWithError(toString(M.takeError()).c_str());
+      break;
+    }
+    // Don't count the time to free the module.
+    State.PauseTiming();
+    M->reset();
+    Ctx.reset();
+    State.ResumeTiming();
+  }
+  setDecodeThreads(0);
+  State.SetBytesProcessed(State.iterations() * Bitcode.size());
+}
+BENCHMARK(BM_ParseBitcode)
+    ->Arg(0)
+    ->Arg(1)
+    ->Arg(2)
+    ->Arg(4)
+    ->Arg(8)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,137 @@
+#include "benchmark/benchmark.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Compression.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/LEB128.h"
+#include "llvm/Support/raw_ostream.h"
+#include <random>
+#include <string>
+
+using namespace llvm;
+using compression::Format;
+
+// Input that compresses roughly like DWARF: ULEB128 numbers with a skewed
+// distribution, interleaved with strings drawn from a small vocabulary.
+static const std::string &getInput() {
+  static std::string Data = [] {
+    std::string S;
+    raw_string_ostream OS(S);
+    std::mt19937 Gen(42);
+    std::geometric_distribution<uint64_t> Num(0.05);
+    std::uniform_int_distribution<int> Word(0, 999);
+    while (OS.tell() < (8 << 20)) {
+      for (int I = 0; I < 8; ++I)
+        encodeULEB128(Num(Gen), OS);
+      OS << "_ZN4llvm" << Word(Gen) << "getValue" << '\0';
+    }
+    OS.flush();
+    return S;
+  }();
+  return Data;
+}
+
+static void compressWith(benchmark::State &State, Format F, int Level) {
+  const std::string &Input = getInput();
+  SmallVector<char, 0> Compressed;
+  for (auto _ : State) {
+    Compressed.clear();
+    Error E = F == Format::Zstd ? zstd::compress(Input, Compressed, Level)
+                                : zlib::compress(Input, Compressed, Level);
+    if (E) {
+      State.SkipWithError(toString(std::move(E)).c_str());
+      return;
+    }
+  }
+  State.SetBytesProcessed(State.iterations() * Input.size());
+  State.counters["ratio"] = double(Input.size()) / Compressed.size();
+}
+
+static void uncompressWith(benchmark::State &State, Format F) {
+  const std::string &Input = getInput();
+  SmallVector<char, 0> Compressed;
+  SmallVector<char, 0> Uncompressed;
+  if (Error E = compression::compress(F, Input, Compressed)) {
+    State.SkipWithError(toString(std::move(E)).c_str());
+    return;
+  }
+  for (auto _ : State) {
+    if (Error E = compression::uncompress(F, StringRef(Compressed.data(),
+                                                       Compressed.size()),
+                                          Uncompressed, Input.size())) {
+      State.SkipWithError(toString(std::move(E)).c_str());
+      return;
+    }
+  }
+  State.SetBytesProcessed(State.iterations() * Input.size());
+}
+
+static void BM_ZlibCompress(benchmark::State &State) {
+  if (!zlib::isAvailable())
+    return State.SkipWithError("zlib is not available");
+  compressWith(State, Format::Zlib, State.range(0));
+}
+BENCHMARK(BM_ZlibCompress)
+    ->Arg(zlib::BestSpeedCompression)
+    ->Arg(zlib::DefaultCompression)
+    ->Arg(zlib::BestSizeCompression)
+    ->Unit(benchmark::kMillisecond);
+
+static void BM_ZstdCompress(benchmark::State &State) {
+  if (!zstd::isAvailable())
+    return State.SkipWithError("zstd is not available");
+  compressWith(State, Format::Zstd, State.range(0));
+}
+BENCHMARK(BM_ZstdCompress)
+    ->Arg(zstd::BestSpeedCompression)
+    ->Arg(zstd::DefaultCompression)
+    ->Arg(zstd::HighCompression)
+    ->Unit(benchmark::kMillisecond);
+
+static void compressParallelWith(benchmark::State &State, Format F) {
+  const std::string &Input = getInput();
+  SmallVector<char, 0> Compressed;
+  for (auto _ : State) {
+    Compressed.clear();
+    if (Error E = compression::compressParallel(F, Input, Compressed)) {
+      State.SkipWithError(toString(std::move(E)).c_str());
+      return;
+    }
+  }
+  State.SetBytesProcessed(State.iterations() * Input.size());
+  State.counters["ratio"] = double(Input.size()) / Compressed.size();
+}
+
+static void BM_ZlibCompressParallel(benchmark::State &State) {
+  if (!zlib::isAvailable())
+    return State.SkipWithError("zlib is not available");
+  compressParallelWith(State, Format::Zlib);
+}
+BENCHMARK(BM_ZlibCompressParallel)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+static void BM_ZstdCompressParallel(benchmark::State &State) {
+  if (!zstd::isAvailable())
+    return State.SkipWithError("zstd is not available");
+  compressParallelWith(State, Format::Zstd);
+}
+BENCHMARK(BM_ZstdCompressParallel)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+static void BM_ZlibUncompress(benchmark::State &State) {
+  if (!zlib::isAvailable())
+    return State.SkipWithError("zlib is not available");
+  uncompressWith(State, Format::Zlib);
+}
+BENCHMARK(BM_ZlibUncompress)->Unit(benchmark::kMillisecond);
+
+static void BM_ZstdUncompress(benchmark::State &State) {
+  if (!zstd::isAvailable())
+    return State.SkipWithError("zstd is not available");
+  uncompressWith(State, Format::Zstd);
+}
+BENCHMARK(BM_ZstdUncompress)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,60 @@
+#include "benchmark/benchmark.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Support/SHA1.h"
+#include "llvm/Support/xxhash.h"
+#include <random>
+#include <vector>
+
+using namespace llvm;
+
+// Random bytes shared by all benchmarks, sized for the largest argument.
+static ArrayRef<uint8_t> getInput(size_t Size) {
+  static std::vector<uint8_t> Data;
+  if (Data.size() < Size) {
+    std::mt19937_64 Gen(42);
+    Data.resize(alignTo(Size, 8));
+    for (size_t I = 0; I < Data.size(); I += 8)
+      support::endian::write64le(&Data[I], Gen());
+  }
+  return makeArrayRef(Data).take_front(Size);
+}
+
+template <typename HashFn>
+static void hashWith(benchmark::State &State, HashFn Hash) {
+  ArrayRef<uint8_t> Input = getInput(State.range(0));
+  for (auto _ : State)
+    benchmark::DoNotOptimize(Hash(Input));
+  State.SetBytesProcessed(State.iterations() * Input.size());
+}
+
+static void BM_MD5(benchmark::State &State) {
+  hashWith(State, [](ArrayRef<uint8_t> Data) { return MD5::hash(Data); });
+}
+
+static void BM_SHA1(benchmark::State &State) {
+  hashWith(State, [](ArrayRef<uint8_t> Data) { return SHA1::hash(Data); });
+}
+
+static void BM_xxHash64(benchmark::State &State) {
+  hashWith(State, [](ArrayRef<uint8_t> Data) { return xxHash64(Data); });
+}
+
+static void BM_xxh3_64bits(benchmark::State &State) {
+  hashWith(State, [](ArrayRef<uint8_t> Data) { return xxh3_64bits(Data); });
+}
+
+// From a short string up to the size of a large output file. Pass
+// --benchmark_filter to restrict a run to the sizes of interest.
+#define HASH_BENCHMARK(Name)                                                   \
+  BENCHMARK(Name)->Arg(64)->Arg(4 << 10)->Arg(1 << 20)->Arg(1 << 30)->Arg(     \
+      int64_t(4) << 30)
+
+HASH_BENCHMARK(BM_MD5);
+HASH_BENCHMARK(BM_SHA1);
+HASH_BENCHMARK(BM_xxHash64);
+HASH_BENCHMARK(BM_xxh3_64bits);
+
+BENCHMARK_MAIN();
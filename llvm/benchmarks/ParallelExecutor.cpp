@@ -0,0 +1,85 @@
+#include "benchmark/benchmark.h"
+#include "llvm/Support/Parallel.h"
+#include <atomic>
+#include <random>
+#include <vector>
+
+using namespace llvm;
+
+// Some work whose cost grows linearly with Iterations and which the compiler
+// cannot optimize away.
+static uint64_t spin(uint64_t Seed, int64_t Iterations) {
+  for (int64_t I = 0; I < Iterations; ++I)
+    Seed = Seed * 6364136223846793005ULL + 1442695040888963407ULL;
+  return Seed;
+}
+
+// Many tiny tasks: measures the per-task overhead of the executor.
+static void BM_ParallelForEachFine(benchmark::State &State) {
+  std::vector<uint64_t> V(State.range(0));
+  for (auto _ : State) {
+    for_each_n(parallel::par, size_t(0), V.size(),
+               [&](size_t I) { V[I] = spin(I, 1); });
+    benchmark::DoNotOptimize(V.data());
+  }
+  State.SetItemsProcessed(State.iterations() * V.size());
+}
+BENCHMARK(BM_ParallelForEachFine)->Range(1 << 10, 1 << 20);
+
+// Few long tasks: measures load balancing.
+static void BM_ParallelForEachCoarse(benchmark::State &State) {
+  std::vector<uint64_t> V(64);
+  for (auto _ : State) {
+    for_each_n(parallel::par, size_t(0), V.size(),
+               [&](size_t I) { V[I] = spin(I, State.range(0)); });
+    benchmark::DoNotOptimize(V.data());
+  }
+  State.SetItemsProcessed(State.iterations() * V.size());
+}
+BENCHMARK(BM_ParallelForEachCoarse)->Range(1 << 10, 1 << 20);
+
+// Tasks of very different sizes, as in linking a mix of small and large
+// input files.
+static void BM_ParallelForEachSkewed(benchmark::State &State) {
+  std::vector<uint64_t> V(State.range(0));
+  for (auto _ : State) {
+    for_each_n(parallel::par, size_t(0), V.size(), [&](size_t I) {
+      V[I] = spin(I, (I % 64 == 0) ? 1 << 14 : 16);
+    });
+    benchmark::DoNotOptimize(V.data());
+  }
+  State.SetItemsProcessed(State.iterations() * V.size());
+}
+BENCHMARK(BM_ParallelForEachSkewed)->Range(1 << 10, 1 << 16);
+
+// Parallel loops nested inside parallel loops.
+static void BM_ParallelForEachNested(benchmark::State &State) {
+  std::atomic<uint64_t> Sum{0};
+  for (auto _ : State) {
+    for_each_n(parallel::par, size_t(0), size_t(64), [&](size_t I) {
+      for_each_n(parallel::par, size_t(0), size_t(State.range(0)),
+                 [&](size_t J) { Sum += spin(I * J, 16); });
+    });
+  }
+  benchmark::DoNotOptimize(Sum.load());
+  State.SetItemsProcessed(State.iterations() * 64 * State.range(0));
+}
+BENCHMARK(BM_ParallelForEachNested)->Range(1 << 6, 1 << 12);
+
+static void BM_ParallelSort(benchmark::State &State) {
+  std::mt19937 RandEngine;
+  std::vector<uint32_t> Input(State.range(0));
+  for (uint32_t &I : Input)
+    I = RandEngine();
+  for (auto _ : State) {
+    State.PauseTiming();
+    std::vector<uint32_t> V = Input;
+    State.ResumeTiming();
+    sort(parallel::par, V.begin(), V.end());
+    benchmark::DoNotOptimize(V.data());
+  }
+  State.SetItemsProcessed(State.iterations() * Input.size());
+}
+BENCHMARK(BM_ParallelSort)->Range(1 << 12, 1 << 22);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,88 @@
+#include "benchmark/benchmark.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/FileUtilities.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace llvm;
+
+// Write about 64 MiB of text shaped like llc's assembly output: short
+// tab-separated lines built from many small writes.
+static size_t emitAssembly(raw_ostream &OS) {
+  uint64_t Start = OS.tell();
+  for (unsigned I = 0; OS.tell() - Start < (64 << 20); ++I) {
+    OS << "\tmovq\t" << (I % 512) * 8 << "(%rsp), %rax\n";
+    OS << "\taddq\t$" << I << ", %rax\n";
+    OS << ".LBB" << I / 8 << '_' << I % 8 << ":\n";
+  }
+  return OS.tell() - Start;
+}
+
+static void writeFile(benchmark::State &State, bool Background,
+                      size_t BufferSize) {
+  int FD;
+  SmallString<64> Path;
+  if (sys::fs::createTemporaryFile("RawOstream", "s", FD, Path)) {
+    State.SkipWithError("cannot create temporary file");
+    return;
+  }
+  FileRemover Cleanup(Path);
+  raw_fd_ostream OS(FD, /*shouldClose=*/true);
+  if (Background)
+    OS.enableBackgroundWrites();
+  else if (BufferSize)
+    OS.SetBufferSize(BufferSize);
+
+  size_t Bytes = 0;
+  for (auto _ : State) {
+    OS.seek(0);
+    Bytes += emitAssembly(OS);
+    OS.flush();
+  }
+  OS.close();
+  State.SetBytesProcessed(Bytes);
+}
+
+static void BM_WriteBuffered4K(benchmark::State &State) {
+  writeFile(State, /*Background=*/false, 4096);
+}
+BENCHMARK(BM_WriteBuffered4K)->Unit(benchmark::kMillisecond);
+
+static void BM_WriteBufferedDefault(benchmark::State &State) {
+  writeFile(State, /*Background=*/false, 0);
+}
+BENCHMARK(BM_WriteBufferedDefault)->Unit(benchmark::kMillisecond);
+
+static void BM_WriteBackground(benchmark::State &State) {
+  writeFile(State, /*Background=*/true, 0);
+}
+BENCHMARK(BM_WriteBackground)->Unit(benchmark::kMillisecond);
+
+// Patch the size field of each record after writing it, like MC does for
+// section headers, while the record is still buffered.
+static void BM_Pwrite(benchmark::State &State) {
+  int FD;
+  SmallString<64> Path;
+  if (sys::fs::createTemporaryFile("RawOstream", "o", FD, Path)) {
+    State.SkipWithError("cannot create temporary file");
+    return;
+  }
+  FileRemover Cleanup(Path);
+  raw_fd_ostream OS(FD, /*shouldClose=*/true);
+  std::string Payload(200, 'x');
+  for (auto _ : State) {
+    OS.seek(0);
+    for (unsigned I = 0; I < 100000; ++I) {
+      uint64_t Offset = OS.tell();
+      OS.write_zeros(4);
+      OS << Payload;
+      uint32_t Size = Payload.size();
+      OS.pwrite(reinterpret_cast<const char *>(&Size), 4, Offset);
+    }
+    OS.flush();
+  }
+  OS.close();
+}
+BENCHMARK(BM_Pwrite)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,91 @@
+#include "benchmark/benchmark.h"
+#include "llvm/ADT/CachedHashString.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/FlatStringMap.h"
+#include "llvm/ADT/StringMap.h"
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace llvm;
+
+// Names shaped like a linker's symbol table: a mix of short C names and long
+// mangled C++ names sharing common prefixes.
+static const std::vector<std::string> &getNames(size_t N) {
+  static std::vector<std::string> Names;
+  if (Names.size() < N) {
+    std::mt19937 Gen(42);
+    std::uniform_int_distribution<int> Kind(0, 3);
+    for (size_t I = Names.size(); I < N; ++I) {
+      std::string Id = std::to_string(Gen());
+      if (Kind(Gen) == 0)
+        Names.push_back("sym" + Id);
+      else
+        Names.push_back("_ZN4llvm" + std::to_string(Id.size()) + "Obj" + Id +
+                        "E8getValueEv");
+    }
+  }
+  return Names;
+}
+
+template <typename MapTy> struct MapTraits {
+  static void insert(MapTy &M, StringRef Key, int V) { M.try_emplace(Key, V); }
+  static bool contains(const MapTy &M, StringRef Key) { return M.count(Key); }
+};
+
+template <> struct MapTraits<DenseMap<CachedHashStringRef, int>> {
+  using MapTy = DenseMap<CachedHashStringRef, int>;
+  static void insert(MapTy &M, StringRef Key, int V) {
+    M.try_emplace(CachedHashStringRef(Key), V);
+  }
+  static bool contains(const MapTy &M, StringRef Key) {
+    return M.count(CachedHashStringRef(Key));
+  }
+};
+
+template <typename MapTy> static void BM_Insert(benchmark::State &State) {
+  const std::vector<std::string> &Names = getNames(State.range(0));
+  for (auto _ : State) {
+    MapTy M;
+    for (int I = 0, E = State.range(0); I != E; ++I)
+      MapTraits<MapTy>::insert(M, Names[I], I);
+    benchmark::DoNotOptimize(M);
+  }
+  State.SetItemsProcessed(State.iterations() * State.range(0));
+}
+
+// Look up every name and as many names that are not in the map. The queries
+// are copies, as names usually come from a different file than the one that
+// inserted them.
+template <typename MapTy> static void BM_Lookup(benchmark::State &State) {
+  size_t N = State.range(0);
+  const std::vector<std::string> &Names = getNames(2 * N);
+  std::vector<std::string> Queries(Names.begin(), Names.begin() + 2 * N);
+  MapTy M;
+  for (size_t I = 0; I != N; ++I)
+    MapTraits<MapTy>::insert(M, Names[I], I);
+  for (auto _ : State) {
+    size_t Found = 0;
+    for (const std::string &Q : Queries)
+      Found += MapTraits<MapTy>::contains(M, Q);
+    benchmark::DoNotOptimize(Found);
+  }
+  State.SetItemsProcessed(State.iterations() * 2 * N);
+}
+
+using CachedHashMap = DenseMap<CachedHashStringRef, int>;
+using BumpFlatStringMap = FlatStringMap<int, BumpPtrAllocator>;
+
+#define MAP_BENCHMARK(Name, MapTy)                                             \
+  BENCHMARK_TEMPLATE(Name, MapTy)->Arg(1 << 10)->Arg(1 << 16)->Arg(1 << 20)
+
+MAP_BENCHMARK(BM_Insert, StringMap<int>);
+MAP_BENCHMARK(BM_Insert, CachedHashMap);
+MAP_BENCHMARK(BM_Insert, FlatStringMap<int>);
+MAP_BENCHMARK(BM_Insert, BumpFlatStringMap);
+MAP_BENCHMARK(BM_Lookup, StringMap<int>);
+MAP_BENCHMARK(BM_Lookup, CachedHashMap);
+MAP_BENCHMARK(BM_Lookup, FlatStringMap<int>);
+MAP_BENCHMARK(BM_Lookup, BumpFlatStringMap);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,83 @@
+#include "benchmark/benchmark.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/LineIterator.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include <random>
+#include <string>
+
+using namespace llvm;
+
+// About 1 MiB of text that looks like LLVM IR: lines of 20 to 100 characters
+// drawn from a small vocabulary.
+static const std::string &getText() {
+  static std::string Text = [] {
+    static const char *const Words[] = {
+        "%0",   "%call", "=",     "load",  "i32,",     "i32*", "align", "4",
+        "store", "br",   "label", "%bb",   "getelementptr", "inbounds",
+        "ret",  "void",  "call",  "@llvm", "!dbg",     "!12",  "phi",   "icmp"};
+    std::string S;
+    raw_string_ostream OS(S);
+    std::mt19937 Gen(42);
+    std::uniform_int_distribution<int> Word(0, array_lengthof(Words) - 1);
+    std::uniform_int_distribution<int> LineLength(20, 100);
+    while (OS.tell() < (1 << 20)) {
+      OS << "  ";
+      for (int Len = LineLength(Gen), I = 0; I < Len;) {
+        StringRef W = Words[Word(Gen)];
+        OS << W << ' ';
+        I += W.size() + 1;
+      }
+      OS << '\n';
+    }
+    OS.flush();
+    return S;
+  }();
+  return Text;
+}
+
+static void BM_CountChar(benchmark::State &State) {
+  StringRef Text = getText();
+  for (auto _ : State)
+    benchmark::DoNotOptimize(Text.count('\n'));
+  State.SetBytesProcessed(State.iterations() * Text.size());
+}
+BENCHMARK(BM_CountChar);
+
+// Search for a needle of the given length that does not occur in the text.
+static void BM_FindString(benchmark::State &State) {
+  StringRef Text = getText();
+  std::string Needle(State.range(0) - 1, 'a');
+  Needle = "%" + Needle;
+  for (auto _ : State)
+    benchmark::DoNotOptimize(Text.find(Needle));
+  State.SetBytesProcessed(State.iterations() * Text.size());
+}
+BENCHMARK(BM_FindString)->RangeMultiplier(2)->Range(2, 64);
+
+// Search for any of the given number of characters, none of which occur in
+// the text.
+static void BM_FindFirstOf(benchmark::State &State) {
+  StringRef Text = getText();
+  std::string Chars = StringRef("ABCDEFGHIJKLMNOPQRSTUVWXYZ").take_front(
+      State.range(0));
+  for (auto _ : State)
+    benchmark::DoNotOptimize(Text.find_first_of(Chars));
+  State.SetBytesProcessed(State.iterations() * Text.size());
+}
+BENCHMARK(BM_FindFirstOf)->DenseRange(2, 10, 2)->Arg(16);
+
+static void BM_LineIterator(benchmark::State &State) {
+  std::unique_ptr<MemoryBuffer> Buffer =
+      MemoryBuffer::getMemBuffer(getText(), "Text");
+  for (auto _ : State) {
+    size_t Lines = 0;
+    for (line_iterator I(*Buffer, /*SkipBlanks=*/true, '#'), E; I != E; ++I)
+      ++Lines;
+    benchmark::DoNotOptimize(Lines);
+  }
+  State.SetBytesProcessed(State.iterations() * Buffer->getBufferSize());
+}
+BENCHMARK(BM_LineIterator);
+
+BENCHMARK_MAIN();
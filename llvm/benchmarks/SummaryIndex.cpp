@@ -0,0 +1,114 @@
+#include "benchmark/benchmark.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/IR/FlatSummaryIndex.h"
+#include "llvm/IR/ModuleSummaryIndex.h"
+#include "llvm/Support/raw_ostream.h"
+#include <random>
+
+using namespace llvm;
+
+static const unsigned NumModules = 500;
+static const unsigned NumFunctions = 100;
+static const unsigned NumCalls = 6;
+
+static GlobalValue::GUID getGUID(unsigned Module, unsigned I) {
+  return GlobalValue::getGUID(("f" + Twine(Module) + "_" + Twine(I)).str());
+}
+
+// A combined index of modules of small functions calling functions of other
+// modules, in the bitcode and flat formats.
+static ModuleSummaryIndex &getIndex() {
+  static ModuleSummaryIndex Index = [] {
+    ModuleSummaryIndex Index(/*HaveGVs=*/false);
+    std::mt19937 Gen(42);
+    for (unsigned M = 0; M < NumModules; ++M) {
+      StringRef Path =
+          Index.addModule(("m" + Twine(M) + ".o").str(), M)->first();
+      for (unsigned F = 0; F < NumFunctions; ++F) {
+        std::vector<FunctionSummary::EdgeTy> Calls;
+        for (unsigned C = 0; C < NumCalls; ++C)
+          Calls.push_back(
+              {Index.getOrInsertValueInfo(
+                   getGUID(Gen() % NumModules, Gen() % NumFunctions)),
+               CalleeInfo()});
+        auto FS = std::make_unique<FunctionSummary>(
+            GlobalValueSummary::GVFlags(GlobalValue::ExternalLinkage,
+                                        /*NotEligibleToImport=*/false,
+                                        /*Live=*/true, /*IsLocal=*/false,
+                                        /*CanAutoHide=*/false),
+            /*NumInsts=*/10 + Gen() % 200, FunctionSummary::FFlags{},
+            /*EntryCount=*/0, std::vector<ValueInfo>(), std::move(Calls),
+            std::vector<GlobalValue::GUID>(),
+            std::vector<FunctionSummary::VFuncId>(),
+            std::vector<FunctionSummary::VFuncId>(),
+            std::vector<FunctionSummary::ConstVCall>(),
+            std::vector<FunctionSummary::ConstVCall>());
+        FS->setModulePath(Path);
+        Index.addGlobalValueSummary(Index.getOrInsertValueInfo(getGUID(M, F)),
+                                    std::move(FS));
+      }
+    }
+    return Index;
+  }();
+  return Index;
+}
+
+static const SmallString<0> &getBitcode() {
+  static SmallString<0> Buffer = [] {
+    SmallString<0> Buffer;
+    raw_svector_ostream OS(Buffer);
+    WriteIndexToFile(getIndex(), OS);
+    return Buffer;
+  }();
+  return Buffer;
+}
+
+static const SmallString<0> &getFlat() {
+  static SmallString<0> Buffer = [] {
+    SmallString<0> Buffer;
+    raw_svector_ostream OS(Buffer);
+    writeFlatSummaryIndex(getIndex(), OS);
+    return Buffer;
+  }();
+  return Buffer;
+}
+
+static void BM_ReadBitcodeIndex(benchmark::State &State) {
+  MemoryBufferRef Buffer(getBitcode(), "index");
+  for (auto _ : State) {
+    auto Index = cantFail(getModuleSummaryIndex(Buffer));
+    benchmark::DoNotOptimize(Index->size());
+  }
+  State.SetBytesProcessed(State.iterations() * Buffer.getBufferSize());
+}
+BENCHMARK(BM_ReadBitcodeIndex)->Unit(benchmark::kMillisecond);
+
+static void BM_ReadFlatIndex(benchmark::State &State) {
+  MemoryBufferRef Buffer(getFlat(), "index");
+  for (auto _ : State) {
+    auto Index = cantFail(readFlatSummaryIndex(Buffer));
+    benchmark::DoNotOptimize(Index->size());
+  }
+  State.SetBytesProcessed(State.iterations() * Buffer.getBufferSize());
+}
+BENCHMARK(BM_ReadFlatIndex)->Unit(benchmark::kMillisecond);
+
+// Open the flat index and materialize the summaries of a few GUIDs, as a
+// backend looking up its import candidates does.
+static void BM_LookupFlatIndex(benchmark::State &State) {
+  MemoryBufferRef Buffer(getFlat(), "index");
+  std::mt19937 Gen(1);
+  for (auto _ : State) {
+    auto FSI = cantFail(FlatSummaryIndex::create(Buffer));
+    auto Index = cantFail(FSI->createIndex());
+    for (unsigned I = 0; I < State.range(0); ++I)
+      cantFail(FSI->materialize(
+          getGUID(Gen() % NumModules, Gen() % NumFunctions), *Index));
+    benchmark::DoNotOptimize(Index->size());
+  }
+}
+BENCHMARK(BM_LookupFlatIndex)->Arg(100)->Arg(1000);
+
+BENCHMARK_MAIN();
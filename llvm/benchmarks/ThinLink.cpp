@@ -0,0 +1,221 @@
+#include "benchmark/benchmark.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/IR/ModuleSummaryIndex.h"
+#include "llvm/LTO/LTO.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Transforms/IPO/FunctionImport.h"
+#include <random>
+
+using namespace llvm;
+
+namespace {
+// A combined summary index shaped like the one of a large ThinLTO link:
+// modules of small functions calling functions of other modules and
+// referencing global variables, and linkonce_odr functions defined in many
+// modules.
+struct SyntheticIndex {
+  ModuleSummaryIndex Index{/*HaveGVs=*/false};
+  DenseSet<GlobalValue::GUID> Preserved;
+  DenseMap<GlobalValue::GUID, const GlobalValueSummary *> PrevailingCopy;
+  StringMap<GVSummaryMapTy> ModuleToDefinedGVSummaries;
+
+  SyntheticIndex();
+
+  bool isPrevailing(GlobalValue::GUID GUID, const GlobalValueSummary *S) {
+    auto It = PrevailingCopy.find(GUID);
+    return It == PrevailingCopy.end() || It->second == S;
+  }
+};
+} // end anonymous namespace
+
+static const unsigned NumModules = 2000;
+static const unsigned NumFunctions = 50;
+static const unsigned NumVars = 5;
+static const unsigned NumCalls = 4;
+static const unsigned NumLinkOnce = 2000;
+static const unsigned NumLinkOnceCopies = 10;
+
+static GlobalValue::GUID getGUID(const char *Kind, unsigned Module,
+                                 unsigned I) {
+  return GlobalValue::getGUID((Kind + Twine(Module) + "_" + Twine(I)).str());
+}
+
+SyntheticIndex::SyntheticIndex() {
+  std::mt19937 Gen(42);
+  auto Random = [&](unsigned N) { return Gen() % N; };
+
+  std::vector<StringRef> Paths;
+  for (unsigned M = 0; M < NumModules; ++M)
+    Paths.push_back(
+        Index.addModule(("m" + Twine(M) + ".o").str(), M)->first());
+
+  auto AddFunction = [&](GlobalValue::GUID GUID, unsigned M,
+                         GlobalValue::LinkageTypes Linkage) {
+    std::vector<ValueInfo> Refs = {
+        Index.getOrInsertValueInfo(getGUID("v", M, Random(NumVars)))};
+    std::vector<FunctionSummary::EdgeTy> Calls;
+    for (unsigned C = 0; C < NumCalls; ++C) {
+      // Half of the calls stay in the module.
+      unsigned Callee = Random(2) ? M : Random(NumModules);
+      GlobalValue::GUID CalleeGUID =
+          Random(8) ? getGUID("f", Callee, Random(NumFunctions))
+                    : getGUID("l", 0, Random(NumLinkOnce));
+      Calls.push_back({Index.getOrInsertValueInfo(CalleeGUID), CalleeInfo()});
+    }
+    auto FS = std::make_unique<FunctionSummary>(
+        GlobalValueSummary::GVFlags(Linkage, /*NotEligibleToImport=*/false,
+                                    /*Live=*/false, /*IsLocal=*/false,
+                                    /*CanAutoHide=*/false),
+        /*NumInsts=*/10 + Random(200), FunctionSummary::FFlags{},
+        /*EntryCount=*/0, std::move(Refs), std::move(Calls),
+        std::vector<GlobalValue::GUID>(),
+        std::vector<FunctionSummary::VFuncId>(),
+        std::vector<FunctionSummary::VFuncId>(),
+        std::vector<FunctionSummary::ConstVCall>(),
+        std::vector<FunctionSummary::ConstVCall>());
+    FS->setModulePath(Paths[M]);
+    // The first copy of a linkonce_odr function prevails.
+    if (Linkage == GlobalValue::LinkOnceODRLinkage)
+      PrevailingCopy.insert({GUID, FS.get()});
+    Index.addGlobalValueSummary(Index.getOrInsertValueInfo(GUID),
+                                std::move(FS));
+  };
+
+  for (unsigned M = 0; M < NumModules; ++M) {
+    for (unsigned V = 0; V < NumVars; ++V) {
+      auto GVS = std::make_unique<GlobalVarSummary>(
+          GlobalValueSummary::GVFlags(GlobalValue::ExternalLinkage, false,
+                                      false, false, false),
+          GlobalVarSummary::GVarFlags(/*ReadOnly=*/true, /*WriteOnly=*/true),
+          std::vector<ValueInfo>());
+      GVS->setModulePath(Paths[M]);
+      Index.addGlobalValueSummary(
+          Index.getOrInsertValueInfo(getGUID("v", M, V)), std::move(GVS));
+    }
+    for (unsigned F = 0; F < NumFunctions; ++F)
+      AddFunction(getGUID("f", M, F), M,
+                  Random(4) ? GlobalValue::ExternalLinkage
+                            : GlobalValue::InternalLinkage);
+  }
+  for (unsigned L = 0; L < NumLinkOnce; ++L)
+    for (unsigned C = 0; C < NumLinkOnceCopies; ++C)
+      AddFunction(getGUID("l", 0, L),
+                  (L + C * NumModules / NumLinkOnceCopies) % NumModules,
+                  GlobalValue::LinkOnceODRLinkage);
+
+  // The entry point and a few symbols referenced from native objects.
+  Preserved.insert(getGUID("f", 0, 0));
+  for (unsigned I = 0; I < NumModules; I += 10)
+    Preserved.insert(getGUID("f", I, Random(NumFunctions)));
+
+  Index.collectDefinedGVSummariesPerModule(ModuleToDefinedGVSummaries);
+}
+
+static void computeDeadSymbols(SyntheticIndex &SI) {
+  computeDeadSymbols(SI.Index, SI.Preserved, [](GlobalValue::GUID) {
+    return PrevailingType::Unknown;
+  });
+}
+
+static void computeImports(SyntheticIndex &SI,
+                           StringMap<FunctionImporter::ImportMapTy> &Imports,
+                           StringMap<FunctionImporter::ExportSetTy> &Exports) {
+  ComputeCrossModuleImport(SI.Index, SI.ModuleToDefinedGVSummaries, Imports,
+                           Exports);
+}
+
+static void setParallel(benchmark::State &State) {
+  auto *Opt = static_cast<cl::opt<bool> *>(
+      cl::getRegisteredOptions().lookup("thinlto-parallel-thin-link"));
+  *Opt = State.range(0);
+}
+
+static void BM_ComputeDeadSymbols(benchmark::State &State) {
+  setParallel(State);
+  for (auto _ : State) {
+    State.PauseTiming();
+    auto SI = std::make_unique<SyntheticIndex>();
+    State.ResumeTiming();
+    computeDeadSymbols(*SI);
+    State.PauseTiming();
+    SI.reset();
+    State.ResumeTiming();
+  }
+}
+BENCHMARK(BM_ComputeDeadSymbols)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+
+static void BM_ComputeCrossModuleImport(benchmark::State &State) {
+  setParallel(State);
+  SyntheticIndex SI;
+  computeDeadSymbols(SI);
+  for (auto _ : State) {
+    StringMap<FunctionImporter::ImportMapTy> Imports;
+    StringMap<FunctionImporter::ExportSetTy> Exports;
+    computeImports(SI, Imports, Exports);
+    benchmark::DoNotOptimize(Exports.size());
+  }
+}
+BENCHMARK(BM_ComputeCrossModuleImport)
+    ->Arg(0)
+    ->Arg(1)
+    ->Unit(benchmark::kMillisecond);
+
+static void BM_InternalizeAndPromote(benchmark::State &State) {
+  setParallel(State);
+  for (auto _ : State) {
+    State.PauseTiming();
+    auto SI = std::make_unique<SyntheticIndex>();
+    computeDeadSymbols(*SI);
+    StringMap<FunctionImporter::ImportMapTy> Imports;
+    StringMap<FunctionImporter::ExportSetTy> Exports;
+    computeImports(*SI, Imports, Exports);
+    State.ResumeTiming();
+    thinLTOInternalizeAndPromoteInIndex(
+        SI->Index,
+        [&](StringRef ModulePath, GlobalValue::GUID GUID) {
+          auto It = Exports.find(ModulePath);
+          return (It != Exports.end() && It->second.count(GUID)) ||
+                 SI->Preserved.count(GUID);
+        },
+        [&](GlobalValue::GUID GUID, const GlobalValueSummary *S) {
+          return SI->isPrevailing(GUID, S);
+        });
+    State.PauseTiming();
+    SI.reset();
+    State.ResumeTiming();
+  }
+}
+BENCHMARK(BM_InternalizeAndPromote)
+    ->Arg(0)
+    ->Arg(1)
+    ->Unit(benchmark::kMillisecond);
+
+static void BM_ResolvePrevailing(benchmark::State &State) {
+  setParallel(State);
+  for (auto _ : State) {
+    State.PauseTiming();
+    auto SI = std::make_unique<SyntheticIndex>();
+    computeDeadSymbols(*SI);
+    StringMap<std::map<GlobalValue::GUID, GlobalValue::LinkageTypes>>
+        ResolvedODR;
+    State.ResumeTiming();
+    thinLTOResolvePrevailingInIndex(
+        SI->Index,
+        [&](GlobalValue::GUID GUID, const GlobalValueSummary *S) {
+          return SI->isPrevailing(GUID, S);
+        },
+        [&](StringRef ModulePath, GlobalValue::GUID GUID,
+            GlobalValue::LinkageTypes NewLinkage) {
+          ResolvedODR[ModulePath][GUID] = NewLinkage;
+        },
+        SI->Preserved);
+    State.PauseTiming();
+    SI.reset();
+    State.ResumeTiming();
+  }
+}
+BENCHMARK(BM_ResolvePrevailing)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
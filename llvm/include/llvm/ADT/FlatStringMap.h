@@ -0,0 +1,579 @@
+//===- FlatStringMap.h - Open addressing string map -------------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the FlatStringMap class.
+//
+// FlatStringMap has the interface of StringMap, but stores its entries in the
+// hash table itself instead of allocating each one separately. Next to the
+// entries it keeps one control byte per slot holding seven bits of the key's
+// hash, so a lookup compares a whole group of slots with a few vector
+// instructions and usually reads a single entry. The control bytes are kept
+// apart from the entries, so a lookup touches at least two cache lines: one
+// for the group and one for the entry. Keys of up to
+// FlatStringMapEntry::InlineKeyLength bytes are stored in the entry; longer
+// keys are copied into the allocator, or, if the allocator is
+// FlatStringMapUnownedKeys, referred to where the caller keeps them.
+//
+// Unlike StringMap, entries move when the table grows, so references and
+// iterators are invalidated by every insertion.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_ADT_FLATSTRINGMAP_H
+#define LLVM_ADT_FLATSTRINGMAP_H
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/ADT/iterator.h"
+#include "llvm/Support/Allocator.h"
+#include "llvm/Support/Compiler.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Support/xxhash.h"
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace llvm {
+
+template <typename ValueTy, typename AllocatorTy> class FlatStringMap;
+
+/// Use as the allocator of a FlatStringMap that does not copy its keys. The
+/// map then points to the characters of the keys it is given, which must
+/// outlive it. This saves memory when the keys are kept alive anyway.
+struct FlatStringMapUnownedKeys {};
+
+namespace detail {
+
+/// Return the characters of a long key to store in a FlatStringMap entry.
+template <typename AllocatorTy>
+const char *copyFlatStringMapKey(AllocatorTy &Allocator, StringRef Key) {
+  char *Buf = static_cast<char *>(Allocator.Allocate(Key.size(), 1));
+  memcpy(Buf, Key.data(), Key.size());
+  return Buf;
+}
+inline const char *copyFlatStringMapKey(FlatStringMapUnownedKeys &,
+                                        StringRef Key) {
+  return Key.data();
+}
+
+template <typename AllocatorTy>
+void freeFlatStringMapKey(AllocatorTy &Allocator, const char *Key,
+                          size_t Size) {
+  Allocator.Deallocate(Key, Size);
+}
+inline void freeFlatStringMapKey(FlatStringMapUnownedKeys &, const char *,
+                                 size_t) {}
+
+/// A group of control bytes that are probed together. A control byte is
+/// either Empty, Deleted, or the low seven bits of the hash of the key stored
+/// in the corresponding slot.
+class FlatStringMapGroup {
+public:
+  enum : unsigned { Width = 16 };
+  enum : int8_t { Empty = -128, Deleted = -2 };
+
+  explicit FlatStringMapGroup(const int8_t *Ctrl) {
+#ifdef __SSE2__
+    Bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(Ctrl));
+#else
+    memcpy(Bytes, Ctrl, Width);
+#endif
+  }
+
+  /// Return a mask of the slots whose control byte is \p H2.
+  uint32_t match(int8_t H2) const {
+#ifdef __SSE2__
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(Bytes, _mm_set1_epi8(H2)));
+#else
+    uint32_t Mask = 0;
+    for (unsigned I = 0; I < Width; ++I)
+      Mask |= uint32_t(Bytes[I] == H2) << I;
+    return Mask;
+#endif
+  }
+
+  /// Return a mask of the slots that have never been used.
+  uint32_t matchEmpty() const { return match(Empty); }
+
+  /// Return a mask of the slots that do not hold an entry.
+  uint32_t matchEmptyOrDeleted() const {
+#ifdef __SSE2__
+    return _mm_movemask_epi8(Bytes);
+#else
+    uint32_t Mask = 0;
+    for (unsigned I = 0; I < Width; ++I)
+      Mask |= uint32_t(Bytes[I] < 0) << I;
+    return Mask;
+#endif
+  }
+
+private:
+#ifdef __SSE2__
+  __m128i Bytes;
+#else
+  int8_t Bytes[Width];
+#endif
+};
+
+} // end namespace detail
+
+/// FlatStringMapEntry - A key and its value, stored in a FlatStringMap slot.
+template <typename ValueTy> class FlatStringMapEntry {
+  template <typename, typename> friend class FlatStringMap;
+
+public:
+  enum : size_t { InlineKeyLength = 16 };
+
+  ValueTy second;
+
+  StringRef getKey() const { return StringRef(getKeyData(), KeyLength); }
+  StringRef first() const { return getKey(); }
+  size_t getKeyLength() const { return KeyLength; }
+
+  const ValueTy &getValue() const { return second; }
+  ValueTy &getValue() { return second; }
+  void setValue(const ValueTy &V) { second = V; }
+
+private:
+  template <typename... InitTy>
+  FlatStringMapEntry(uint32_t Hash, StringRef Key, const char *KeyData,
+                     InitTy &&... InitVals)
+      : second(std::forward<InitTy>(InitVals)...), Hash(Hash),
+        KeyLength(Key.size()) {
+    if (isInline())
+      memcpy(Storage.InlineKey, Key.data(), Key.size());
+    else
+      Storage.KeyPtr = KeyData;
+  }
+
+  FlatStringMapEntry(FlatStringMapEntry &&Other)
+      : second(std::move(Other.second)), Hash(Other.Hash),
+        KeyLength(Other.KeyLength), Storage(Other.Storage) {}
+
+  bool isInline() const { return KeyLength <= InlineKeyLength; }
+  const char *getKeyData() const {
+    return isInline() ? Storage.InlineKey : Storage.KeyPtr;
+  }
+
+  /// The full hash of the key, so the table can grow without rehashing keys.
+  uint32_t Hash;
+  uint32_t KeyLength;
+  union {
+    char InlineKey[InlineKeyLength];
+    const char *KeyPtr;
+  } Storage;
+};
+
+template <typename ValueTy, bool IsConst>
+class FlatStringMapIterator
+    : public iterator_facade_base<
+          FlatStringMapIterator<ValueTy, IsConst>, std::forward_iterator_tag,
+          typename std::conditional<IsConst, const FlatStringMapEntry<ValueTy>,
+                                    FlatStringMapEntry<ValueTy>>::type> {
+  template <typename, typename> friend class FlatStringMap;
+  friend class FlatStringMapIterator<ValueTy, true>;
+
+  using EntryTy =
+      typename std::conditional<IsConst, const FlatStringMapEntry<ValueTy>,
+                                FlatStringMapEntry<ValueTy>>::type;
+
+  const int8_t *Ctrl = nullptr;
+  const int8_t *CtrlEnd = nullptr;
+  EntryTy *Entry = nullptr;
+
+  FlatStringMapIterator(const int8_t *Ctrl, const int8_t *CtrlEnd,
+                        EntryTy *Entry, bool NoAdvance = false)
+      : Ctrl(Ctrl), CtrlEnd(CtrlEnd), Entry(Entry) {
+    if (!NoAdvance)
+      AdvancePastEmptyBuckets();
+  }
+
+  void AdvancePastEmptyBuckets() {
+    while (Ctrl != CtrlEnd && *Ctrl < 0) {
+      ++Ctrl;
+      ++Entry;
+    }
+  }
+
+public:
+  FlatStringMapIterator() = default;
+
+  /// Allow conversion from iterator to const_iterator.
+  template <bool WasConst,
+            typename = typename std::enable_if<IsConst && !WasConst>::type>
+  FlatStringMapIterator(const FlatStringMapIterator<ValueTy, WasConst> &I)
+      : Ctrl(I.Ctrl), CtrlEnd(I.CtrlEnd), Entry(I.Entry) {}
+
+  bool operator==(const FlatStringMapIterator &RHS) const {
+    return Entry == RHS.Entry;
+  }
+
+  EntryTy &operator*() const { return *Entry; }
+
+  FlatStringMapIterator &operator++() {
+    ++Ctrl;
+    ++Entry;
+    AdvancePastEmptyBuckets();
+    return *this;
+  }
+};
+
+/// FlatStringMap - A map from strings to values with the interface of
+/// StringMap, implemented as an open addressing table that holds its entries
+/// inline. It is faster than StringMap for lookups and insertions when
+/// clients do not need stable entry addresses.
+template <typename ValueTy, typename AllocatorTy = MallocAllocator>
+class FlatStringMap {
+  using Group = detail::FlatStringMapGroup;
+
+public:
+  using MapEntryTy = FlatStringMapEntry<ValueTy>;
+
+  using key_type = const char *;
+  using mapped_type = ValueTy;
+  using value_type = MapEntryTy;
+  using size_type = size_t;
+
+  using iterator = FlatStringMapIterator<ValueTy, false>;
+  using const_iterator = FlatStringMapIterator<ValueTy, true>;
+
+  FlatStringMap() = default;
+
+  explicit FlatStringMap(unsigned InitialSize) { reserve(InitialSize); }
+
+  explicit FlatStringMap(AllocatorTy A) : Allocator(A) {}
+
+  FlatStringMap(unsigned InitialSize, AllocatorTy A) : Allocator(A) {
+    reserve(InitialSize);
+  }
+
+  FlatStringMap(std::initializer_list<std::pair<StringRef, ValueTy>> List) {
+    reserve(List.size());
+    for (const auto &P : List)
+      insert(P);
+  }
+
+  FlatStringMap(FlatStringMap &&RHS)
+      : Allocator(std::move(RHS.Allocator)) {
+    swapTable(RHS);
+  }
+
+  FlatStringMap(const FlatStringMap &RHS) : Allocator(RHS.Allocator) {
+    reserve(RHS.size());
+    for (const MapEntryTy &E : RHS)
+      insertUnique(E.Hash, E.getKey(), E.getValue());
+  }
+
+  FlatStringMap &operator=(FlatStringMap RHS) {
+    swapTable(RHS);
+    std::swap(Allocator, RHS.Allocator);
+    return *this;
+  }
+
+  ~FlatStringMap() {
+    destroyAll();
+    if (NumSlots)
+      deallocate_buffer(Slots, getBufferSize(NumSlots), alignof(MapEntryTy));
+  }
+
+  AllocatorTy &getAllocator() { return Allocator; }
+  const AllocatorTy &getAllocator() const { return Allocator; }
+
+  bool empty() const { return NumItems == 0; }
+  unsigned size() const { return NumItems; }
+  unsigned getNumBuckets() const { return NumSlots; }
+
+  iterator begin() { return iterator(Ctrl, Ctrl + NumSlots, Slots); }
+  iterator end() {
+    return iterator(Ctrl + NumSlots, Ctrl + NumSlots, Slots + NumSlots, true);
+  }
+  const_iterator begin() const {
+    return const_iterator(Ctrl, Ctrl + NumSlots, Slots);
+  }
+  const_iterator end() const {
+    return const_iterator(Ctrl + NumSlots, Ctrl + NumSlots, Slots + NumSlots,
+                          true);
+  }
+
+  /// Return the hash of \p Key used by the map.
+  static uint32_t hash(StringRef Key) { return uint32_t(xxh3_64bits(Key)); }
+
+  iterator find(StringRef Key) { return find(Key, hash(Key)); }
+  const_iterator find(StringRef Key) const { return find(Key, hash(Key)); }
+
+  /// Find \p Key given its hash as computed by hash().
+  iterator find(StringRef Key, uint32_t FullHash) {
+    int Slot = findSlot(Key, FullHash);
+    return Slot < 0 ? end() : makeIterator(Slot);
+  }
+  const_iterator find(StringRef Key, uint32_t FullHash) const {
+    int Slot = findSlot(Key, FullHash);
+    return Slot < 0 ? end() : makeIterator(Slot);
+  }
+
+  /// lookup - Return the entry for the specified key, or a default
+  /// constructed value if no such entry exists.
+  ValueTy lookup(StringRef Key) const {
+    int Slot = findSlot(Key, hash(Key));
+    return Slot < 0 ? ValueTy() : Slots[Slot].second;
+  }
+
+  /// Lookup the ValueTy for the \p Key, or create a default constructed value
+  /// if the key is not in the map.
+  ValueTy &operator[](StringRef Key) { return try_emplace(Key).first->second; }
+
+  /// count - Return 1 if the element is in the map, 0 otherwise.
+  size_type count(StringRef Key) const {
+    return findSlot(Key, hash(Key)) < 0 ? 0 : 1;
+  }
+
+  /// insert - Inserts the specified key/value pair into the map if the key
+  /// isn't already in the map. The bool component of the returned pair is true
+  /// if and only if the insertion takes place, and the iterator component of
+  /// the pair points to the element with key equivalent to the key of the pair.
+  std::pair<iterator, bool> insert(std::pair<StringRef, ValueTy> KV) {
+    return try_emplace(KV.first, std::move(KV.second));
+  }
+
+  /// Inserts an element or assigns to the current element if the key already
+  /// exists. The return type is the same as try_emplace.
+  template <typename V>
+  std::pair<iterator, bool> insert_or_assign(StringRef Key, V &&Val) {
+    auto Ret = try_emplace(Key, std::forward<V>(Val));
+    if (!Ret.second)
+      Ret.first->second = std::forward<V>(Val);
+    return Ret;
+  }
+
+  /// Emplace a new element for the specified key into the map if the key isn't
+  /// already in the map. The bool component of the returned pair is true
+  /// if and only if the insertion takes place, and the iterator component of
+  /// the pair points to the element with key equivalent to the key of the pair.
+  template <typename... ArgsTy>
+  std::pair<iterator, bool> try_emplace(StringRef Key, ArgsTy &&... Args) {
+    return try_emplace_hash(Key, hash(Key), std::forward<ArgsTy>(Args)...);
+  }
+
+  /// Like try_emplace, given the hash of \p Key as computed by hash().
+  template <typename... ArgsTy>
+  std::pair<iterator, bool> try_emplace_hash(StringRef Key, uint32_t FullHash,
+                                             ArgsTy &&... Args) {
+    int Slot = findSlot(Key, FullHash);
+    if (Slot >= 0)
+      return std::make_pair(makeIterator(Slot), false);
+    Slot = insertUnique(FullHash, Key, std::forward<ArgsTy>(Args)...);
+    return std::make_pair(makeIterator(Slot), true);
+  }
+
+  /// Reserve space for \p Size entries without rehashing.
+  void reserve(size_t Size) {
+    unsigned NewSlots = Group::Width;
+    while (Size > getMaxLoad(NewSlots))
+      NewSlots *= 2;
+    if (NewSlots > NumSlots)
+      rehash(NewSlots);
+  }
+
+  // clear - Empties out the FlatStringMap
+  void clear() {
+    if (empty() && !NumTombstones)
+      return;
+    destroyAll();
+    memset(Ctrl, Group::Empty, NumSlots);
+    NumItems = 0;
+    NumTombstones = 0;
+  }
+
+  void erase(iterator I) {
+    unsigned Slot = I.Entry - Slots;
+    destroyEntry(Slots[Slot]);
+    --NumItems;
+
+    // A lookup only moves on from a group that has never had an empty slot
+    // since the last rehash. If this group still has one, no key has probed
+    // past it and the slot can be reused as if it had never been filled.
+    unsigned GroupStart = Slot & ~(Group::Width - 1);
+    if (Group(Ctrl + GroupStart).matchEmpty()) {
+      Ctrl[Slot] = Group::Empty;
+    } else {
+      Ctrl[Slot] = Group::Deleted;
+      ++NumTombstones;
+    }
+  }
+
+  bool erase(StringRef Key) {
+    iterator I = find(Key);
+    if (I == end())
+      return false;
+    erase(I);
+    return true;
+  }
+
+private:
+  MapEntryTy *Slots = nullptr;
+  int8_t *Ctrl = nullptr;
+  unsigned NumSlots = 0;
+  unsigned NumItems = 0;
+  unsigned NumTombstones = 0;
+  AllocatorTy Allocator;
+
+  /// The table grows once 7/8 of its slots are used or deleted.
+  static unsigned getMaxLoad(unsigned NumSlots) {
+    return NumSlots - NumSlots / 8;
+  }
+
+  /// Entries and control bytes share a single allocation.
+  static size_t getBufferSize(unsigned NumSlots) {
+    return size_t(NumSlots) * (sizeof(MapEntryTy) + 1);
+  }
+
+  static int8_t getH2(uint32_t FullHash) { return FullHash & 0x7f; }
+
+  iterator makeIterator(unsigned Slot) {
+    return iterator(Ctrl + Slot, Ctrl + NumSlots, Slots + Slot, true);
+  }
+  const_iterator makeIterator(unsigned Slot) const {
+    return const_iterator(Ctrl + Slot, Ctrl + NumSlots, Slots + Slot, true);
+  }
+
+  /// Visit groups in the probe sequence of \p FullHash until \p Fn returns
+  /// true. Groups are probed quadratically, which visits every group of a
+  /// table with a power of two number of groups.
+  template <typename FnTy> void probe(uint32_t FullHash, FnTy Fn) const {
+    unsigned GroupMask = NumSlots / Group::Width - 1;
+    unsigned GroupNo = (FullHash >> 7) & GroupMask;
+    for (unsigned Step = 1;; ++Step) {
+      if (Fn(GroupNo * Group::Width))
+        return;
+      GroupNo = (GroupNo + Step) & GroupMask;
+    }
+  }
+
+  /// Return the slot holding \p Key, or -1 if it is not in the map.
+  int findSlot(StringRef Key, uint32_t FullHash) const {
+    if (NumItems == 0)
+      return -1;
+    int Result = -1;
+    int8_t H2 = getH2(FullHash);
+    probe(FullHash, [&](unsigned GroupStart) {
+      Group G(Ctrl + GroupStart);
+      for (uint32_t Mask = G.match(H2); Mask; Mask &= Mask - 1) {
+        unsigned Slot = GroupStart + countTrailingZeros(Mask);
+        const MapEntryTy &E = Slots[Slot];
+        if (E.Hash == FullHash && E.getKey() == Key) {
+          Result = Slot;
+          return true;
+        }
+      }
+      return G.matchEmpty() != 0;
+    });
+    return Result;
+  }
+
+  /// Return the first free slot in the probe sequence of \p FullHash.
+  unsigned findFreeSlot(uint32_t FullHash) const {
+    unsigned Result = 0;
+    probe(FullHash, [&](unsigned GroupStart) {
+      uint32_t Mask = Group(Ctrl + GroupStart).matchEmptyOrDeleted();
+      if (!Mask)
+        return false;
+      Result = GroupStart + countTrailingZeros(Mask);
+      return true;
+    });
+    return Result;
+  }
+
+  /// Add \p Key, which must not be in the map yet, and return its slot.
+  template <typename... ArgsTy>
+  unsigned insertUnique(uint32_t FullHash, StringRef Key, ArgsTy &&... Args) {
+    assert(Key.size() <= UINT32_MAX && "key too long for FlatStringMap");
+    if (NumItems + NumTombstones >= getMaxLoad(NumSlots)) {
+      // Grow if the table is mostly live entries, otherwise just drop the
+      // tombstones.
+      if (NumItems >= getMaxLoad(NumSlots) / 2)
+        rehash(NumSlots ? NumSlots * 2 : Group::Width);
+      else
+        rehash(NumSlots);
+    }
+
+    unsigned Slot = findFreeSlot(FullHash);
+    if (Ctrl[Slot] == Group::Deleted)
+      --NumTombstones;
+    Ctrl[Slot] = getH2(FullHash);
+
+    const char *KeyData = nullptr;
+    if (Key.size() > MapEntryTy::InlineKeyLength)
+      KeyData = detail::copyFlatStringMapKey(Allocator, Key);
+    new (&Slots[Slot])
+        MapEntryTy(FullHash, Key, KeyData, std::forward<ArgsTy>(Args)...);
+    ++NumItems;
+    return Slot;
+  }
+
+  /// Move all entries into a new table with \p NewSlots slots.
+  void rehash(unsigned NewSlots) {
+    assert(isPowerOf2_32(NewSlots) && NewSlots >= Group::Width);
+    MapEntryTy *OldSlots = Slots;
+    int8_t *OldCtrl = Ctrl;
+    unsigned OldNumSlots = NumSlots;
+
+    Slots = static_cast<MapEntryTy *>(
+        allocate_buffer(getBufferSize(NewSlots), alignof(MapEntryTy)));
+    Ctrl = reinterpret_cast<int8_t *>(Slots + NewSlots);
+    NumSlots = NewSlots;
+    NumTombstones = 0;
+    memset(Ctrl, Group::Empty, NewSlots);
+
+    for (unsigned I = 0; I != OldNumSlots; ++I) {
+      if (OldCtrl[I] < 0)
+        continue;
+      MapEntryTy &E = OldSlots[I];
+      unsigned Slot = findFreeSlot(E.Hash);
+      Ctrl[Slot] = OldCtrl[I];
+      new (&Slots[Slot]) MapEntryTy(std::move(E));
+      E.~MapEntryTy();
+    }
+
+    if (OldNumSlots)
+      deallocate_buffer(OldSlots, getBufferSize(OldNumSlots),
+                        alignof(MapEntryTy));
+  }
+
+  void destroyEntry(MapEntryTy &E) {
+    if (!E.isInline())
+      detail::freeFlatStringMapKey(Allocator, E.Storage.KeyPtr, E.KeyLength);
+    E.~MapEntryTy();
+  }
+
+  void destroyAll() {
+    if (empty())
+      return;
+    for (unsigned I = 0; I != NumSlots; ++I)
+      if (Ctrl[I] >= 0)
+        destroyEntry(Slots[I]);
+  }
+
+  void swapTable(FlatStringMap &Other) {
+    std::swap(Slots, Other.Slots);
+    std::swap(Ctrl, Other.Ctrl);
+    std::swap(NumSlots, Other.NumSlots);
+    std::swap(NumItems, Other.NumItems);
+    std::swap(NumTombstones, Other.NumTombstones);
+  }
+};
+
+} // end namespace llvm
+
+#endif // LLVM_ADT_FLATSTRINGMAP_H
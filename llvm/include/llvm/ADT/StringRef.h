@@ -474,13 +474,7 @@ namespace llvm {
 
     /// Return the number of occurrences of \p C in the string.
     LLVM_NODISCARD
-    size_t count(char C) const {
-      size_t Count = 0;
-      for (size_t i = 0, e = Length; i != e; ++i)
-        if (Data[i] == C)
-          ++Count;
-      return Count;
-    }
+    size_t count(char C) const;
 
     /// Return the number of non-overlapped occurrences of \p Str in
     /// the string.
@@ -331,6 +331,41 @@ struct BitstreamEntry {
   }
 };
 
+/// The contents of a block, including its nested blocks, decoded by
+/// BitstreamCursor::decodeBlock. Decoding only reads the bitstream and the
+/// block info, so several blocks can be decoded concurrently by separate
+/// cursors. A cursor can later replay the decoded entries as if it were
+/// reading them from the bitstream.
+class DecodedBitstreamBlock {
+  friend class BitstreamCursor;
+
+  struct Entry {
+    /// The block ID of a SubBlock, or the code of a Record.
+    unsigned ID;
+    /// The number of operands of a Record, or the size in words of a
+    /// SubBlock.
+    unsigned NumOps;
+    /// The BitstreamEntry kind.
+    uint8_t Kind;
+    /// Whether a Record ends with a blob. The blob's offset and size follow
+    /// the other operands.
+    bool HasBlob;
+  };
+
+  /// The entries in stream order. The first entry is the block itself, and
+  /// the last one is its EndBlock.
+  std::vector<Entry> Entries;
+  SmallVector<uint64_t, 0> Ops;
+
+public:
+  bool empty() const { return Entries.empty(); }
+
+  void clear() {
+    Entries.clear();
+    Ops.clear();
+  }
+};
+
 /// This represents a position within a bitcode file, implemented on top of a
 /// SimpleBitstreamCursor.
 ///
@@ -356,6 +391,15 @@ class BitstreamCursor : SimpleBitstreamCursor {
 
   BitstreamBlockInfo *BlockInfo = nullptr;
 
+  /// The decoded block being replayed in place of the bitstream, if any.
+  const DecodedBitstreamBlock *Replay = nullptr;
+  /// The next entry to replay and the index of its first operand.
+  size_t ReplayEntry = 0, ReplayOp = 0;
+  /// The last replayed entry and the index of its first operand.
+  size_t ReplayCur = 0, ReplayCurOp = 0;
+  /// The number of replayed blocks that were entered but have not ended.
+  unsigned ReplayDepth = 0;
+
 public:
   static const size_t MaxChunkSize = sizeof(word_t) * 8;
 
@@ -374,13 +418,18 @@ public:
   using SimpleBitstreamCursor::GetCurrentBitNo;
   using SimpleBitstreamCursor::getCurrentByteNo;
   using SimpleBitstreamCursor::getPointerToByte;
-  using SimpleBitstreamCursor::JumpToBit;
   using SimpleBitstreamCursor::Read;
   using SimpleBitstreamCursor::ReadVBR;
   using SimpleBitstreamCursor::ReadVBR64;
   using SimpleBitstreamCursor::SizeInBytes;
   using SimpleBitstreamCursor::skipToEnd;
 
+  /// Reset the stream to the specified bit number. This ends any replay.
+  Error JumpToBit(uint64_t BitNo) {
+    endReplay();
+    return SimpleBitstreamCursor::JumpToBit(BitNo);
+  }
+
   /// Return the number of bits used to encode an abbrev #.
   unsigned getAbbrevIDWidth() const { return CurCodeSize; }
 
@@ -397,6 +446,9 @@ public:
 
   /// Advance the current bitstream, returning the next entry in the stream.
   Expected<BitstreamEntry> advance(unsigned Flags = 0) {
+    if (LLVM_UNLIKELY(Replay))
+      return advanceReplay(Flags);
+
     while (true) {
       if (AtEndOfStream())
         return BitstreamEntry::getError();
@@ -452,7 +504,11 @@ public:
     }
   }
 
-  Expected<unsigned> ReadCode() { return Read(CurCodeSize); }
+  Expected<unsigned> ReadCode() {
+    if (LLVM_UNLIKELY(Replay))
+      return readReplayedCode();
+    return Read(CurCodeSize);
+  }
 
   // Block header:
   //    [ENTER_SUBBLOCK, blockid, newcodelen, <align4bytes>, blocklen]
@@ -463,6 +519,11 @@ public:
   /// Having read the ENTER_SUBBLOCK abbrevid and a BlockID, skip over the body
   /// of this block.
   Error SkipBlock() {
+    if (LLVM_UNLIKELY(Replay)) {
+      skipReplayedBlock();
+      return Error::success();
+    }
+
     // Read and ignore the codelen value.
     if (Expected<uint32_t> Res = ReadVBR(bitc::CodeLenWidth))
       ; // Since we are skipping this block, we don't care what code widths are
@@ -497,6 +558,11 @@ public:
   Error EnterSubBlock(unsigned BlockID, unsigned *NumWordsP = nullptr);
 
   bool ReadBlockEnd() {
+    if (LLVM_UNLIKELY(Replay)) {
+      endReplayedBlock();
+      return false;
+    }
+
     if (BlockScope.empty()) return true;
 
     // Block tail:
@@ -507,7 +573,46 @@ public:
     return false;
   }
 
+  /// Having read the ENTER_SUBBLOCK abbrevid and \p BlockID, decode the whole
+  /// block, including its nested blocks, into \p Decoded. The cursor is left
+  /// after the end of the block.
+  ///
+  /// Records are decoded with their blob, if any, as a blob rather than as
+  /// operands. A block whose abbreviations have a blob before other operands
+  /// is rejected.
+  Error decodeBlock(unsigned BlockID, DecodedBitstreamBlock &Decoded);
+
+  /// Replay \p Decoded in place of the bitstream, as if the cursor had just
+  /// read the ENTER_SUBBLOCK abbrevid and block ID of the decoded block. The
+  /// next call should be EnterSubBlock() or SkipBlock().
+  ///
+  /// advance(), readRecord() and the other functions for walking blocks and
+  /// records return the decoded entries until the decoded block ends, or
+  /// until JumpToBit() is called. The stream position and block scope are
+  /// left as they were. \p Decoded must outlive the replay.
+  void replay(const DecodedBitstreamBlock &Decoded) {
+    assert(!Decoded.empty() && "Cannot replay an empty block");
+    Replay = &Decoded;
+    ReplayEntry = 1;
+    ReplayOp = 0;
+    ReplayCur = 0;
+    ReplayCurOp = 0;
+    ReplayDepth = 0;
+  }
+
+  /// Return true if the cursor is replaying a decoded block.
+  bool isReplaying() const { return Replay != nullptr; }
+
+  /// Stop replaying and go back to reading the bitstream.
+  void endReplay() { Replay = nullptr; }
+
 private:
+  BitstreamEntry advanceReplay(unsigned Flags);
+  Expected<unsigned> readReplayedCode();
+  unsigned readReplayedRecord(SmallVectorImpl<uint64_t> *Vals, StringRef *Blob);
+  void skipReplayedBlock();
+  void endReplayedBlock();
+
   void popBlockScope() {
     CurCodeSize = BlockScope.back().PrevCodeSize;
 
@@ -0,0 +1,172 @@
+//===- llvm/IR/FlatSummaryIndex.h - Flat summary index format ---*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+/// \file
+/// This file declares the reader and writer of the flat summary index format,
+/// an alternative to the bitcode encoding of the combined summary index for
+/// the per-module index files of distributed ThinLTO backends.
+///
+/// A flat index is made of fixed-size little-endian tables that can be used
+/// directly from a memory mapped file: a table of module paths, a table of
+/// GUIDs sorted for binary search, and for each GUID its summary records, in
+/// which references and calls are indices into the GUID table. A backend can
+/// look up the summaries of a GUID without decoding the rest of the index, and
+/// the whole index is materialized without any bitstream decoding.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_IR_FLATSUMMARYINDEX_H
+#define LLVM_IR_FLATSUMMARYINDEX_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/Optional.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/IR/ModuleSummaryIndex.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace llvm {
+
+class raw_ostream;
+
+namespace flatsummary {
+
+/// The first bytes of a flat summary index.
+constexpr char Magic[8] = {'\xff', 'L', 'L', 'V', 'M', 'F', 'S', 'I'};
+
+/// Incremented for any change to the layout of the file.
+constexpr uint32_t Version = 1;
+
+/// The header of the file. Offsets are from the start of the file and sizes
+/// are in bytes.
+struct Header {
+  char Magic[8];
+  support::ulittle32_t Version;
+  /// The index flags, encoded as in the bitcode FS_FLAGS record.
+  support::ulittle32_t Flags;
+  support::ulittle32_t NumModules;
+  support::ulittle32_t NumValues;
+  /// Table of ModuleEntry.
+  support::ulittle32_t ModulesOffset;
+  /// Table of ValueEntry, sorted by GUID.
+  support::ulittle32_t ValuesOffset;
+  /// Summary records of the values.
+  support::ulittle32_t SummariesOffset;
+  support::ulittle32_t SummariesSize;
+  /// The CFI function names and type identifier summaries.
+  support::ulittle32_t GlobalsOffset;
+  support::ulittle32_t GlobalsSize;
+  /// Strings referenced by offset and size from the other sections.
+  support::ulittle32_t StringsOffset;
+  support::ulittle32_t StringsSize;
+};
+
+struct ModuleEntry {
+  support::ulittle64_t ModuleId;
+  support::ulittle32_t PathOffset;
+  support::ulittle32_t PathSize;
+  support::ulittle32_t Hash[5];
+  support::ulittle32_t Padding;
+};
+
+struct ValueEntry {
+  support::ulittle64_t GUID;
+  /// Offset of the first summary record of the value in the summaries
+  /// section.
+  support::ulittle32_t SummariesOffset;
+  support::ulittle32_t NumSummaries;
+};
+
+} // end namespace flatsummary
+
+/// A flat summary index in a memory buffer. The buffer is not copied and
+/// must outlive this object, which only decodes the parts of the index it is
+/// asked for.
+class FlatSummaryIndex {
+public:
+  /// Return true if \p Buffer starts with the magic of a flat summary index.
+  static bool isFlatSummaryIndex(MemoryBufferRef Buffer);
+
+  /// Check the header and the tables of the index in \p Buffer. Summary
+  /// records are only checked when they are materialized.
+  static Expected<std::unique_ptr<FlatSummaryIndex>>
+  create(MemoryBufferRef Buffer);
+
+  /// The number of modules, and the path, ID and hash of each.
+  unsigned getNumModules() const { return Modules.size(); }
+  StringRef getModulePath(unsigned I) const;
+  uint64_t getModuleId(unsigned I) const { return Modules[I].ModuleId; }
+  ModuleHash getModuleHash(unsigned I) const;
+
+  /// The number of GUIDs in the index, and the GUID of each in sorted order.
+  unsigned getNumValues() const { return Values.size(); }
+  GlobalValue::GUID getGUID(unsigned I) const { return Values[I].GUID; }
+
+  /// Return the position of \p GUID in the GUID table, if present.
+  Optional<unsigned> findValue(GlobalValue::GUID GUID) const;
+
+  /// Return the number of summaries of \p GUID, without decoding them.
+  unsigned getNumSummaries(GlobalValue::GUID GUID) const;
+
+  /// Create an index holding the module paths, flags, CFI function names and
+  /// type identifier summaries of this index, but no global value summaries.
+  Expected<std::unique_ptr<ModuleSummaryIndex>> createIndex() const;
+
+  /// Add the summaries of \p GUID to \p Index, which must have been created
+  /// by createIndex(), and return its ValueInfo. The values it references get
+  /// a ValueInfo without summaries until they are materialized themselves.
+  /// The aliasee of an alias is materialized with it. Return an empty
+  /// ValueInfo if \p GUID is not in this index.
+  Expected<ValueInfo> materialize(GlobalValue::GUID GUID,
+                                  ModuleSummaryIndex &Index) const;
+
+  /// Add the summaries of all values to \p Index, which must have been
+  /// created by createIndex().
+  Error materializeAll(ModuleSummaryIndex &Index) const;
+
+private:
+  FlatSummaryIndex(MemoryBufferRef Buffer) : Buffer(Buffer) {}
+
+  Expected<StringRef> getString(uint32_t Offset, uint32_t Size) const;
+  /// Add the summaries of the value at \p ValueIndex to \p Index: either its
+  /// alias summaries or all the others, depending on \p Aliases. When
+  /// materializing the whole index, \p ModulePaths and \p ValueInfos hold the
+  /// module paths and ValueInfos of \p Index for each table entry, and the
+  /// values with aliases are added to \p AliasValues.
+  Error materializeValue(unsigned ValueIndex, ModuleSummaryIndex &Index,
+                         ArrayRef<StringRef> ModulePaths,
+                         ArrayRef<ValueInfo> ValueInfos, bool Aliases,
+                         std::vector<unsigned> *AliasValues = nullptr) const;
+
+  MemoryBufferRef Buffer;
+  const flatsummary::Header *Hdr = nullptr;
+  ArrayRef<flatsummary::ModuleEntry> Modules;
+  ArrayRef<flatsummary::ValueEntry> Values;
+  StringRef Summaries, Globals, Strings;
+};
+
+/// Write the specified module summary index to the given raw output stream in
+/// the flat summary index format. Like WriteIndexToFile(), when writing the
+/// index for a distributed backend, only the summaries in
+/// \p ModuleToSummariesForIndex are written.
+void writeFlatSummaryIndex(const ModuleSummaryIndex &Index, raw_ostream &Out,
+                           const std::map<std::string, GVSummaryMapTy>
+                               *ModuleToSummariesForIndex = nullptr);
+
+/// Read the whole flat summary index in \p Buffer.
+Expected<std::unique_ptr<ModuleSummaryIndex>>
+readFlatSummaryIndex(MemoryBufferRef Buffer);
+
+} // end namespace llvm
+
+#endif // LLVM_IR_FLATSUMMARYINDEX_H
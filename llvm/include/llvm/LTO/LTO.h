@@ -46,6 +46,9 @@ class raw_pwrite_stream;
 ///
 /// This is done for correctness (if value exported, ensure we always
 /// emit a copy), and compile-time optimization (allow drop of duplicates).
+///
+/// \p isPrevailing may be called from several threads at once.
+/// \p recordNewLinkage is called on the calling thread, in index order.
 void thinLTOResolvePrevailingInIndex(
     ModuleSummaryIndex &Index,
     function_ref<bool(GlobalValue::GUID, const GlobalValueSummary *)>
@@ -57,6 +60,9 @@ void thinLTOResolvePrevailingInIndex(
 /// Update the linkages in the given \p Index to mark exported values
 /// as external and non-exported values as internal. The ThinLTO backends
 /// must apply the changes to the Module via thinLTOInternalizeModule.
+///
+/// \p isExported and \p isPrevailing may be called from several threads at
+/// once.
 void thinLTOInternalizeAndPromoteInIndex(
     ModuleSummaryIndex &Index,
     function_ref<bool(StringRef, GlobalValue::GUID)> isExported,
@@ -226,8 +232,49 @@ using ThinBackend = std::function<std::unique_ptr<ThinBackendProc>(
     StringMap<GVSummaryMapTy> &ModuleToDefinedGVSummaries,
     AddStreamFn AddStream, NativeObjectCache Cache)>;
 
-/// This ThinBackend runs the individual backend jobs in-process.
-ThinBackend createInProcessThinBackend(unsigned ParallelismLevel);
+/// Decides when the in-process ThinLTO backend starts its queued jobs, given
+/// the memory each one is estimated to use. Jobs start largest first, so that
+/// the biggest modules don't start last and delay the end of the link. At
+/// most MaxRunningJobs jobs run at once. If MemoryLimit is nonzero, a job only
+/// starts if the estimated memory of the jobs running with it stays within
+/// the limit; the largest job that fits is picked, and a job that doesn't fit
+/// at all runs alone.
+///
+/// This class is not thread-safe.
+class ThinBackendJobQueue {
+public:
+  ThinBackendJobQueue(unsigned MaxRunningJobs, uint64_t MemoryLimit);
+
+  /// Queue \p Job, which is estimated to use \p Memory bytes.
+  void push(uint64_t Memory, std::function<void()> Job);
+
+  /// If a queued job may start now, remove it from the queue, count it as
+  /// running, and return it in \p Job and its estimate in \p Memory. Returns
+  /// false if no job may start.
+  bool startNext(std::function<void()> &Job, uint64_t &Memory);
+
+  /// Tell the queue that a job estimated to use \p Memory bytes finished.
+  void finish(uint64_t Memory);
+
+  bool empty() const { return Pending.empty(); }
+  unsigned getRunningJobs() const { return RunningJobs; }
+  uint64_t getRunningMemory() const { return RunningMemory; }
+
+private:
+  // The jobs not yet started, by estimated memory use.
+  std::multimap<uint64_t, std::function<void()>> Pending;
+  const unsigned MaxRunningJobs;
+  const uint64_t MemoryLimit;
+  unsigned RunningJobs = 0;
+  uint64_t RunningMemory = 0;
+};
+
+/// This ThinBackend runs the individual backend jobs in-process, largest
+/// module first. If \p MemoryLimit is nonzero, jobs are only run concurrently
+/// while the sum of their memory use, estimated from the summaries, stays
+/// within \p MemoryLimit bytes.
+ThinBackend createInProcessThinBackend(unsigned ParallelismLevel,
+                                       uint64_t MemoryLimit = 0);
 
 /// This ThinBackend writes individual module indexes to files, instead of
 /// running the individual backend jobs. This backend is for distributed builds
@@ -27,6 +27,7 @@ enum class DebugCompressionType {
   None, ///< No compression
   GNU,  ///< zlib-gnu style compression
   Z,    ///< zlib style complession
+  Zstd, ///< zstd style compression
 };
 
 class StringRef;
@@ -12,6 +12,7 @@
 #include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Object/ObjectFile.h"
+#include "llvm/Support/Compression.h"
 
 namespace llvm {
 namespace object {
@@ -58,6 +59,7 @@ private:
 
   StringRef SectionData;
   uint64_t DecompressedSize;
+  compression::Format Format = compression::Format::Zlib;
 };
 
 } // end namespace object
@@ -29,9 +29,24 @@ static constexpr int BestSizeCompression = 9;
 
 bool isAvailable();
 
+/// The default size of the chunks that compressParallel splits its input
+/// into.
+static constexpr size_t DefaultChunkSize = 1 << 20;
+
 Error compress(StringRef InputBuffer, SmallVectorImpl<char> &CompressedBuffer,
                int Level = DefaultCompression);
 
+/// Compress InputBuffer in chunks of ChunkSize bytes in parallel. Each chunk
+/// is deflated independently, so the ratio is slightly worse than that of
+/// compress(), but the output is a single zlib stream that uncompress() and
+/// any other zlib reader accept. If UseThreads is false, the chunks are
+/// compressed one after another; the output is the same either way.
+Error compressParallel(StringRef InputBuffer,
+                       SmallVectorImpl<char> &CompressedBuffer,
+                       int Level = DefaultCompression,
+                       size_t ChunkSize = DefaultChunkSize,
+                       bool UseThreads = true);
+
 Error uncompress(StringRef InputBuffer, char *UncompressedBuffer,
                  size_t &UncompressedSize);
 
@@ -43,6 +58,71 @@ uint32_t crc32(StringRef Buffer);
 
 }  // End of namespace zlib
 
+namespace zstd {
+
+static constexpr int BestSpeedCompression = 1;
+static constexpr int DefaultCompression = 5;
+/// A slow level with a high ratio. It is not zstd's best: levels go up to
+/// ZSTD_maxCLevel(), but those are too slow to be useful in a linker.
+static constexpr int HighCompression = 12;
+
+bool isAvailable();
+
+static constexpr size_t DefaultChunkSize = 1 << 20;
+
+Error compress(StringRef InputBuffer, SmallVectorImpl<char> &CompressedBuffer,
+               int Level = DefaultCompression);
+
+/// Compress InputBuffer in chunks of ChunkSize bytes in parallel. The output
+/// is a sequence of zstd frames, which uncompress() accepts. If UseThreads is
+/// false, the chunks are compressed one after another; the output is the same
+/// either way.
+Error compressParallel(StringRef InputBuffer,
+                       SmallVectorImpl<char> &CompressedBuffer,
+                       int Level = DefaultCompression,
+                       size_t ChunkSize = DefaultChunkSize,
+                       bool UseThreads = true);
+
+Error uncompress(StringRef InputBuffer, char *UncompressedBuffer,
+                 size_t &UncompressedSize);
+
+Error uncompress(StringRef InputBuffer,
+                 SmallVectorImpl<char> &UncompressedBuffer,
+                 size_t UncompressedSize);
+
+}  // End of namespace zstd
+
+/// Functions that dispatch to the zlib or zstd implementation, so that clients
+/// can select the compression format at run time. Each format is compressed at
+/// its default level.
+namespace compression {
+
+enum class Format {
+  Zlib,
+  Zstd,
+};
+
+/// Returns the lowercase name of the format, e.g. "zlib".
+const char *getName(Format F);
+
+bool isAvailable(Format F);
+
+Error compress(Format F, StringRef InputBuffer,
+               SmallVectorImpl<char> &CompressedBuffer);
+
+Error compressParallel(Format F, StringRef InputBuffer,
+                       SmallVectorImpl<char> &CompressedBuffer,
+                       bool UseThreads = true);
+
+Error uncompress(Format F, StringRef InputBuffer, char *UncompressedBuffer,
+                 size_t &UncompressedSize);
+
+Error uncompress(Format F, StringRef InputBuffer,
+                 SmallVectorImpl<char> &UncompressedBuffer,
+                 size_t UncompressedSize);
+
+}  // End of namespace compression
+
 } // End of namespace llvm
 
 #endif
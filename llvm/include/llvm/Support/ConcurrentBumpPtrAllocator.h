@@ -0,0 +1,178 @@
+//===- ConcurrentBumpPtrAllocator.h - Thread-caching arenas -----*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+/// \file
+///
+/// This file defines ConcurrentBumpPtrAllocator and
+/// ConcurrentSpecificBumpPtrAllocator, bump pointer allocators that may be
+/// used from several threads at once.
+///
+/// Each thread that allocates gets its own BumpPtrAllocator (or
+/// SpecificBumpPtrAllocator), so allocations never contend. A thread finds its
+/// allocator through a small thread-local cache; the lock protecting the list
+/// of per-thread allocators is only taken the first time a thread uses an
+/// allocator, or when another allocator evicted it from the cache. Memory is
+/// owned by the concurrent allocator, not by the threads, so objects outlive
+/// the threads that allocated them.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_SUPPORT_CONCURRENTBUMPPTRALLOCATOR_H
+#define LLVM_SUPPORT_CONCURRENTBUMPPTRALLOCATOR_H
+
+#include "llvm/Support/Allocator.h"
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace llvm {
+
+namespace detail {
+
+/// Return a new identifier for a concurrent allocator. Identifiers are never
+/// reused, so a thread-local cache entry can't refer to a destroyed allocator.
+uint64_t getNextConcurrentAllocatorID();
+
+/// Return a number identifying the calling thread, unique for the lifetime of
+/// the process.
+unsigned getConcurrentAllocatorThreadID();
+
+/// Return the per-thread allocator that the calling thread cached for the
+/// concurrent allocator \p ID, or null.
+void *lookupThreadAllocator(uint64_t ID);
+
+/// Cache \p Alloc as the calling thread's allocator for allocator \p ID.
+void cacheThreadAllocator(uint64_t ID, void *Alloc);
+
+/// The per-thread allocators of a concurrent allocator.
+template <typename AllocatorT> class ThreadAllocators {
+public:
+  AllocatorT &get() {
+    if (void *Alloc = lookupThreadAllocator(ID))
+      return *static_cast<AllocatorT *>(Alloc);
+    return getSlow();
+  }
+
+  /// Call \p F on each per-thread allocator. This must not run concurrently
+  /// with allocations.
+  template <typename FnT> void forEach(FnT F) {
+    std::lock_guard<std::mutex> Lock(Mutex);
+    for (auto &Entry : Allocators)
+      F(*Entry.second);
+  }
+  template <typename FnT> void forEach(FnT F) const {
+    std::lock_guard<std::mutex> Lock(Mutex);
+    for (const auto &Entry : Allocators)
+      F(*Entry.second);
+  }
+
+private:
+  AllocatorT &getSlow() {
+    unsigned ThreadID = getConcurrentAllocatorThreadID();
+    std::lock_guard<std::mutex> Lock(Mutex);
+    AllocatorT *Alloc = nullptr;
+    for (auto &Entry : Allocators)
+      if (Entry.first == ThreadID)
+        Alloc = Entry.second.get();
+    if (!Alloc) {
+      Allocators.emplace_back(ThreadID, std::make_unique<AllocatorT>());
+      Alloc = Allocators.back().second.get();
+    }
+    cacheThreadAllocator(ID, Alloc);
+    return *Alloc;
+  }
+
+  const uint64_t ID = getNextConcurrentAllocatorID();
+  mutable std::mutex Mutex;
+  std::vector<std::pair<unsigned, std::unique_ptr<AllocatorT>>> Allocators;
+};
+
+} // end namespace detail
+
+/// A BumpPtrAllocator that may be used by several threads at once.
+///
+/// Reset() must not run concurrently with allocations.
+class ConcurrentBumpPtrAllocator
+    : public AllocatorBase<ConcurrentBumpPtrAllocator> {
+public:
+  LLVM_ATTRIBUTE_RETURNS_NONNULL void *Allocate(size_t Size,
+                                                size_t Alignment) {
+    return Allocators.get().Allocate(Size, Alignment);
+  }
+
+  // Pull in base class overloads.
+  using AllocatorBase<ConcurrentBumpPtrAllocator>::Allocate;
+
+  // Bump pointer allocators never free individual allocations.
+  void Deallocate(const void *Ptr, size_t Size) {}
+
+  // Pull in base class overloads.
+  using AllocatorBase<ConcurrentBumpPtrAllocator>::Deallocate;
+
+  /// Deallocate all but the current slab of each thread.
+  void Reset() {
+    Allocators.forEach([](BumpPtrAllocator &A) { A.Reset(); });
+  }
+
+  size_t getTotalMemory() const {
+    size_t Total = 0;
+    Allocators.forEach(
+        [&](const BumpPtrAllocator &A) { Total += A.getTotalMemory(); });
+    return Total;
+  }
+
+  size_t getBytesAllocated() const {
+    size_t Total = 0;
+    Allocators.forEach(
+        [&](const BumpPtrAllocator &A) { Total += A.getBytesAllocated(); });
+    return Total;
+  }
+
+private:
+  detail::ThreadAllocators<BumpPtrAllocator> Allocators;
+};
+
+/// A SpecificBumpPtrAllocator that may be used by several threads at once.
+/// Like SpecificBumpPtrAllocator it calls the destructor of every object in
+/// DestroyAll() and when it is destroyed.
+///
+/// DestroyAll() must not run concurrently with allocations.
+template <typename T> class ConcurrentSpecificBumpPtrAllocator {
+public:
+  /// Call the destructor of each allocated object and free the memory.
+  void DestroyAll() {
+    Allocators.forEach([](SpecificBumpPtrAllocator<T> &A) { A.DestroyAll(); });
+  }
+
+  /// Allocate space for an array of objects without constructing them.
+  T *Allocate(size_t Num = 1) { return Allocators.get().Allocate(Num); }
+
+  size_t getTotalMemory() const {
+    size_t Total = 0;
+    Allocators.forEach([&](const SpecificBumpPtrAllocator<T> &A) {
+      Total += A.getTotalMemory();
+    });
+    return Total;
+  }
+
+  size_t getBytesAllocated() const {
+    size_t Total = 0;
+    Allocators.forEach([&](const SpecificBumpPtrAllocator<T> &A) {
+      Total += A.getBytesAllocated();
+    });
+    return Total;
+  }
+
+private:
+  detail::ThreadAllocators<SpecificBumpPtrAllocator<T>> Allocators;
+};
+
+} // end namespace llvm
+
+#endif // LLVM_SUPPORT_CONCURRENTBUMPPTRALLOCATOR_H
@@ -36,17 +36,24 @@ public:
     /// Don't use mmap and instead write an in-memory buffer to a file when this
     /// buffer is closed.
     F_no_mmap = 2,
+
+    /// If the file already exists and has the requested size, update it in
+    /// place on commit, writing back only the blocks whose contents differ
+    /// from the existing file, and set its modification time. The file is
+    /// replaced as usual if it cannot be opened for writing or locked with
+    /// flock(), which is always the case on Windows. Processes that map the
+    /// file without locking it see the new contents. If the update is
+    /// interrupted by a signal, the file is removed. Otherwise this flag has
+    /// no effect.
+    F_modify = 4,
   };
 
   /// Factory method to create an OutputBuffer object which manages a read/write
   /// buffer of the specified size. When committed, the buffer will be written
   /// to the file at the specified path.
   ///
-  /// When F_modify is specified and \p FilePath refers to an existing on-disk
-  /// file \p Size may be set to -1, in which case the entire file is used.
-  /// Otherwise, the file shrinks or grows as necessary based on the value of
-  /// \p Size.  It is an error to specify F_modify and Size=-1 if \p FilePath
-  /// does not exist.
+  /// The buffer is initially zero-filled even if F_modify is specified; the
+  /// flag only changes how the final contents reach the file.
   static Expected<std::unique_ptr<FileOutputBuffer>>
   create(StringRef FilePath, size_t Size, unsigned Flags = 0);
 
@@ -62,6 +69,12 @@ public:
   /// Returns path where file will show up if buffer is committed.
   StringRef getPath() const { return FinalPath; }
 
+  /// Hints that the given range of the buffer is not going to be modified
+  /// again. A buffer backed by a file mapping may start writing the range
+  /// back to the file and release its memory early. The range remains
+  /// readable and writable.
+  virtual void finalizeRange(size_t Offset, size_t Size) {}
+
   /// Flushes the content of the buffer to its file and deallocates the
   /// buffer.  If commit() is not called before this object's destructor
   /// is called, the file is deleted in the destructor. The optional parameter
@@ -23,10 +23,12 @@
 #include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <vector>
 
 namespace llvm {
 
 class MemoryBufferRef;
+class ThreadPool;
 
 /// This interface provides simple read-only access to a block of memory, and
 /// provides simple methods for reading files and standard input into a memory
@@ -86,6 +88,17 @@ public:
   static ErrorOr<std::unique_ptr<MemoryBuffer>>
   getFileAsStream(const Twine &Filename);
 
+  /// Open each of \p Filenames as getFile() would, using \p Pool to open
+  /// them in parallel. Returns when all files are open. The contents of
+  /// memory mapped files keep being read in by \p Pool in the background, so
+  /// that they are likely to be resident by the time they are accessed;
+  /// destroying a buffer stops reading it in.
+  ///
+  /// This must not be called from a task running on \p Pool.
+  static std::vector<Expected<std::unique_ptr<MemoryBuffer>>>
+  getFiles(ArrayRef<StringRef> Filenames, ThreadPool &Pool,
+           bool RequiresNullTerminator = true, bool IsVolatile = false);
+
   /// Given an already-open file descriptor, map some slice of it into a
   /// MemoryBuffer. The slice is specified by an \p Offset and \p MapSize.
   /// Since this is in the middle of a file, the buffer is not null terminated.
@@ -14,6 +14,7 @@
 #include "llvm/Support/MathExtras.h"
 
 #include <algorithm>
+#include <chrono>
 #include <condition_variable>
 #include <functional>
 #include <mutex>
@@ -61,19 +62,34 @@ public:
     std::unique_lock<std::mutex> lock(Mutex);
     Cond.wait(lock, [&] { return Count == 0; });
   }
+
+  bool isZero() const {
+    std::lock_guard<std::mutex> lock(Mutex);
+    return Count == 0;
+  }
+
+  /// Wait at most \p Timeout for the count to reach zero. Returns true if it
+  /// did.
+  template <class Rep, class Period>
+  bool syncFor(const std::chrono::duration<Rep, Period> &Timeout) const {
+    std::unique_lock<std::mutex> lock(Mutex);
+    return Cond.wait_for(lock, Timeout, [&] { return Count == 0; });
+  }
 };
 
 class TaskGroup {
   Latch L;
-  bool Parallel;
 
 public:
-  TaskGroup();
   ~TaskGroup();
 
   void spawn(std::function<void()> f);
 
-  void sync() const { L.sync(); }
+  /// Wait for all spawned tasks to finish. The calling thread runs queued
+  /// tasks of this group (and only of this group) while it waits, so
+  /// TaskGroups may be nested. The caller must not hold a lock that the tasks
+  /// of this group take: they may run on the calling thread, or wait for it.
+  void sync() const;
 };
 
 const ptrdiff_t MinParallelSize = 1024;
@@ -79,6 +79,7 @@ private:
   // Helper
   void writebyte(uint8_t data);
   void hashBlock();
+  void hashBlocks(const uint8_t *Data, size_t NumBlocks);
   void addUncounted(uint8_t data);
   void pad();
 };
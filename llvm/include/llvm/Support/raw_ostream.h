@@ -19,6 +19,7 @@
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
+#include <memory>
 #include <string>
 #include <system_error>
 
@@ -397,11 +398,21 @@ class raw_fd_ostream : public raw_pwrite_stream {
 
   uint64_t pos;
 
+  /// Writes the output on a background thread, see enableBackgroundWrites().
+  class BackgroundWriter;
+  std::unique_ptr<BackgroundWriter> Writer;
+
   /// See raw_ostream::write_impl.
   void write_impl(const char *Ptr, size_t Size) override;
 
   void pwrite_impl(const char *Ptr, size_t Size, uint64_t Offset) override;
 
+  /// Hand the data to the background writer.
+  void queueBackgroundWrite(const char *Ptr, size_t Size);
+
+  /// Wait until the background writer has written all data handed to it.
+  void waitForBackgroundWrites();
+
   /// Return the current position within the stream, not counting the bytes
   /// currently in the buffer.
   uint64_t current_pos() const override { return pos; }
@@ -451,6 +462,17 @@ public:
   /// to the offset specified from the beginning of the file.
   uint64_t seek(uint64_t off);
 
+  /// Buffer the output in large buffers and write it out from a background
+  /// thread, so that producing the output overlaps with writing it. Several
+  /// full buffers are written with a single vectored write when the writer
+  /// falls behind.
+  ///
+  /// flush() only hands the buffered data to the writer; close(), seek() and
+  /// the destructor wait for it to be written. Write errors are reported
+  /// through error() once the data has been written. This has no effect on
+  /// streams that are closed or that write to a Windows console.
+  void enableBackgroundWrites(size_t BufferSize = 1024 * 1024);
+
   raw_ostream &changeColor(enum Colors colors, bool bold=false,
                            bool bg=false) override;
   raw_ostream &resetColor() override;
@@ -44,6 +44,14 @@
 namespace llvm {
 uint64_t xxHash64(llvm::StringRef Data);
 uint64_t xxHash64(llvm::ArrayRef<uint8_t> Data);
+
+/// Compute the 64-bit XXH3 hash of \p Data with the default secret and a zero
+/// seed. XXH3 is considerably faster than xxHash64 on inputs longer than a few
+/// hundred bytes; the result matches XXH3_64bits() of the reference library.
+uint64_t xxh3_64bits(llvm::ArrayRef<uint8_t> Data);
+inline uint64_t xxh3_64bits(llvm::StringRef Data) {
+  return xxh3_64bits(llvm::makeArrayRef(Data.bytes_begin(), Data.size()));
+}
 }
 
 #endif
@@ -37,6 +37,7 @@
 #include "llvm/IR/DebugInfoMetadata.h"
 #include "llvm/IR/DebugLoc.h"
 #include "llvm/IR/DerivedTypes.h"
+#include "llvm/IR/FlatSummaryIndex.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/GVMaterializer.h"
 #include "llvm/IR/GlobalAlias.h"
@@ -70,6 +71,8 @@
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/MathExtras.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
 #include <cassert>
@@ -92,6 +95,11 @@ static cl::opt<bool> PrintSummaryGUIDs(
     cl::desc(
         "Print the global id for each value when reading the module summary"));
 
+static cl::opt<unsigned> DecodeThreads(
+    "bitcode-decode-threads", cl::init(0), cl::Hidden,
+    cl::desc("Number of threads that decode function bodies ahead of parsing "
+             "when a whole module is materialized (0 = decode while parsing)"));
+
 namespace {
 
 enum {
@@ -480,6 +488,101 @@ BitcodeReaderBase::readNameFromStrtab(ArrayRef<uint64_t> Record) {
 
 namespace {
 
+/// Decodes function blocks on a thread pool ahead of parseFunctionBody.
+///
+/// Only the bitstream is decoded on the pool. The IR is still built on the
+/// parsing thread, in the same order and from the same records, by replaying
+/// the decoded blocks, so the module is identical to one parsed serially. At
+/// most a few bodies per thread are decoded ahead of the parser to bound
+/// memory use.
+class FunctionBodyDecoder {
+  struct Body {
+    uint64_t Offset;
+    DecodedBitstreamBlock Block;
+    bool Decoded = false;
+    std::shared_future<void> Done;
+
+    explicit Body(uint64_t Offset) : Offset(Offset) {}
+  };
+
+  ArrayRef<uint8_t> Bytes;
+  BitstreamBlockInfo &BlockInfo;
+  std::vector<Body> Bodies;
+  DenseMap<Function *, size_t> BodyIndex;
+  /// The bodies before NextToTake were returned or skipped by take(), and
+  /// the bodies before NextToDecode were queued.
+  size_t NextToTake = 0, NextToDecode = 0;
+  /// The number of bodies queued or decoded but not yet taken.
+  size_t MaxAhead;
+  // Declared last so that its destructor waits for the tasks before the
+  // bodies are destroyed.
+  ThreadPool Pool;
+
+  void release(Body &B) {
+    if (B.Done.valid())
+      B.Done.wait();
+    B.Block = DecodedBitstreamBlock();
+  }
+
+  void decodeAhead() {
+    for (; NextToDecode < Bodies.size() && NextToDecode < NextToTake + MaxAhead;
+         ++NextToDecode) {
+      Body &B = Bodies[NextToDecode];
+      B.Done = Pool.async([this, &B] {
+        BitstreamCursor Cursor(Bytes);
+        Cursor.setBlockInfo(&BlockInfo);
+        Error Err = Cursor.JumpToBit(B.Offset);
+        if (!Err)
+          Err = Cursor.decodeBlock(bitc::FUNCTION_BLOCK_ID, B.Block);
+        // Leave malformed bodies to parseFunctionBody, which reports the
+        // error in context.
+        B.Decoded = !Err;
+        consumeError(std::move(Err));
+      });
+    }
+  }
+
+public:
+  FunctionBodyDecoder(ArrayRef<uint8_t> Bytes, BitstreamBlockInfo &BlockInfo,
+                      unsigned Threads)
+      : Bytes(Bytes), BlockInfo(BlockInfo), MaxAhead(4 * Threads),
+        Pool(Threads) {}
+
+  /// Queue the body of \p F, at bit \p Offset, for decoding. Bodies are
+  /// decoded in the order they are added, which should be the order they are
+  /// materialized in.
+  void add(Function *F, uint64_t Offset) {
+    assert(!NextToDecode && "Cannot add bodies after decoding started");
+    BodyIndex[F] = Bodies.size();
+    Bodies.emplace_back(Offset);
+  }
+
+  void start() { decodeAhead(); }
+
+  /// Return the decoded body of \p F, waiting for it if needed, or null if
+  /// \p F was not added, was already returned, or failed to decode. The
+  /// result is valid until the next call. Bodies added before \p F that
+  /// were not taken are dropped.
+  const DecodedBitstreamBlock *take(Function *F) {
+    auto It = BodyIndex.find(F);
+    if (It == BodyIndex.end() || It->second < NextToTake)
+      return nullptr;
+    size_t I = It->second;
+    if (NextToTake)
+      release(Bodies[NextToTake - 1]);
+    for (; NextToTake < I; ++NextToTake)
+      release(Bodies[NextToTake]);
+    NextToTake = I + 1;
+    // Bodies that were skipped before being queued are not decoded at all.
+    NextToDecode = std::max(NextToDecode, I);
+    decodeAhead();
+
+    Body &B = Bodies[I];
+    B.Done.wait();
+    return B.Decoded ? &B.Block : nullptr;
+  }
+};
+
 class BitcodeReader : public BitcodeReaderBase, public GVMaterializer {
   LLVMContext &Context;
   Module *TheModule = nullptr;
@@ -563,6 +666,9 @@ class BitcodeReader : public BitcodeReaderBase, public GVMaterializer {
   bool StripDebugInfo = false;
   TBAAVerifier TBAAVerifyHelper;
 
+  /// Decodes function bodies ahead of parsing while materializeModule runs.
+  std::unique_ptr<FunctionBodyDecoder> BodyDecoder;
+
   std::vector<std::string> BundleTags;
   SmallVector<SyncScope::ID, 8> SSIDs;
 
@@ -5239,7 +5345,14 @@ Error BitcodeReader::materialize(GlobalValue *GV) {
   // Move the bit stream to the saved position of the deferred function body.
   if (Error JumpFailed = Stream.JumpToBit(DFII->second))
     return JumpFailed;
-  if (Error Err = parseFunctionBody(F))
+  // If the body was decoded ahead of time, parse it from the decoded records.
+  if (BodyDecoder)
+    if (const DecodedBitstreamBlock *Body = BodyDecoder->take(F))
+      Stream.replay(*Body);
+  Error Err = parseFunctionBody(F);
+  // Don't keep replaying a body that failed to parse part way through.
+  Stream.endReplay();
+  if (Err)
     return Err;
   F->setIsMaterializable(false);
 
@@ -5291,12 +5404,30 @@ Error BitcodeReader::materializeModule() {
   // Promise to materialize all forward references.
   WillMaterializeAllForwardRefs = true;
 
+  // Decode the function bodies whose position is known on other threads,
+  // while this thread builds the IR of the bodies decoded so far.
+  if (DecodeThreads && llvm_is_multithreaded()) {
+    BodyDecoder = std::make_unique<FunctionBodyDecoder>(
+        Stream.getBitcodeBytes(), BlockInfo, DecodeThreads);
+    for (Function &F : *TheModule) {
+      if (!F.isMaterializable())
+        continue;
+      auto DFII = DeferredFunctionInfo.find(&F);
+      if (DFII != DeferredFunctionInfo.end() && DFII->second)
+        BodyDecoder->add(&F, DFII->second);
+    }
+    BodyDecoder->start();
+  }
+
   // Iterate over the module, deserializing any functions that are still on
   // disk.
   for (Function &F : *TheModule) {
-    if (Error Err = materialize(&F))
+    if (Error Err = materialize(&F)) {
+      BodyDecoder.reset();
       return Err;
+    }
   }
+  BodyDecoder.reset();
   // At this point, if there are any function bodies, parse the rest of
   // the bits in the module past the last function block we have recorded
   // through either lazy scanning or the VST.
@@ -6692,6 +6823,9 @@ Error llvm::readModuleSummaryIndex(MemoryBufferRef Buffer,
 
 Expected<std::unique_ptr<ModuleSummaryIndex>>
 llvm::getModuleSummaryIndex(MemoryBufferRef Buffer) {
+  if (FlatSummaryIndex::isFlatSummaryIndex(Buffer))
+    return readFlatSummaryIndex(Buffer);
+
   Expected<BitcodeModule> BM = getSingleModule(Buffer);
   if (!BM)
     return BM.takeError();
@@ -19,6 +19,13 @@ using namespace llvm;
 
 /// Having read the ENTER_SUBBLOCK abbrevid, enter the block.
 Error BitstreamCursor::EnterSubBlock(unsigned BlockID, unsigned *NumWordsP) {
+  if (Replay) {
+    if (NumWordsP)
+      *NumWordsP = Replay->Entries[ReplayCur].NumOps;
+    ++ReplayDepth;
+    return Error::success();
+  }
+
   // Save the current block's state on BlockScope.
   BlockScope.push_back(Block(CurCodeSize));
   BlockScope.back().PrevAbbrevs.swap(CurAbbrevs);
@@ -121,6 +128,9 @@ static Error skipAbbreviatedField(BitstreamCursor &Cursor,
 
 /// skipRecord - Read the current record and discard it.
 Expected<unsigned> BitstreamCursor::skipRecord(unsigned AbbrevID) {
+  if (Replay)
+    return readReplayedRecord(nullptr, nullptr);
+
   // Skip unabbreviated records by reading past their entries.
   if (AbbrevID == bitc::UNABBREV_RECORD) {
     Expected<uint32_t> MaybeCode = ReadVBR(6);
@@ -235,6 +245,9 @@ Expected<unsigned> BitstreamCursor::skipRecord(unsigned AbbrevID) {
 Expected<unsigned> BitstreamCursor::readRecord(unsigned AbbrevID,
                                                SmallVectorImpl<uint64_t> &Vals,
                                                StringRef *Blob) {
+  if (Replay)
+    return readReplayedRecord(&Vals, Blob);
+
   if (AbbrevID == bitc::UNABBREV_RECORD) {
     Expected<uint32_t> MaybeCode = ReadVBR(6);
     if (!MaybeCode)
@@ -372,6 +385,163 @@ Expected<unsigned> BitstreamCursor::readRecord(unsigned AbbrevID,
   return Code;
 }
 
+//===----------------------------------------------------------------------===//
+//  Decoding and replaying blocks
+//===----------------------------------------------------------------------===//
+
+Error BitstreamCursor::decodeBlock(unsigned BlockID,
+                                   DecodedBitstreamBlock &Decoded) {
+  assert(!Replay && "Cannot decode a replayed block");
+  using Entry = DecodedBitstreamBlock::Entry;
+  Decoded.clear();
+
+  unsigned NumWords;
+  if (Error Err = EnterSubBlock(BlockID, &NumWords))
+    return Err;
+  Decoded.Entries.push_back(
+      Entry{BlockID, NumWords, BitstreamEntry::SubBlock, false});
+
+  for (unsigned Depth = 1; Depth;) {
+    Expected<BitstreamEntry> MaybeEntry = advance();
+    if (!MaybeEntry)
+      return MaybeEntry.takeError();
+    BitstreamEntry E = MaybeEntry.get();
+
+    switch (E.Kind) {
+    case BitstreamEntry::Error:
+      return createStringError(std::errc::illegal_byte_sequence,
+                               "malformed block");
+    case BitstreamEntry::EndBlock:
+      Decoded.Entries.push_back(Entry{0, 0, BitstreamEntry::EndBlock, false});
+      --Depth;
+      continue;
+    case BitstreamEntry::SubBlock:
+      if (Error Err = EnterSubBlock(E.ID, &NumWords))
+        return Err;
+      Decoded.Entries.push_back(
+          Entry{E.ID, NumWords, BitstreamEntry::SubBlock, false});
+      ++Depth;
+      continue;
+    case BitstreamEntry::Record:
+      break;
+    }
+
+    // readRecord() treats a bad abbreviation as a fatal error. Check the
+    // abbreviation here so that a malformed block is reported to the caller,
+    // which may not have needed it at all.
+    bool HasBlob = false;
+    if (E.ID != bitc::UNABBREV_RECORD) {
+      unsigned AbbrevNo = E.ID - bitc::FIRST_APPLICATION_ABBREV;
+      if (AbbrevNo >= CurAbbrevs.size())
+        return createStringError(std::errc::illegal_byte_sequence,
+                                 "invalid abbrev number %u", E.ID);
+      const BitCodeAbbrev *Abbv = CurAbbrevs[AbbrevNo].get();
+      for (unsigned I = 0, N = Abbv->getNumOperandInfos(); I != N; ++I) {
+        const BitCodeAbbrevOp &Op = Abbv->getOperandInfo(I);
+        if (Op.isLiteral() || Op.getEncoding() != BitCodeAbbrevOp::Blob)
+          continue;
+        if (I + 1 != N)
+          return createStringError(std::errc::illegal_byte_sequence,
+                                   "blob is not the last operand");
+        HasBlob = true;
+      }
+    }
+
+    size_t FirstOp = Decoded.Ops.size();
+    StringRef Blob;
+    Expected<unsigned> MaybeCode =
+        readRecord(E.ID, Decoded.Ops, HasBlob ? &Blob : nullptr);
+    if (!MaybeCode)
+      return MaybeCode.takeError();
+    // A blob that runs off the end of the stream is read as zero operands.
+    if (HasBlob && !Blob.data())
+      return createStringError(std::errc::illegal_byte_sequence,
+                               "blob extends past the end of the stream");
+    Decoded.Entries.push_back(Entry{MaybeCode.get(),
+                                    unsigned(Decoded.Ops.size() - FirstOp),
+                                    BitstreamEntry::Record, HasBlob});
+    if (HasBlob) {
+      Decoded.Ops.push_back(Blob.bytes_begin() - getBitcodeBytes().begin());
+      Decoded.Ops.push_back(Blob.size());
+    }
+  }
+  return Error::success();
+}
+
+BitstreamEntry BitstreamCursor::advanceReplay(unsigned Flags) {
+  assert(!(Flags & AF_DontAutoprocessAbbrevs) &&
+         "Abbreviations are not replayed");
+  assert(ReplayEntry < Replay->Entries.size() && "Replayed past the end");
+  const DecodedBitstreamBlock::Entry &E = Replay->Entries[ReplayEntry];
+  ReplayCur = ReplayEntry++;
+  ReplayCurOp = ReplayOp;
+
+  switch (E.Kind) {
+  case BitstreamEntry::EndBlock:
+    if (!(Flags & AF_DontPopBlockAtEnd))
+      endReplayedBlock();
+    return BitstreamEntry::getEndBlock();
+  case BitstreamEntry::SubBlock:
+    return BitstreamEntry::getSubBlock(E.ID);
+  default:
+    ReplayOp += E.NumOps + (E.HasBlob ? 2 : 0);
+    return BitstreamEntry::getRecord(bitc::UNABBREV_RECORD);
+  }
+}
+
+Expected<unsigned> BitstreamCursor::readReplayedCode() {
+  assert(ReplayEntry < Replay->Entries.size() && "Replayed past the end");
+  if (Replay->Entries[ReplayEntry].Kind != BitstreamEntry::Record)
+    return createStringError(std::errc::illegal_byte_sequence,
+                             "expected a record");
+  advanceReplay(0);
+  return bitc::UNABBREV_RECORD;
+}
+
+unsigned BitstreamCursor::readReplayedRecord(SmallVectorImpl<uint64_t> *Vals,
+                                             StringRef *Blob) {
+  const DecodedBitstreamBlock::Entry &E = Replay->Entries[ReplayCur];
+  assert(E.Kind == BitstreamEntry::Record && "Not positioned at a record");
+  if (!Vals)
+    return E.ID;
+
+  const uint64_t *Ops = Replay->Ops.data() + ReplayCurOp;
+  Vals->append(Ops, Ops + E.NumOps);
+  if (E.HasBlob) {
+    StringRef Bytes(reinterpret_cast<const char *>(getBitcodeBytes().data()) +
+                        Ops[E.NumOps],
+                    Ops[E.NumOps + 1]);
+    // Like readRecord(), unpack the blob into Vals if the caller doesn't take
+    // it as a blob.
+    if (Blob)
+      *Blob = Bytes;
+    else
+      Vals->append(Bytes.bytes_begin(), Bytes.bytes_end());
+  }
+  return E.ID;
+}
+
+void BitstreamCursor::skipReplayedBlock() {
+  for (unsigned Depth = 1; Depth;) {
+    const DecodedBitstreamBlock::Entry &E = Replay->Entries[ReplayEntry++];
+    if (E.Kind == BitstreamEntry::SubBlock)
+      ++Depth;
+    else if (E.Kind == BitstreamEntry::EndBlock)
+      --Depth;
+    else
+      ReplayOp += E.NumOps + (E.HasBlob ? 2 : 0);
+  }
+  // Skipping the replayed block itself ends the replay.
+  if (!ReplayDepth)
+    Replay = nullptr;
+}
+
+void BitstreamCursor::endReplayedBlock() {
+  assert(ReplayDepth && "Ended a block that was not entered");
+  if (!--ReplayDepth)
+    Replay = nullptr;
+}
+
 Error BitstreamCursor::ReadAbbrevRecord() {
   auto Abbv = std::make_shared<BitCodeAbbrev>();
   Expected<uint32_t> MaybeNumOpInfo = ReadVBR(5);
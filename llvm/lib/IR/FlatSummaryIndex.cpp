@@ -0,0 +1,928 @@
+//===- FlatSummaryIndex.cpp - Flat summary index format -------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the reader and writer of the flat summary index format.
+//
+// The summaries section holds, for each value of the GUID table, its summary
+// records. A record starts with a SummaryHeader followed by, depending on the
+// kind of summary:
+//
+// - alias: the position of the aliasee in the GUID table.
+// - variable: the variable flags and the references.
+// - function: a FunctionHeader, the references, the calls as pairs of callee
+//   position and raw CalleeInfo, the type tests, the two lists of virtual
+//   calls as pairs of type GUID and offset, and the two lists of constant
+//   virtual calls, each a type GUID, an offset, an argument count and the
+//   arguments.
+//
+// A reference is the position of the referenced value in the GUID table,
+// shifted left by two, with bit 0 set for read-only references and bit 1 set
+// for write-only references. Like in the bitcode encoding of the combined
+// index, references and calls to values without summaries are dropped.
+//
+// The globals section holds the CFI function definitions and declarations, as
+// counts followed by strings, and the type identifier summaries referenced by
+// the functions of the index. A string is an offset and a size in the strings
+// section.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/IR/FlatSummaryIndex.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/EndianStream.h"
+#include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <set>
+
+using namespace llvm;
+using namespace llvm::flatsummary;
+using namespace llvm::support;
+
+namespace {
+
+struct SummaryHeader {
+  ulittle32_t Kind;
+  /// The GVFlags, encoded as in the bitcode summary records.
+  ulittle32_t Flags;
+  /// Position of the module in the module table.
+  ulittle32_t Module;
+  ulittle32_t NumRefs;
+  /// The original name of locals, 0 otherwise.
+  ulittle64_t OriginalName;
+};
+
+struct FunctionHeader {
+  ulittle32_t InstCount;
+  ulittle32_t FFlags;
+  ulittle64_t EntryCount;
+  ulittle32_t NumCalls;
+  ulittle32_t NumTypeTests;
+  ulittle32_t NumTypeTestAssumeVCalls;
+  ulittle32_t NumTypeCheckedLoadVCalls;
+  ulittle32_t NumTypeTestAssumeConstVCalls;
+  ulittle32_t NumTypeCheckedLoadConstVCalls;
+};
+
+} // end anonymous namespace
+
+static Error malformed(const Twine &Message) {
+  return make_error<StringError>("Malformed flat summary index: " + Message,
+                                 inconvertibleErrorCode());
+}
+
+static uint32_t encodeGVFlags(GlobalValueSummary::GVFlags Flags) {
+  uint32_t RawFlags = Flags.NotEligibleToImport | (Flags.Live << 1) |
+                      (Flags.DSOLocal << 2) | (Flags.CanAutoHide << 3);
+  return (RawFlags << 4) | Flags.Linkage;
+}
+
+// The linkage comes from a file, so it is checked, as getDecodedLinkage() in
+// the bitcode reader does. Files of other versions of the flat format are
+// rejected, so unlike in bitcode an unknown linkage is an error.
+static Expected<GlobalValueSummary::GVFlags> decodeGVFlags(uint32_t RawFlags) {
+  uint32_t RawLinkage = RawFlags & 0xF;
+  if (RawLinkage > GlobalValue::CommonLinkage)
+    return malformed("invalid linkage " + Twine(RawLinkage));
+  auto Linkage = GlobalValue::LinkageTypes(RawLinkage);
+  RawFlags >>= 4;
+  return GlobalValueSummary::GVFlags(Linkage, RawFlags & 0x1, RawFlags & 0x2,
+                                     RawFlags & 0x4, RawFlags & 0x8);
+}
+
+static uint32_t encodeFFlags(FunctionSummary::FFlags Flags) {
+  return Flags.ReadNone | (Flags.ReadOnly << 1) | (Flags.NoRecurse << 2) |
+         (Flags.ReturnDoesNotAlias << 3) | (Flags.NoInline << 4);
+}
+
+static FunctionSummary::FFlags decodeFFlags(uint32_t RawFlags) {
+  FunctionSummary::FFlags Flags;
+  Flags.ReadNone = RawFlags & 0x1;
+  Flags.ReadOnly = (RawFlags >> 1) & 0x1;
+  Flags.NoRecurse = (RawFlags >> 2) & 0x1;
+  Flags.ReturnDoesNotAlias = (RawFlags >> 3) & 0x1;
+  Flags.NoInline = (RawFlags >> 4) & 0x1;
+  return Flags;
+}
+
+static uint32_t encodeCalleeInfo(CalleeInfo Info) {
+  return Info.Hotness | (Info.RelBlockFreq << 3);
+}
+
+static Expected<CalleeInfo> decodeCalleeInfo(uint32_t RawInfo) {
+  uint32_t RawHotness = RawInfo & 0x7;
+  if (RawHotness > uint32_t(CalleeInfo::HotnessType::Critical))
+    return malformed("invalid hotness " + Twine(RawHotness));
+  return CalleeInfo(CalleeInfo::HotnessType(RawHotness), RawInfo >> 3);
+}
+
+static uint32_t encodeIndexFlags(const ModuleSummaryIndex &Index) {
+  uint32_t Flags = 0;
+  if (Index.withGlobalValueDeadStripping())
+    Flags |= 0x1;
+  if (Index.skipModuleByDistributedBackend())
+    Flags |= 0x2;
+  if (Index.hasSyntheticEntryCounts())
+    Flags |= 0x4;
+  if (Index.enableSplitLTOUnit())
+    Flags |= 0x8;
+  if (Index.partiallySplitLTOUnits())
+    Flags |= 0x10;
+  return Flags;
+}
+
+static void decodeIndexFlags(uint32_t Flags, ModuleSummaryIndex &Index) {
+  if (Flags & 0x1)
+    Index.setWithGlobalValueDeadStripping();
+  if (Flags & 0x2)
+    Index.setSkipModuleByDistributedBackend();
+  if (Flags & 0x4)
+    Index.setHasSyntheticEntryCounts();
+  if (Flags & 0x8)
+    Index.setEnableSplitLTOUnit();
+  if (Flags & 0x10)
+    Index.setPartiallySplitLTOUnits();
+}
+
+//===----------------------------------------------------------------------===//
+// Writer
+//===----------------------------------------------------------------------===//
+
+namespace {
+
+class FlatSummaryIndexWriter {
+  const ModuleSummaryIndex &Index;
+  const std::map<std::string, GVSummaryMapTy> *ModuleToSummariesForIndex;
+
+  /// The summaries to write for each GUID, in GUID order. The entries of the
+  /// aliasees of the written aliases may have no summaries.
+  std::map<GlobalValue::GUID, SmallVector<GlobalValueSummary *, 1>> Values;
+  DenseMap<GlobalValue::GUID, uint32_t> ValueIndices;
+  StringMap<uint32_t> ModuleIndices;
+
+  /// The values defined or used by the written summaries, to select the CFI
+  /// function names to write.
+  DenseSet<GlobalValue::GUID> DefOrUseGUIDs;
+  std::set<GlobalValue::GUID> ReferencedTypeIds;
+
+  SmallVector<char, 0> ModulesSection, ValuesSection, SummariesSection,
+      GlobalsSection, StringsSection;
+  StringMap<uint32_t> StringOffsets;
+
+public:
+  FlatSummaryIndexWriter(
+      const ModuleSummaryIndex &Index,
+      const std::map<std::string, GVSummaryMapTy> *ModuleToSummariesForIndex)
+      : Index(Index), ModuleToSummariesForIndex(ModuleToSummariesForIndex) {}
+
+  void write(raw_ostream &OS);
+
+private:
+  template <typename Functor> void forEachSummary(Functor Callback);
+  template <typename Functor> void forEachModule(Functor Callback);
+
+  void writeString(endian::Writer &W, StringRef S);
+  void writeModules();
+  void writeValues();
+  void writeSummary(endian::Writer &W, const GlobalValueSummary &S);
+  void writeGlobals();
+
+  Optional<uint32_t> getValueIndex(GlobalValue::GUID GUID) const {
+    auto It = ValueIndices.find(GUID);
+    if (It == ValueIndices.end())
+      return None;
+    return It->second;
+  }
+};
+
+} // end anonymous namespace
+
+// Calls the callback for each GUID and summary to write, like the bitcode
+// writer. The aliasees of aliases are passed with IsAliasee set, so that they
+// get a GUID table entry even if their summary is not written.
+template <typename Functor>
+void FlatSummaryIndexWriter::forEachSummary(Functor Callback) {
+  if (ModuleToSummariesForIndex) {
+    for (auto &M : *ModuleToSummariesForIndex)
+      for (auto &Summary : M.second) {
+        Callback(Summary.first, Summary.second, false);
+        if (auto *AS = dyn_cast<AliasSummary>(Summary.second))
+          Callback(AS->getAliaseeGUID(), &AS->getAliasee(), true);
+      }
+  } else {
+    for (auto &Summaries : Index)
+      for (auto &Summary : Summaries.second.SummaryList)
+        Callback(Summaries.first, Summary.get(), false);
+  }
+}
+
+template <typename Functor>
+void FlatSummaryIndexWriter::forEachModule(Functor Callback) {
+  if (ModuleToSummariesForIndex) {
+    for (const auto &M : *ModuleToSummariesForIndex) {
+      const auto &MPI = Index.modulePaths().find(M.first);
+      // The module may be missing if its bitcode was empty, in which case
+      // there is nothing to import.
+      if (MPI != Index.modulePaths().end())
+        Callback(*MPI);
+    }
+  } else {
+    for (const auto &MPSE : Index.modulePaths())
+      Callback(MPSE);
+  }
+}
+
+void FlatSummaryIndexWriter::writeString(endian::Writer &W, StringRef S) {
+  auto Inserted = StringOffsets.insert({S, StringsSection.size()});
+  if (Inserted.second)
+    StringsSection.append(S.begin(), S.end());
+  W.write<uint32_t>(Inserted.first->second);
+  W.write<uint32_t>(S.size());
+}
+
+void FlatSummaryIndexWriter::writeModules() {
+  raw_svector_ostream OS(ModulesSection);
+  endian::Writer W(OS, little);
+  forEachModule(
+      [&](const StringMapEntry<std::pair<uint64_t, ModuleHash>> &MPSE) {
+        unsigned ModuleIndex = ModuleIndices.size();
+        ModuleIndices[MPSE.getKey()] = ModuleIndex;
+        W.write<uint64_t>(MPSE.getValue().first);
+        writeString(W, MPSE.getKey());
+        for (uint32_t H : MPSE.getValue().second)
+          W.write<uint32_t>(H);
+        W.write<uint32_t>(0);
+      });
+}
+
+void FlatSummaryIndexWriter::writeValues() {
+  forEachSummary([&](GlobalValue::GUID GUID, GlobalValueSummary *S,
+                     bool IsAliasee) {
+    DefOrUseGUIDs.insert(GUID);
+    for (const ValueInfo &VI : S->refs())
+      DefOrUseGUIDs.insert(VI.getGUID());
+    auto &Summaries = Values[GUID];
+    if (!IsAliasee)
+      Summaries.push_back(S);
+  });
+
+  for (auto &V : Values) {
+    unsigned ValueIndex = ValueIndices.size();
+    ValueIndices[V.first] = ValueIndex;
+    // The bitcode reader adds the aliases after all other summaries, do the
+    // same to get the same order in the summary lists.
+    std::stable_partition(
+        V.second.begin(), V.second.end(),
+        [](GlobalValueSummary *S) { return !isa<AliasSummary>(S); });
+  }
+
+  raw_svector_ostream ValuesOS(ValuesSection);
+  endian::Writer ValuesW(ValuesOS, little);
+  raw_svector_ostream SummariesOS(SummariesSection);
+  endian::Writer SummariesW(SummariesOS, little);
+  for (auto &V : Values) {
+    ValuesW.write<uint64_t>(V.first);
+    ValuesW.write<uint32_t>(SummariesSection.size());
+    ValuesW.write<uint32_t>(V.second.size());
+    for (GlobalValueSummary *S : V.second)
+      writeSummary(SummariesW, *S);
+  }
+}
+
+static void getReferencedTypeIds(const FunctionSummary &FS,
+                                 std::set<GlobalValue::GUID> &TypeIds) {
+  TypeIds.insert(FS.type_tests().begin(), FS.type_tests().end());
+  for (auto &VF : FS.type_test_assume_vcalls())
+    TypeIds.insert(VF.GUID);
+  for (auto &VF : FS.type_checked_load_vcalls())
+    TypeIds.insert(VF.GUID);
+  for (auto &VC : FS.type_test_assume_const_vcalls())
+    TypeIds.insert(VC.VFunc.GUID);
+  for (auto &VC : FS.type_checked_load_const_vcalls())
+    TypeIds.insert(VC.VFunc.GUID);
+}
+
+void FlatSummaryIndexWriter::writeSummary(endian::Writer &W,
+                                          const GlobalValueSummary &S) {
+  SmallVector<uint32_t, 16> Refs;
+  for (const ValueInfo &VI : S.refs())
+    if (auto RefIndex = getValueIndex(VI.getGUID()))
+      Refs.push_back(*RefIndex << 2 | VI.isReadOnly() | VI.isWriteOnly() << 1);
+
+  assert(ModuleIndices.count(S.modulePath()) && "Module not written");
+  W.write<uint32_t>(S.getSummaryKind());
+  W.write<uint32_t>(encodeGVFlags(S.flags()));
+  W.write<uint32_t>(ModuleIndices.lookup(S.modulePath()));
+  W.write<uint32_t>(Refs.size());
+  W.write<uint64_t>(GlobalValue::isLocalLinkage(S.linkage())
+                        ? S.getOriginalName()
+                        : 0);
+
+  if (auto *AS = dyn_cast<AliasSummary>(&S)) {
+    W.write<uint32_t>(*getValueIndex(AS->getAliaseeGUID()));
+    if (auto *FS = dyn_cast<FunctionSummary>(&AS->getAliasee()))
+      getReferencedTypeIds(*FS, ReferencedTypeIds);
+    return;
+  }
+
+  if (auto *VS = dyn_cast<GlobalVarSummary>(&S)) {
+    W.write<uint32_t>(VS->maybeReadOnly() | VS->maybeWriteOnly() << 1);
+    W.write<uint32_t>(Refs);
+    return;
+  }
+
+  auto &FS = cast<FunctionSummary>(S);
+  getReferencedTypeIds(FS, ReferencedTypeIds);
+
+  SmallVector<uint32_t, 16> Calls;
+  for (auto &Call : FS.calls()) {
+    // As in the bitcode writer, fall back to the original name of the callee
+    // for SamplePGO indirect call targets, unless it names a variable.
+    GlobalValue::GUID GUID = Call.first.getGUID();
+    Optional<uint32_t> CalleeIndex = getValueIndex(GUID);
+    if (!CalleeIndex) {
+      GUID = Index.getGUIDFromOriginalID(GUID);
+      if (!GUID || !(CalleeIndex = getValueIndex(GUID)))
+        continue;
+      auto *GVSum = Index.getGlobalValueSummary(GUID, false);
+      if (GVSum && isa<GlobalVarSummary>(GVSum))
+        continue;
+    }
+    Calls.push_back(*CalleeIndex);
+    Calls.push_back(encodeCalleeInfo(Call.second));
+  }
+
+  W.write<uint32_t>(FS.instCount());
+  W.write<uint32_t>(encodeFFlags(FS.fflags()));
+  W.write<uint64_t>(FS.entryCount());
+  W.write<uint32_t>(Calls.size() / 2);
+  W.write<uint32_t>(FS.type_tests().size());
+  W.write<uint32_t>(FS.type_test_assume_vcalls().size());
+  W.write<uint32_t>(FS.type_checked_load_vcalls().size());
+  W.write<uint32_t>(FS.type_test_assume_const_vcalls().size());
+  W.write<uint32_t>(FS.type_checked_load_const_vcalls().size());
+  W.write<uint32_t>(Refs);
+  W.write<uint32_t>(Calls);
+  W.write<uint64_t>(FS.type_tests());
+  for (auto VCalls : {FS.type_test_assume_vcalls(),
+                      FS.type_checked_load_vcalls()})
+    for (auto &VF : VCalls) {
+      W.write<uint64_t>(VF.GUID);
+      W.write<uint64_t>(VF.Offset);
+    }
+  for (auto VCalls : {FS.type_test_assume_const_vcalls(),
+                      FS.type_checked_load_const_vcalls()})
+    for (auto &VC : VCalls) {
+      W.write<uint64_t>(VC.VFunc.GUID);
+      W.write<uint64_t>(VC.VFunc.Offset);
+      W.write<uint32_t>(VC.Args.size());
+      W.write<uint64_t>(VC.Args);
+    }
+}
+
+void FlatSummaryIndexWriter::writeGlobals() {
+  raw_svector_ostream OS(GlobalsSection);
+  endian::Writer W(OS, little);
+
+  for (auto *CfiFunctions : {&Index.cfiFunctionDefs(),
+                             &Index.cfiFunctionDecls()}) {
+    std::vector<StringRef> Names;
+    for (auto &S : *CfiFunctions)
+      if (DefOrUseGUIDs.count(
+              GlobalValue::getGUID(GlobalValue::dropLLVMManglingEscape(S))))
+        Names.push_back(S);
+    W.write<uint32_t>(Names.size());
+    for (StringRef Name : Names)
+      writeString(W, Name);
+  }
+
+  std::vector<const std::pair<const GlobalValue::GUID,
+                              std::pair<std::string, TypeIdSummary>> *>
+      TypeIds;
+  for (GlobalValue::GUID GUID : ReferencedTypeIds) {
+    auto TidIter = Index.typeIds().equal_range(GUID);
+    for (auto It = TidIter.first; It != TidIter.second; ++It)
+      TypeIds.push_back(&*It);
+  }
+  W.write<uint32_t>(TypeIds.size());
+  for (auto *TypeId : TypeIds) {
+    const TypeIdSummary &Summary = TypeId->second.second;
+    writeString(W, TypeId->second.first);
+    W.write<uint32_t>(Summary.TTRes.TheKind);
+    W.write<uint32_t>(Summary.TTRes.SizeM1BitWidth);
+    W.write<uint64_t>(Summary.TTRes.AlignLog2);
+    W.write<uint64_t>(Summary.TTRes.SizeM1);
+    W.write<uint32_t>(Summary.TTRes.BitMask);
+    W.write<uint64_t>(Summary.TTRes.InlineBits);
+    W.write<uint32_t>(Summary.WPDRes.size());
+    for (auto &WPD : Summary.WPDRes) {
+      W.write<uint64_t>(WPD.first);
+      W.write<uint32_t>(WPD.second.TheKind);
+      writeString(W, WPD.second.SingleImplName);
+      W.write<uint32_t>(WPD.second.ResByArg.size());
+      for (auto &ResByArg : WPD.second.ResByArg) {
+        W.write<uint32_t>(ResByArg.first.size());
+        W.write<uint64_t>(ResByArg.first);
+        W.write<uint32_t>(ResByArg.second.TheKind);
+        W.write<uint64_t>(ResByArg.second.Info);
+        W.write<uint32_t>(ResByArg.second.Byte);
+        W.write<uint32_t>(ResByArg.second.Bit);
+      }
+    }
+  }
+}
+
+void FlatSummaryIndexWriter::write(raw_ostream &OS) {
+  writeModules();
+  writeValues();
+  writeGlobals();
+
+  // Lay the sections out after the header, each aligned to 8 bytes.
+  uint64_t Offset = sizeof(Header);
+  auto Place = [&](const SmallVectorImpl<char> &Section) {
+    uint64_t SectionOffset = Offset;
+    Offset = alignTo(Offset + Section.size(), 8);
+    return SectionOffset;
+  };
+  uint64_t ModulesOffset = Place(ModulesSection);
+  uint64_t ValuesOffset = Place(ValuesSection);
+  uint64_t SummariesOffset = Place(SummariesSection);
+  uint64_t GlobalsOffset = Place(GlobalsSection);
+  uint64_t StringsOffset = Place(StringsSection);
+  if (Offset > UINT32_MAX)
+    report_fatal_error("Summary index too large for the flat format");
+
+  endian::Writer W(OS, little);
+  OS.write(Magic, sizeof(Magic));
+  W.write<uint32_t>(Version);
+  W.write<uint32_t>(encodeIndexFlags(Index));
+  W.write<uint32_t>(ModuleIndices.size());
+  W.write<uint32_t>(Values.size());
+  W.write<uint32_t>(ModulesOffset);
+  W.write<uint32_t>(ValuesOffset);
+  W.write<uint32_t>(SummariesOffset);
+  W.write<uint32_t>(SummariesSection.size());
+  W.write<uint32_t>(GlobalsOffset);
+  W.write<uint32_t>(GlobalsSection.size());
+  W.write<uint32_t>(StringsOffset);
+  W.write<uint32_t>(StringsSection.size());
+  for (auto *Section : {&ModulesSection, &ValuesSection, &SummariesSection,
+                        &GlobalsSection, &StringsSection}) {
+    OS.write(Section->data(), Section->size());
+    OS.write_zeros(offsetToAlignment(Section->size(), Align(8)));
+  }
+}
+
+void llvm::writeFlatSummaryIndex(
+    const ModuleSummaryIndex &Index, raw_ostream &Out,
+    const std::map<std::string, GVSummaryMapTy> *ModuleToSummariesForIndex) {
+  FlatSummaryIndexWriter(Index, ModuleToSummariesForIndex).write(Out);
+}
+
+//===----------------------------------------------------------------------===//
+// Reader
+//===----------------------------------------------------------------------===//
+
+namespace {
+
+/// Bounds checked reads from a section.
+class SectionReader {
+  StringRef Data;
+  size_t Offset;
+
+public:
+  SectionReader(StringRef Data, size_t Offset = 0)
+      : Data(Data), Offset(Offset) {}
+
+  template <typename T> bool read(const T *&Object) {
+    if (Offset > Data.size() || Data.size() - Offset < sizeof(T))
+      return false;
+    Object = reinterpret_cast<const T *>(Data.data() + Offset);
+    Offset += sizeof(T);
+    return true;
+  }
+
+  template <typename T> bool read(ArrayRef<T> &Array, size_t Size) {
+    if (Offset > Data.size() || (Data.size() - Offset) / sizeof(T) < Size)
+      return false;
+    Array = makeArrayRef(reinterpret_cast<const T *>(Data.data() + Offset),
+                         Size);
+    Offset += Size * sizeof(T);
+    return true;
+  }
+
+  template <typename T> bool read(T &Value) {
+    const support::detail::packed_endian_specific_integral<T, little,
+                                                           unaligned> *P;
+    if (!read(P))
+      return false;
+    Value = *P;
+    return true;
+  }
+};
+
+} // end anonymous namespace
+
+bool FlatSummaryIndex::isFlatSummaryIndex(MemoryBufferRef Buffer) {
+  return Buffer.getBuffer().startswith(StringRef(Magic, sizeof(Magic)));
+}
+
+Expected<std::unique_ptr<FlatSummaryIndex>>
+FlatSummaryIndex::create(MemoryBufferRef Buffer) {
+  if (!isFlatSummaryIndex(Buffer))
+    return malformed("invalid magic");
+  std::unique_ptr<FlatSummaryIndex> FSI(new FlatSummaryIndex(Buffer));
+  StringRef Data = Buffer.getBuffer();
+  SectionReader R(Data);
+  if (!R.read(FSI->Hdr))
+    return malformed("truncated header");
+  const Header &H = *FSI->Hdr;
+  if (H.Version != Version)
+    return malformed("unsupported version " + Twine(uint32_t(H.Version)));
+
+  auto GetSection = [&](StringRef &Section, uint64_t Offset, uint64_t Size) {
+    if (Offset > Data.size() || Data.size() - Offset < Size)
+      return false;
+    Section = Data.substr(Offset, Size);
+    return true;
+  };
+  StringRef ModulesSection, ValuesSection;
+  if (!GetSection(ModulesSection, H.ModulesOffset,
+                  uint64_t(H.NumModules) * sizeof(ModuleEntry)) ||
+      !SectionReader(ModulesSection).read(FSI->Modules, H.NumModules) ||
+      !GetSection(ValuesSection, H.ValuesOffset,
+                  uint64_t(H.NumValues) * sizeof(ValueEntry)) ||
+      !SectionReader(ValuesSection).read(FSI->Values, H.NumValues) ||
+      !GetSection(FSI->Summaries, H.SummariesOffset, H.SummariesSize) ||
+      !GetSection(FSI->Globals, H.GlobalsOffset, H.GlobalsSize) ||
+      !GetSection(FSI->Strings, H.StringsOffset, H.StringsSize))
+    return malformed("section out of bounds");
+
+  // findValue() looks GUIDs up with a binary search.
+  for (size_t I = 1; I < FSI->Values.size(); ++I)
+    if (FSI->Values[I - 1].GUID >= FSI->Values[I].GUID)
+      return malformed("GUID table is not sorted");
+
+  for (const ModuleEntry &M : FSI->Modules)
+    if (Error E = FSI->getString(M.PathOffset, M.PathSize).takeError())
+      return std::move(E);
+  return std::move(FSI);
+}
+
+Expected<StringRef> FlatSummaryIndex::getString(uint32_t Offset,
+                                                uint32_t Size) const {
+  if (Offset > Strings.size() || Strings.size() - Offset < Size)
+    return malformed("string out of bounds");
+  return Strings.substr(Offset, Size);
+}
+
+StringRef FlatSummaryIndex::getModulePath(unsigned I) const {
+  // The module paths are checked by create().
+  return Strings.substr(Modules[I].PathOffset, Modules[I].PathSize);
+}
+
+ModuleHash FlatSummaryIndex::getModuleHash(unsigned I) const {
+  ModuleHash Hash;
+  std::copy(std::begin(Modules[I].Hash), std::end(Modules[I].Hash),
+            Hash.begin());
+  return Hash;
+}
+
+Optional<unsigned> FlatSummaryIndex::findValue(GlobalValue::GUID GUID) const {
+  auto It = partition_point(
+      Values, [&](const ValueEntry &V) { return V.GUID < GUID; });
+  if (It == Values.end() || It->GUID != GUID)
+    return None;
+  return It - Values.begin();
+}
+
+unsigned FlatSummaryIndex::getNumSummaries(GlobalValue::GUID GUID) const {
+  if (Optional<unsigned> I = findValue(GUID))
+    return Values[*I].NumSummaries;
+  return 0;
+}
+
+Expected<std::unique_ptr<ModuleSummaryIndex>>
+FlatSummaryIndex::createIndex() const {
+  auto Index = std::make_unique<ModuleSummaryIndex>(/*HaveGVs=*/false);
+  decodeIndexFlags(Hdr->Flags, *Index);
+  for (unsigned I = 0, E = getNumModules(); I != E; ++I)
+    Index->addModule(getModulePath(I), getModuleId(I), getModuleHash(I));
+
+  SectionReader R(Globals);
+  auto ReadString = [&](std::string &S) -> Error {
+    uint32_t Offset, Size;
+    if (!R.read(Offset) || !R.read(Size))
+      return malformed("truncated globals");
+    Expected<StringRef> SOrErr = getString(Offset, Size);
+    if (!SOrErr)
+      return SOrErr.takeError();
+    S = SOrErr->str();
+    return Error::success();
+  };
+
+  for (auto *CfiFunctions :
+       {&Index->cfiFunctionDefs(), &Index->cfiFunctionDecls()}) {
+    uint32_t NumNames;
+    if (!R.read(NumNames))
+      return malformed("truncated globals");
+    for (uint32_t I = 0; I != NumNames; ++I) {
+      std::string Name;
+      if (Error E = ReadString(Name))
+        return std::move(E);
+      CfiFunctions->insert(std::move(Name));
+    }
+  }
+
+  uint32_t NumTypeIds;
+  if (!R.read(NumTypeIds))
+    return malformed("truncated globals");
+  for (uint32_t I = 0; I != NumTypeIds; ++I) {
+    std::string Name;
+    if (Error E = ReadString(Name))
+      return std::move(E);
+    TypeIdSummary &Summary = Index->getOrInsertTypeIdSummary(Name);
+    uint32_t Kind, SizeM1BitWidth, BitMask, NumWPDRes;
+    if (!R.read(Kind) || !R.read(SizeM1BitWidth) ||
+        !R.read(Summary.TTRes.AlignLog2) || !R.read(Summary.TTRes.SizeM1) ||
+        !R.read(BitMask) || !R.read(Summary.TTRes.InlineBits) ||
+        !R.read(NumWPDRes))
+      return malformed("truncated type identifier summary");
+    Summary.TTRes.TheKind = TypeTestResolution::Kind(Kind);
+    Summary.TTRes.SizeM1BitWidth = SizeM1BitWidth;
+    Summary.TTRes.BitMask = BitMask;
+
+    for (uint32_t J = 0; J != NumWPDRes; ++J) {
+      uint64_t Offset;
+      uint32_t NumResByArg;
+      if (!R.read(Offset) || !R.read(Kind))
+        return malformed("truncated type identifier summary");
+      WholeProgramDevirtResolution &WPD = Summary.WPDRes[Offset];
+      WPD.TheKind = WholeProgramDevirtResolution::Kind(Kind);
+      if (Error E = ReadString(WPD.SingleImplName))
+        return std::move(E);
+      if (!R.read(NumResByArg))
+        return malformed("truncated type identifier summary");
+
+      for (uint32_t K = 0; K != NumResByArg; ++K) {
+        uint32_t NumArgs;
+        ArrayRef<ulittle64_t> Args;
+        if (!R.read(NumArgs) || !R.read(Args, NumArgs))
+          return malformed("truncated type identifier summary");
+        WholeProgramDevirtResolution::ByArg &ByArg =
+            WPD.ResByArg[std::vector<uint64_t>(Args.begin(), Args.end())];
+        if (!R.read(Kind) || !R.read(ByArg.Info) || !R.read(ByArg.Byte) ||
+            !R.read(ByArg.Bit))
+          return malformed("truncated type identifier summary");
+        ByArg.TheKind = WholeProgramDevirtResolution::ByArg::Kind(Kind);
+      }
+    }
+  }
+  return std::move(Index);
+}
+
+Error FlatSummaryIndex::materializeValue(
+    unsigned ValueIndex, ModuleSummaryIndex &Index,
+    ArrayRef<StringRef> ModulePaths, ArrayRef<ValueInfo> ValueInfos,
+    bool Aliases, std::vector<unsigned> *AliasValues) const {
+  const ValueEntry &V = Values[ValueIndex];
+  SectionReader R(Summaries, V.SummariesOffset);
+  auto GetValueInfo = [&](uint32_t I) -> Expected<ValueInfo> {
+    if (I >= Values.size())
+      return malformed("value index out of bounds");
+    if (!ValueInfos.empty())
+      return ValueInfos[I];
+    return Index.getOrInsertValueInfo(GlobalValue::GUID(Values[I].GUID));
+  };
+  auto Truncated = [&] {
+    return malformed("truncated summary record of GUID " +
+                     Twine(uint64_t(V.GUID)));
+  };
+  ValueInfo VI = ValueInfos.empty()
+                     ? Index.getOrInsertValueInfo(GlobalValue::GUID(V.GUID))
+                     : ValueInfos[ValueIndex];
+
+  for (uint32_t I = 0; I != V.NumSummaries; ++I) {
+    const SummaryHeader *SH;
+    if (!R.read(SH))
+      return Truncated();
+    if (SH->Module >= Modules.size())
+      return malformed("module index out of bounds");
+    StringRef ModulePath;
+    if (!ModulePaths.empty())
+      ModulePath = ModulePaths[SH->Module];
+    else
+      ModulePath = Index.getModule(getModulePath(SH->Module))->first();
+    Expected<GlobalValueSummary::GVFlags> MaybeFlags = decodeGVFlags(SH->Flags);
+    if (!MaybeFlags)
+      return MaybeFlags.takeError();
+    GlobalValueSummary::GVFlags Flags = *MaybeFlags;
+
+    if (SH->Kind == GlobalValueSummary::AliasKind) {
+      uint32_t Aliasee;
+      if (!R.read(Aliasee))
+        return Truncated();
+      if (!Aliases) {
+        if (AliasValues &&
+            (AliasValues->empty() || AliasValues->back() != ValueIndex))
+          AliasValues->push_back(ValueIndex);
+        continue;
+      }
+      Expected<ValueInfo> AliaseeVI = GetValueInfo(Aliasee);
+      if (!AliaseeVI)
+        return AliaseeVI.takeError();
+      // When materializing a single value, materialize its aliasee too.
+      if (ModulePaths.empty() && AliaseeVI->getSummaryList().empty())
+        if (Error E = materializeValue(Aliasee, Index, ModulePaths,
+                                       ValueInfos, /*Aliases=*/false))
+          return E;
+      auto AS = std::make_unique<AliasSummary>(Flags);
+      AS->setModulePath(ModulePath);
+      AS->setAliasee(*AliaseeVI,
+                     Index.findSummaryInModule(*AliaseeVI, ModulePath));
+      AS->setOriginalName(SH->OriginalName);
+      Index.addGlobalValueSummary(VI, std::move(AS));
+      continue;
+    }
+
+    ArrayRef<ulittle32_t> RawRefs;
+    auto ReadRefs = [&]() -> Expected<std::vector<ValueInfo>> {
+      std::vector<ValueInfo> Refs;
+      if (!R.read(RawRefs, SH->NumRefs))
+        return Truncated();
+      if (Aliases)
+        return Refs;
+      Refs.reserve(RawRefs.size());
+      for (uint32_t RawRef : RawRefs) {
+        Expected<ValueInfo> RefVI = GetValueInfo(RawRef >> 2);
+        if (!RefVI)
+          return RefVI.takeError();
+        if (RawRef & 0x1)
+          RefVI->setReadOnly();
+        else if (RawRef & 0x2)
+          RefVI->setWriteOnly();
+        Refs.push_back(*RefVI);
+      }
+      return std::move(Refs);
+    };
+
+    if (SH->Kind == GlobalValueSummary::GlobalVarKind) {
+      uint32_t VarFlags;
+      if (!R.read(VarFlags))
+        return Truncated();
+      Expected<std::vector<ValueInfo>> Refs = ReadRefs();
+      if (!Refs)
+        return Refs.takeError();
+      if (Aliases)
+        continue;
+      auto VS = std::make_unique<GlobalVarSummary>(
+          Flags,
+          GlobalVarSummary::GVarFlags(VarFlags & 0x1, (VarFlags >> 1) & 0x1),
+          std::move(*Refs));
+      VS->setModulePath(ModulePath);
+      VS->setOriginalName(SH->OriginalName);
+      Index.addGlobalValueSummary(VI, std::move(VS));
+      continue;
+    }
+
+    if (SH->Kind != GlobalValueSummary::FunctionKind)
+      return malformed("invalid summary kind " + Twine(uint32_t(SH->Kind)));
+    const FunctionHeader *FH;
+    if (!R.read(FH))
+      return Truncated();
+    Expected<std::vector<ValueInfo>> Refs = ReadRefs();
+    if (!Refs)
+      return Refs.takeError();
+    ArrayRef<ulittle32_t> RawCalls;
+    ArrayRef<ulittle64_t> TypeTests, TypeTestAssumeVCalls,
+        TypeCheckedLoadVCalls;
+    if (!R.read(RawCalls, uint64_t(FH->NumCalls) * 2) ||
+        !R.read(TypeTests, FH->NumTypeTests) ||
+        !R.read(TypeTestAssumeVCalls,
+                uint64_t(FH->NumTypeTestAssumeVCalls) * 2) ||
+        !R.read(TypeCheckedLoadVCalls,
+                uint64_t(FH->NumTypeCheckedLoadVCalls) * 2))
+      return Truncated();
+    auto ReadConstVCalls =
+        [&](uint32_t NumVCalls,
+            std::vector<FunctionSummary::ConstVCall> &VCalls) {
+          for (uint32_t I = 0; I != NumVCalls; ++I) {
+            uint64_t GUID, Offset;
+            uint32_t NumArgs;
+            ArrayRef<ulittle64_t> Args;
+            if (!R.read(GUID) || !R.read(Offset) || !R.read(NumArgs) ||
+                !R.read(Args, NumArgs))
+              return false;
+            if (!Aliases)
+              VCalls.push_back(
+                  {{GUID, Offset},
+                   std::vector<uint64_t>(Args.begin(), Args.end())});
+          }
+          return true;
+        };
+    std::vector<FunctionSummary::ConstVCall> TypeTestAssumeConstVCalls,
+        TypeCheckedLoadConstVCalls;
+    if (!ReadConstVCalls(FH->NumTypeTestAssumeConstVCalls,
+                         TypeTestAssumeConstVCalls) ||
+        !ReadConstVCalls(FH->NumTypeCheckedLoadConstVCalls,
+                         TypeCheckedLoadConstVCalls))
+      return Truncated();
+    if (Aliases)
+      continue;
+
+    std::vector<FunctionSummary::EdgeTy> Calls;
+    Calls.reserve(FH->NumCalls);
+    for (size_t J = 0; J != RawCalls.size(); J += 2) {
+      Expected<ValueInfo> CalleeVI = GetValueInfo(RawCalls[J]);
+      if (!CalleeVI)
+        return CalleeVI.takeError();
+      Expected<CalleeInfo> Info = decodeCalleeInfo(RawCalls[J + 1]);
+      if (!Info)
+        return Info.takeError();
+      Calls.push_back({*CalleeVI, *Info});
+    }
+    auto GetVFuncIds = [](ArrayRef<ulittle64_t> Raw) {
+      std::vector<FunctionSummary::VFuncId> VFuncIds;
+      for (size_t J = 0; J != Raw.size(); J += 2)
+        VFuncIds.push_back({Raw[J], Raw[J + 1]});
+      return VFuncIds;
+    };
+    auto FS = std::make_unique<FunctionSummary>(
+        Flags, FH->InstCount, decodeFFlags(FH->FFlags), FH->EntryCount,
+        std::move(*Refs), std::move(Calls),
+        std::vector<GlobalValue::GUID>(TypeTests.begin(), TypeTests.end()),
+        GetVFuncIds(TypeTestAssumeVCalls), GetVFuncIds(TypeCheckedLoadVCalls),
+        std::move(TypeTestAssumeConstVCalls),
+        std::move(TypeCheckedLoadConstVCalls));
+    FS->setModulePath(ModulePath);
+    FS->setOriginalName(SH->OriginalName);
+    Index.addGlobalValueSummary(VI, std::move(FS));
+  }
+  return Error::success();
+}
+
+Expected<ValueInfo>
+FlatSummaryIndex::materialize(GlobalValue::GUID GUID,
+                              ModuleSummaryIndex &Index) const {
+  Optional<unsigned> I = findValue(GUID);
+  if (!I)
+    return ValueInfo();
+  ValueInfo VI = Index.getOrInsertValueInfo(GUID);
+  if (!VI.getSummaryList().empty())
+    return VI;
+  if (Error E = materializeValue(*I, Index, {}, {}, /*Aliases=*/false))
+    return std::move(E);
+  if (Error E = materializeValue(*I, Index, {}, {}, /*Aliases=*/true))
+    return std::move(E);
+  return VI;
+}
+
+Error FlatSummaryIndex::materializeAll(ModuleSummaryIndex &Index) const {
+  std::vector<StringRef> ModulePaths;
+  ModulePaths.reserve(getNumModules());
+  for (unsigned I = 0, E = getNumModules(); I != E; ++I)
+    ModulePaths.push_back(Index.getModule(getModulePath(I))->first());
+  // Like the bitcode reader, look up the ValueInfo of each value once rather
+  // than for each reference to it.
+  std::vector<ValueInfo> ValueInfos;
+  ValueInfos.reserve(getNumValues());
+  for (const ValueEntry &V : Values)
+    ValueInfos.push_back(
+        Index.getOrInsertValueInfo(GlobalValue::GUID(V.GUID)));
+
+  // Also like the bitcode reader, add the aliases once all the other
+  // summaries are in the index, so that their aliasee summaries can be found.
+  std::vector<unsigned> AliasValues;
+  for (unsigned I = 0, E = getNumValues(); I != E; ++I)
+    if (Error E = materializeValue(I, Index, ModulePaths, ValueInfos,
+                                   /*Aliases=*/false, &AliasValues))
+      return E;
+  for (unsigned I : AliasValues)
+    if (Error E = materializeValue(I, Index, ModulePaths, ValueInfos,
+                                   /*Aliases=*/true))
+      return E;
+  return Error::success();
+}
+
+Expected<std::unique_ptr<ModuleSummaryIndex>>
+llvm::readFlatSummaryIndex(MemoryBufferRef Buffer) {
+  Expected<std::unique_ptr<FlatSummaryIndex>> FSI =
+      FlatSummaryIndex::create(Buffer);
+  if (!FSI)
+    return FSI.takeError();
+  Expected<std::unique_ptr<ModuleSummaryIndex>> Index = (*FSI)->createIndex();
+  if (!Index)
+    return Index.takeError();
+  if (Error E = (*FSI)->materializeAll(**Index))
+    return std::move(E);
+  return Index;
+}
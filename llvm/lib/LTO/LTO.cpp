@@ -11,6 +11,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/LTO/LTO.h"
+#include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/Statistic.h"
 #include "llvm/Analysis/TargetLibraryInfo.h"
 #include "llvm/Analysis/TargetTransformInfo.h"
@@ -20,6 +21,7 @@
 #include "llvm/Config/llvm-config.h"
 #include "llvm/IR/AutoUpgrade.h"
 #include "llvm/IR/DiagnosticPrinter.h"
+#include "llvm/IR/FlatSummaryIndex.h"
 #include "llvm/IR/Intrinsics.h"
 #include "llvm/IR/LegacyPassManager.h"
 #include "llvm/IR/Mangler.h"
@@ -32,12 +34,15 @@
 #include "llvm/Support/Error.h"
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Parallel.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/Process.h"
 #include "llvm/Support/SHA1.h"
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/TargetRegistry.h"
 #include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/Threading.h"
+#include "llvm/Support/TimeProfiler.h"
 #include "llvm/Support/VCSRevision.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Target/TargetMachine.h"
@@ -60,11 +65,28 @@ static cl::opt<bool>
     DumpThinCGSCCs("dump-thin-cg-sccs", cl::init(false), cl::Hidden,
                    cl::desc("Dump the SCCs in the ThinLTO index's callgraph"));
 
+static cl::opt<unsigned> ThinLTOBackendBytesPerInst(
+    "thinlto-backend-bytes-per-inst", cl::init(1024), cl::Hidden,
+    cl::desc("Estimated memory used by a ThinLTO backend job per instruction "
+             "defined in or imported into its module"));
+
+static cl::opt<unsigned> ThinLTOBackendBytesPerBitcodeByte(
+    "thinlto-backend-bytes-per-bitcode-byte", cl::init(8), cl::Hidden,
+    cl::desc("Estimated memory used by a ThinLTO backend job per byte of the "
+             "bitcode of its module"));
+
+static cl::opt<bool> ThinLTOFlatIndex(
+    "thinlto-flat-index", cl::init(false), cl::Hidden,
+    cl::desc("Write the index files of distributed ThinLTO backends in the "
+             "flat summary index format instead of bitcode"));
+
 /// Enable global value internalization in LTO.
 cl::opt<bool> EnableLTOInternalization(
     "enable-lto-internalization", cl::init(true), cl::Hidden,
     cl::desc("Enable global value internalization in LTO"));
 
+extern cl::opt<bool> EnableParallelThinLink;
+
 // Computes a unique hash for the Module considering the current list of
 // export/import and other global analysis results.
 // The hash is produced in \p Key.
@@ -298,6 +320,30 @@ void llvm::computeLTOCacheKey(
   Key = toHex(Hasher.result());
 }
 
+// The index-based analyses below process the GUIDs of the index in chunks of
+// this size, in parallel unless -thinlto-parallel-thin-link=false. The chunks
+// don't depend on the number of threads, so that results combined in chunk
+// order are deterministic.
+static const size_t IndexChunkSize = 4096;
+
+static size_t getNumIndexChunks(size_t N) {
+  return (N + IndexChunkSize - 1) / IndexChunkSize;
+}
+
+// Call \p Fn with the bounds of each chunk of [0, \p N).
+static void forEachIndexChunk(size_t N,
+                              function_ref<void(size_t, size_t)> Fn) {
+  size_t NumChunks = getNumIndexChunks(N);
+  auto RunChunk = [&](size_t I) {
+    Fn(I * IndexChunkSize, std::min(N, (I + 1) * IndexChunkSize));
+  };
+  if (EnableParallelThinLink && NumChunks > 1)
+    parallel::for_each_n(parallel::par, size_t(0), NumChunks, RunChunk);
+  else
+    for (size_t I = 0; I != NumChunks; ++I)
+      RunChunk(I);
+}
+
 static void thinLTOResolvePrevailingGUID(
     ValueInfo VI, DenseSet<GlobalValueSummary *> &GlobalInvolvedWithAlias,
     function_ref<bool(GlobalValue::GUID, const GlobalValueSummary *)>
@@ -363,15 +409,39 @@ void llvm::thinLTOResolvePrevailingInIndex(
   // Ideally we should turn the alias into a global and duplicate the definition
   // when needed.
   DenseSet<GlobalValueSummary *> GlobalInvolvedWithAlias;
-  for (auto &I : Index)
+  std::vector<ValueInfo> VIs;
+  VIs.reserve(Index.size());
+  for (auto &I : Index) {
     for (auto &S : I.second.SummaryList)
       if (auto AS = dyn_cast<AliasSummary>(S.get()))
         GlobalInvolvedWithAlias.insert(&AS->getAliasee());
+    VIs.push_back(Index.getValueInfo(I));
+  }
 
-  for (auto &I : Index)
-    thinLTOResolvePrevailingGUID(Index.getValueInfo(I), GlobalInvolvedWithAlias,
-                                 isPrevailing, recordNewLinkage,
-                                 GUIDPreservedSymbols);
+  // Each GUID only changes its own summaries, so GUIDs are resolved in
+  // parallel. The new linkages are buffered per chunk and recorded in index
+  // order afterwards.
+  struct NewLinkage {
+    StringRef ModulePath;
+    GlobalValue::GUID GUID;
+    GlobalValue::LinkageTypes Linkage;
+  };
+  std::vector<std::vector<NewLinkage>> ChunkLinkages(
+      getNumIndexChunks(VIs.size()));
+  forEachIndexChunk(VIs.size(), [&](size_t Begin, size_t End) {
+    std::vector<NewLinkage> &NLs = ChunkLinkages[Begin / IndexChunkSize];
+    for (size_t I = Begin; I != End; ++I)
+      thinLTOResolvePrevailingGUID(
+          VIs[I], GlobalInvolvedWithAlias, isPrevailing,
+          [&](StringRef ModulePath, GlobalValue::GUID GUID,
+              GlobalValue::LinkageTypes Linkage) {
+            NLs.push_back({ModulePath, GUID, Linkage});
+          },
+          GUIDPreservedSymbols);
+  });
+  for (const std::vector<NewLinkage> &NLs : ChunkLinkages)
+    for (const NewLinkage &NL : NLs)
+      recordNewLinkage(NL.ModulePath, NL.GUID, NL.Linkage);
 }
 
 static bool isWeakObjectWithRWAccess(GlobalValueSummary *GVS) {
@@ -386,7 +456,8 @@ static void thinLTOInternalizeAndPromoteGUID(
     GlobalValueSummaryList &GVSummaryList, GlobalValue::GUID GUID,
     function_ref<bool(StringRef, GlobalValue::GUID)> isExported,
     function_ref<bool(GlobalValue::GUID, const GlobalValueSummary *)>
-        isPrevailing) {
+        isPrevailing,
+    const DenseSet<const GlobalValueSummary *> &WeakObjectsWithRWAccess) {
   for (auto &S : GVSummaryList) {
     if (isExported(S->modulePath(), GUID)) {
       if (GlobalValue::isLocalLinkage(S->linkage()))
@@ -406,7 +477,7 @@ static void thinLTOInternalizeAndPromoteGUID(
                // linkonce_odr and weak_odr variables which are both modified
                // and read somewhere in the program because reads and writes
                // will become inconsistent.
-               !isWeakObjectWithRWAccess(S.get()))
+               !WeakObjectsWithRWAccess.count(S.get()))
       S->setLinkage(GlobalValue::InternalLinkage);
   }
 }
@@ -418,9 +489,27 @@ void llvm::thinLTOInternalizeAndPromoteInIndex(
     function_ref<bool(StringRef, GlobalValue::GUID)> isExported,
     function_ref<bool(GlobalValue::GUID, const GlobalValueSummary *)>
         isPrevailing) {
-  for (auto &I : Index)
-    thinLTOInternalizeAndPromoteGUID(I.second.SummaryList, I.first, isExported,
-                                     isPrevailing);
+  // Whether an alias refers to a weak variable with RW access depends on the
+  // linkage of its aliasee, which belongs to another GUID and may be changed
+  // concurrently below. Find these summaries before any linkage changes.
+  std::vector<GlobalValueSummaryMapTy::value_type *> Entries;
+  DenseSet<const GlobalValueSummary *> WeakObjectsWithRWAccess;
+  Entries.reserve(Index.size());
+  for (auto &I : Index) {
+    Entries.push_back(&I);
+    for (auto &S : I.second.SummaryList)
+      if (isWeakObjectWithRWAccess(S.get()))
+        WeakObjectsWithRWAccess.insert(S.get());
+  }
+
+  // Each GUID only changes its own summaries, so GUIDs are processed in
+  // parallel.
+  forEachIndexChunk(Entries.size(), [&](size_t Begin, size_t End) {
+    for (size_t I = Begin; I != End; ++I)
+      thinLTOInternalizeAndPromoteGUID(Entries[I]->second.SummaryList,
+                                       Entries[I]->first, isExported,
+                                       isPrevailing, WeakObjectsWithRWAccess);
+  });
 }
 
 // Requires a destructor for std::vector<InputModule>.
@@ -1047,7 +1136,66 @@ public:
   virtual Error wait() = 0;
 };
 
+ThinBackendJobQueue::ThinBackendJobQueue(unsigned MaxRunningJobs,
+                                         uint64_t MemoryLimit)
+    : MaxRunningJobs(std::max(MaxRunningJobs, 1u)), MemoryLimit(MemoryLimit) {}
+
+void ThinBackendJobQueue::push(uint64_t Memory, std::function<void()> Job) {
+  Pending.emplace(Memory, std::move(Job));
+}
+
+bool ThinBackendJobQueue::startNext(std::function<void()> &Job,
+                                    uint64_t &Memory) {
+  if (RunningJobs >= MaxRunningJobs || Pending.empty())
+    return false;
+  auto It = std::prev(Pending.end());
+  if (MemoryLimit && RunningJobs) {
+    if (RunningMemory >= MemoryLimit)
+      return false;
+    It = Pending.upper_bound(MemoryLimit - RunningMemory);
+    if (It == Pending.begin())
+      return false;
+    --It;
+  }
+
+  Memory = It->first;
+  Job = std::move(It->second);
+  Pending.erase(It);
+  ++RunningJobs;
+  RunningMemory += Memory;
+  return true;
+}
+
+void ThinBackendJobQueue::finish(uint64_t Memory) {
+  assert(RunningJobs && RunningMemory >= Memory);
+  --RunningJobs;
+  RunningMemory -= Memory;
+}
+
 namespace {
+// Estimate the peak memory used by the backend job for \p BM. The bitcode
+// size accounts for globals, metadata and debug info, and the instruction
+// counts from the summaries for the functions defined in the module and the
+// functions imported into it, which dominate optimization and code generation.
+uint64_t estimateBackendMemory(const ModuleSummaryIndex &CombinedIndex,
+                               BitcodeModule BM,
+                               const FunctionImporter::ImportMapTy &ImportList,
+                               const GVSummaryMapTy &DefinedGlobals) {
+  uint64_t NumInsts = 0;
+  for (auto &Def : DefinedGlobals)
+    if (auto *FS = dyn_cast<FunctionSummary>(Def.second))
+      NumInsts += FS->instCount();
+  for (auto &Import : ImportList)
+    for (GlobalValue::GUID GUID : Import.second)
+      if (auto *FS = dyn_cast_or_null<FunctionSummary>(
+              CombinedIndex.findSummaryInModule(GUID, Import.first())))
+        NumInsts += FS->instCount();
+  return BM.getBuffer().size() * (uint64_t)ThinLTOBackendBytesPerBitcodeByte +
+         NumInsts * ThinLTOBackendBytesPerInst;
+}
+
+// Backend jobs are queued by start() and only launched by wait(), so that they
+// can be scheduled knowing all of them. ThinBackendJobQueue decides the order.
 class InProcessThinBackend : public ThinBackendProc {
   ThreadPool BackendThreadPool;
   AddStreamFn AddStream;
@@ -1058,15 +1206,19 @@ class InProcessThinBackend : public ThinBackendProc {
   Optional<Error> Err;
   std::mutex ErrMu;
 
+  ThinBackendJobQueue Jobs;
+  std::mutex ScheduleMu;
+
 public:
   InProcessThinBackend(
       Config &Conf, ModuleSummaryIndex &CombinedIndex,
-      unsigned ThinLTOParallelismLevel,
+      unsigned ThinLTOParallelismLevel, uint64_t MemoryLimit,
       const StringMap<GVSummaryMapTy> &ModuleToDefinedGVSummaries,
       AddStreamFn AddStream, NativeObjectCache Cache)
       : ThinBackendProc(Conf, CombinedIndex, ModuleToDefinedGVSummaries),
         BackendThreadPool(ThinLTOParallelismLevel),
-        AddStream(std::move(AddStream)), Cache(std::move(Cache)) {
+        AddStream(std::move(AddStream)), Cache(std::move(Cache)),
+        Jobs(ThinLTOParallelismLevel, MemoryLimit) {
     for (auto &Name : CombinedIndex.cfiFunctionDefs())
       CfiFunctionDefs.insert(
           GlobalValue::getGUID(GlobalValue::dropLLVMManglingEscape(Name)));
@@ -1123,47 +1275,80 @@ public:
     assert(ModuleToDefinedGVSummaries.count(ModulePath));
     const GVSummaryMapTy &DefinedGlobals =
         ModuleToDefinedGVSummaries.find(ModulePath)->second;
-    BackendThreadPool.async(
-        [=](BitcodeModule BM, ModuleSummaryIndex &CombinedIndex,
-            const FunctionImporter::ImportMapTy &ImportList,
-            const FunctionImporter::ExportSetTy &ExportList,
-            const std::map<GlobalValue::GUID, GlobalValue::LinkageTypes>
-                &ResolvedODR,
-            const GVSummaryMapTy &DefinedGlobals,
-            MapVector<StringRef, BitcodeModule> &ModuleMap) {
-          Error E = runThinLTOBackendThread(
-              AddStream, Cache, Task, BM, CombinedIndex, ImportList, ExportList,
-              ResolvedODR, DefinedGlobals, ModuleMap);
-          if (E) {
-            std::unique_lock<std::mutex> L(ErrMu);
-            if (Err)
-              Err = joinErrors(std::move(*Err), std::move(E));
-            else
-              Err = std::move(E);
-          }
-        },
-        BM, std::ref(CombinedIndex), std::ref(ImportList), std::ref(ExportList),
-        std::ref(ResolvedODR), std::ref(DefinedGlobals), std::ref(ModuleMap));
+    uint64_t Memory =
+        estimateBackendMemory(CombinedIndex, BM, ImportList, DefinedGlobals);
+    Jobs.push(Memory, [=, &ImportList, &ExportList, &ResolvedODR,
+                                 &DefinedGlobals, &ModuleMap] {
+      TimeTraceScope TimeScope("ThinLTO backend", [&] {
+        return (ModulePath + " (estimated " + Twine(Memory >> 20) + " MiB)")
+            .str();
+      });
+      Error E = runThinLTOBackendThread(AddStream, Cache, Task, BM,
+                                        CombinedIndex, ImportList, ExportList,
+                                        ResolvedODR, DefinedGlobals, ModuleMap);
+      if (E) {
+        std::unique_lock<std::mutex> L(ErrMu);
+        if (Err)
+          Err = joinErrors(std::move(*Err), std::move(E));
+        else
+          Err = std::move(E);
+      }
+    });
     return Error::success();
   }
 
   Error wait() override {
+    {
+      std::lock_guard<std::mutex> L(ScheduleMu);
+      launchJobs();
+    }
     BackendThreadPool.wait();
     if (Err)
       return std::move(*Err);
     else
       return Error::success();
   }
+
+private:
+  // Launch as many pending jobs as the thread and memory limits allow. Called
+  // with ScheduleMu held, initially and whenever a job finishes.
+  void launchJobs() {
+    std::function<void()> Job;
+    uint64_t Memory;
+    while (Jobs.startNext(Job, Memory)) {
+      BackendThreadPool.async([this, Memory, Job = std::move(Job)] {
+        Job();
+        std::lock_guard<std::mutex> L(ScheduleMu);
+        Jobs.finish(Memory);
+        traceJobs();
+        launchJobs();
+      });
+      traceJobs();
+    }
+  }
+
+  // Record the running jobs and their estimated memory for -time-trace, along
+  // with the memory actually in use, to help tune the estimates.
+  void traceJobs() {
+    if (!timeTraceProfilerEnabled())
+      return;
+    timeTraceProfilerCounter(
+        "ThinLTO backend jobs",
+        {{"running", Jobs.getRunningJobs()},
+         {"estimated bytes", Jobs.getRunningMemory()},
+         {"malloc bytes", sys::Process::GetMallocUsage()}});
+  }
 };
 } // end anonymous namespace
 
-ThinBackend lto::createInProcessThinBackend(unsigned ParallelismLevel) {
+ThinBackend lto::createInProcessThinBackend(unsigned ParallelismLevel,
+                                           uint64_t MemoryLimit) {
   return [=](Config &Conf, ModuleSummaryIndex &CombinedIndex,
              const StringMap<GVSummaryMapTy> &ModuleToDefinedGVSummaries,
              AddStreamFn AddStream, NativeObjectCache Cache) {
     return std::make_unique<InProcessThinBackend>(
-        Conf, CombinedIndex, ParallelismLevel, ModuleToDefinedGVSummaries,
-        AddStream, Cache);
+        Conf, CombinedIndex, ParallelismLevel, MemoryLimit,
+        ModuleToDefinedGVSummaries, AddStream, Cache);
   };
 }
 
@@ -1227,7 +1412,10 @@ public:
                       sys::fs::OpenFlags::OF_None);
     if (EC)
       return errorCodeToError(EC);
-    WriteIndexToFile(CombinedIndex, OS, &ModuleToSummariesForIndex);
+    if (ThinLTOFlatIndex)
+      writeFlatSummaryIndex(CombinedIndex, OS, &ModuleToSummariesForIndex);
+    else
+      WriteIndexToFile(CombinedIndex, OS, &ModuleToSummariesForIndex);
 
     if (ShouldEmitImportsFiles) {
       EC = EmitImportsFiles(ModulePath, NewModulePath + ".imports",
@@ -1344,7 +1532,7 @@ Error LTO::runThinLTO(AddStreamFn AddStream, NativeObjectCache Cache,
 
   auto isPrevailing = [&](GlobalValue::GUID GUID,
                           const GlobalValueSummary *S) {
-    return ThinLTO.PrevailingModuleForGUID[GUID] == S->modulePath();
+    return ThinLTO.PrevailingModuleForGUID.lookup(GUID) == S->modulePath();
   };
   thinLTOInternalizeAndPromoteInIndex(ThinLTO.CombinedIndex, isExported,
                                       isPrevailing);
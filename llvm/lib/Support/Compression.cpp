@@ -13,21 +13,41 @@
 #include "llvm/Support/Compression.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringRef.h"
+#include "llvm/ADT/Twine.h"
 #include "llvm/Config/config.h"
 #include "llvm/Support/Compiler.h"
+#include "llvm/Support/Endian.h"
 #include "llvm/Support/Error.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Support/Parallel.h"
 #if LLVM_ENABLE_ZLIB == 1 && HAVE_ZLIB_H
 #include <zlib.h>
 #endif
+#if LLVM_ENABLE_ZSTD == 1
+#include <zstd.h>
+#endif
+#include <vector>
 
 using namespace llvm;
 
-#if LLVM_ENABLE_ZLIB == 1 && HAVE_LIBZ
-static Error createError(StringRef Err) {
+#if (LLVM_ENABLE_ZLIB == 1 && HAVE_LIBZ) || LLVM_ENABLE_ZSTD == 1
+static Error createError(const Twine &Err) {
   return make_error<StringError>(Err, inconvertibleErrorCode());
 }
 
+// Calls Fn for each chunk index, on all threads if UseThreads is true.
+static void forEachChunk(size_t NumChunks, bool UseThreads,
+                         function_ref<void(size_t)> Fn) {
+  if (UseThreads)
+    for_each_n(parallel::par, size_t(0), NumChunks, Fn);
+  else
+    for_each_n(parallel::seq, size_t(0), NumChunks, Fn);
+}
+#endif
+
+#if LLVM_ENABLE_ZLIB == 1 && HAVE_LIBZ
+
 static StringRef convertZlibCodeToString(int Code) {
   switch (Code) {
   case Z_MEM_ERROR:
@@ -60,6 +80,75 @@ Error zlib::compress(StringRef InputBuffer,
   return Res ? createError(convertZlibCodeToString(Res)) : Error::success();
 }
 
+// Deflate Input as raw deflate data with no zlib header or trailer. Unless
+// this is the last chunk, end with a full flush, which byte-aligns the output
+// and resets the dictionary so that chunks can simply be concatenated.
+static int deflateChunk(StringRef Input, int Level, bool Last,
+                        SmallVectorImpl<char> &Out) {
+  z_stream S = {};
+  int Res = ::deflateInit2(&S, Level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY);
+  if (Res != Z_OK)
+    return Res;
+  S.next_in = (Bytef *)Input.data();
+  S.avail_in = Input.size();
+  Out.resize(::deflateBound(&S, Input.size()) + 16);
+  size_t Pos = 0;
+  do {
+    if (Pos == Out.size())
+      Out.resize(Out.size() * 3 / 2);
+    S.next_out = (Bytef *)Out.data() + Pos;
+    S.avail_out = Out.size() - Pos;
+    Res = ::deflate(&S, Last ? Z_FINISH : Z_FULL_FLUSH);
+    Pos = (char *)S.next_out - Out.data();
+  } while (S.avail_out == 0);
+  ::deflateEnd(&S);
+  // Tell MemorySanitizer that zlib output buffer is fully initialized.
+  // This avoids a false report when running LLVM with uninstrumented ZLib.
+  __msan_unpoison(Out.data(), Pos);
+  Out.resize(Pos);
+  return Res == Z_STREAM_END ? Z_OK : Res;
+}
+
+Error zlib::compressParallel(StringRef InputBuffer,
+                             SmallVectorImpl<char> &CompressedBuffer,
+                             int Level, size_t ChunkSize, bool UseThreads) {
+  size_t NumChunks = divideCeil(InputBuffer.size(), ChunkSize);
+  if (NumChunks <= 1)
+    return compress(InputBuffer, CompressedBuffer, Level);
+
+  std::vector<SmallVector<char, 0>> Chunks(NumChunks);
+  std::vector<uint32_t> Checksums(NumChunks);
+  std::vector<int> Results(NumChunks);
+  forEachChunk(NumChunks, UseThreads, [&](size_t I) {
+    StringRef Chunk = InputBuffer.substr(I * ChunkSize, ChunkSize);
+    Results[I] = deflateChunk(Chunk, Level, I == NumChunks - 1, Chunks[I]);
+    Checksums[I] = ::adler32(1, (const Bytef *)Chunk.data(), Chunk.size());
+  });
+  for (int Res : Results)
+    if (Res != Z_OK)
+      return createError(convertZlibCodeToString(Res));
+
+  // Wrap the concatenated deflate data in a zlib header (deflate with a 32 KiB
+  // window, default level) and the Adler-32 checksum of the whole input.
+  size_t Size = 6;
+  for (const SmallVector<char, 0> &Chunk : Chunks)
+    Size += Chunk.size();
+  CompressedBuffer.clear();
+  CompressedBuffer.reserve(Size);
+  CompressedBuffer.push_back(0x78);
+  CompressedBuffer.push_back(0x9c);
+  uLong Checksum = 1;
+  for (size_t I = 0; I < NumChunks; ++I) {
+    CompressedBuffer.append(Chunks[I].begin(), Chunks[I].end());
+    size_t ChunkLen = std::min(ChunkSize, InputBuffer.size() - I * ChunkSize);
+    Checksum = ::adler32_combine(Checksum, Checksums[I], ChunkLen);
+  }
+  char Trailer[4];
+  support::endian::write32be(Trailer, Checksum);
+  CompressedBuffer.append(Trailer, Trailer + 4);
+  return Error::success();
+}
+
 Error zlib::uncompress(StringRef InputBuffer, char *UncompressedBuffer,
                        size_t &UncompressedSize) {
   int Res =
@@ -91,6 +180,11 @@ Error zlib::compress(StringRef InputBuffer,
                      SmallVectorImpl<char> &CompressedBuffer, int Level) {
   llvm_unreachable("zlib::compress is unavailable");
 }
+Error zlib::compressParallel(StringRef InputBuffer,
+                             SmallVectorImpl<char> &CompressedBuffer,
+                             int Level, size_t ChunkSize, bool UseThreads) {
+  llvm_unreachable("zlib::compressParallel is unavailable");
+}
 Error zlib::uncompress(StringRef InputBuffer, char *UncompressedBuffer,
                        size_t &UncompressedSize) {
   llvm_unreachable("zlib::uncompress is unavailable");
@@ -104,3 +198,172 @@ uint32_t zlib::crc32(StringRef Buffer) {
   llvm_unreachable("zlib::crc32 is unavailable");
 }
 #endif
+
+#if LLVM_ENABLE_ZSTD == 1
+bool zstd::isAvailable() { return true; }
+
+Error zstd::compress(StringRef InputBuffer,
+                     SmallVectorImpl<char> &CompressedBuffer, int Level) {
+  size_t CompressedBufferSize = ::ZSTD_compressBound(InputBuffer.size());
+  CompressedBuffer.reserve(CompressedBufferSize);
+  size_t CompressedSize =
+      ::ZSTD_compress(CompressedBuffer.data(), CompressedBufferSize,
+                      InputBuffer.data(), InputBuffer.size(), Level);
+  if (ZSTD_isError(CompressedSize))
+    return createError(Twine("zstd error: ") +
+                       ::ZSTD_getErrorName(CompressedSize));
+  // Tell MemorySanitizer that zstd output buffer is fully initialized.
+  // This avoids a false report when running LLVM with uninstrumented zstd.
+  __msan_unpoison(CompressedBuffer.data(), CompressedSize);
+  CompressedBuffer.set_size(CompressedSize);
+  return Error::success();
+}
+
+Error zstd::compressParallel(StringRef InputBuffer,
+                             SmallVectorImpl<char> &CompressedBuffer,
+                             int Level, size_t ChunkSize, bool UseThreads) {
+  size_t NumChunks = divideCeil(InputBuffer.size(), ChunkSize);
+  if (NumChunks <= 1)
+    return compress(InputBuffer, CompressedBuffer, Level);
+
+  // Compress each chunk into its own frame. A zstd decoder decompresses
+  // concatenated frames as if they were one.
+  std::vector<SmallVector<char, 0>> Chunks(NumChunks);
+  std::vector<size_t> Results(NumChunks);
+  forEachChunk(NumChunks, UseThreads, [&](size_t I) {
+    StringRef Chunk = InputBuffer.substr(I * ChunkSize, ChunkSize);
+    Chunks[I].resize(::ZSTD_compressBound(Chunk.size()));
+    Results[I] = ::ZSTD_compress(Chunks[I].data(), Chunks[I].size(),
+                                 Chunk.data(), Chunk.size(), Level);
+    if (!ZSTD_isError(Results[I]))
+      Chunks[I].resize(Results[I]);
+  });
+  for (size_t Res : Results)
+    if (ZSTD_isError(Res))
+      return createError(Twine("zstd error: ") + ::ZSTD_getErrorName(Res));
+
+  size_t Size = 0;
+  for (const SmallVector<char, 0> &Chunk : Chunks)
+    Size += Chunk.size();
+  CompressedBuffer.clear();
+  CompressedBuffer.reserve(Size);
+  for (const SmallVector<char, 0> &Chunk : Chunks)
+    CompressedBuffer.append(Chunk.begin(), Chunk.end());
+  return Error::success();
+}
+
+Error zstd::uncompress(StringRef InputBuffer, char *UncompressedBuffer,
+                       size_t &UncompressedSize) {
+  size_t Res = ::ZSTD_decompress(UncompressedBuffer, UncompressedSize,
+                                 InputBuffer.data(), InputBuffer.size());
+  if (ZSTD_isError(Res))
+    return createError(Twine("zstd error: ") + ::ZSTD_getErrorName(Res));
+  UncompressedSize = Res;
+  // Tell MemorySanitizer that zstd output buffer is fully initialized.
+  // This avoids a false report when running LLVM with uninstrumented zstd.
+  __msan_unpoison(UncompressedBuffer, UncompressedSize);
+  return Error::success();
+}
+
+Error zstd::uncompress(StringRef InputBuffer,
+                       SmallVectorImpl<char> &UncompressedBuffer,
+                       size_t UncompressedSize) {
+  UncompressedBuffer.resize(UncompressedSize);
+  Error E =
+      uncompress(InputBuffer, UncompressedBuffer.data(), UncompressedSize);
+  UncompressedBuffer.resize(UncompressedSize);
+  return E;
+}
+
+#else
+bool zstd::isAvailable() { return false; }
+Error zstd::compress(StringRef InputBuffer,
+                     SmallVectorImpl<char> &CompressedBuffer, int Level) {
+  llvm_unreachable("zstd::compress is unavailable");
+}
+Error zstd::compressParallel(StringRef InputBuffer,
+                             SmallVectorImpl<char> &CompressedBuffer,
+                             int Level, size_t ChunkSize, bool UseThreads) {
+  llvm_unreachable("zstd::compressParallel is unavailable");
+}
+Error zstd::uncompress(StringRef InputBuffer, char *UncompressedBuffer,
+                       size_t &UncompressedSize) {
+  llvm_unreachable("zstd::uncompress is unavailable");
+}
+Error zstd::uncompress(StringRef InputBuffer,
+                       SmallVectorImpl<char> &UncompressedBuffer,
+                       size_t UncompressedSize) {
+  llvm_unreachable("zstd::uncompress is unavailable");
+}
+#endif
+
+const char *compression::getName(Format F) {
+  switch (F) {
+  case Format::Zlib:
+    return "zlib";
+  case Format::Zstd:
+    return "zstd";
+  }
+  llvm_unreachable("unknown compression format");
+}
+
+bool compression::isAvailable(Format F) {
+  switch (F) {
+  case Format::Zlib:
+    return zlib::isAvailable();
+  case Format::Zstd:
+    return zstd::isAvailable();
+  }
+  llvm_unreachable("unknown compression format");
+}
+
+Error compression::compress(Format F, StringRef InputBuffer,
+                            SmallVectorImpl<char> &CompressedBuffer) {
+  switch (F) {
+  case Format::Zlib:
+    return zlib::compress(InputBuffer, CompressedBuffer);
+  case Format::Zstd:
+    return zstd::compress(InputBuffer, CompressedBuffer);
+  }
+  llvm_unreachable("unknown compression format");
+}
+
+Error compression::compressParallel(Format F, StringRef InputBuffer,
+                                    SmallVectorImpl<char> &CompressedBuffer,
+                                    bool UseThreads) {
+  switch (F) {
+  case Format::Zlib:
+    return zlib::compressParallel(InputBuffer, CompressedBuffer,
+                                  zlib::DefaultCompression,
+                                  zlib::DefaultChunkSize, UseThreads);
+  case Format::Zstd:
+    return zstd::compressParallel(InputBuffer, CompressedBuffer,
+                                  zstd::DefaultCompression,
+                                  zstd::DefaultChunkSize, UseThreads);
+  }
+  llvm_unreachable("unknown compression format");
+}
+
+Error compression::uncompress(Format F, StringRef InputBuffer,
+                              char *UncompressedBuffer,
+                              size_t &UncompressedSize) {
+  switch (F) {
+  case Format::Zlib:
+    return zlib::uncompress(InputBuffer, UncompressedBuffer, UncompressedSize);
+  case Format::Zstd:
+    return zstd::uncompress(InputBuffer, UncompressedBuffer, UncompressedSize);
+  }
+  llvm_unreachable("unknown compression format");
+}
+
+Error compression::uncompress(Format F, StringRef InputBuffer,
+                              SmallVectorImpl<char> &UncompressedBuffer,
+                              size_t UncompressedSize) {
+  switch (F) {
+  case Format::Zlib:
+    return zlib::uncompress(InputBuffer, UncompressedBuffer, UncompressedSize);
+  case Format::Zstd:
+    return zstd::uncompress(InputBuffer, UncompressedBuffer, UncompressedSize);
+  }
+  llvm_unreachable("unknown compression format");
+}
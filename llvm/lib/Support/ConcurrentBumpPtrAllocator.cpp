@@ -0,0 +1,53 @@
+//===- ConcurrentBumpPtrAllocator.cpp - Thread-caching arenas -------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the thread-local cache used by the concurrent bump
+// pointer allocators.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/ConcurrentBumpPtrAllocator.h"
+#include <atomic>
+
+using namespace llvm;
+
+namespace {
+struct CacheEntry {
+  uint64_t ID;
+  void *Alloc;
+};
+} // namespace
+
+// A direct-mapped cache from allocator IDs to the calling thread's allocators.
+// IDs are handed out sequentially, so up to CacheSize live allocators never
+// evict each other.
+static constexpr unsigned CacheSize = 128;
+static LLVM_THREAD_LOCAL CacheEntry ThreadCache[CacheSize];
+static LLVM_THREAD_LOCAL unsigned ThreadID;
+
+static std::atomic<uint64_t> NextAllocatorID(1);
+static std::atomic<unsigned> NextThreadID(1);
+
+uint64_t llvm::detail::getNextConcurrentAllocatorID() {
+  return NextAllocatorID++;
+}
+
+unsigned llvm::detail::getConcurrentAllocatorThreadID() {
+  if (!ThreadID)
+    ThreadID = NextThreadID++;
+  return ThreadID;
+}
+
+void *llvm::detail::lookupThreadAllocator(uint64_t ID) {
+  CacheEntry &Entry = ThreadCache[ID % CacheSize];
+  return Entry.ID == ID ? Entry.Alloc : nullptr;
+}
+
+void llvm::detail::cacheThreadAllocator(uint64_t ID, void *Alloc) {
+  ThreadCache[ID % CacheSize] = {ID, Alloc};
+}
@@ -15,15 +15,24 @@
 #include "llvm/ADT/SmallString.h"
 #include "llvm/Support/Errc.h"
 #include "llvm/Support/Memory.h"
+#include "llvm/Support/MathExtras.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/Signals.h"
+#include "llvm/Support/raw_ostream.h"
 #include <system_error>
 
 #if !defined(_MSC_VER) && !defined(__MINGW32__)
+#include <sys/file.h>
 #include <unistd.h>
 #else
 #include <io.h>
 #endif
 
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
 using namespace llvm;
 using namespace llvm::sys;
 
@@ -66,6 +75,21 @@ public:
     consumeError(Temp.discard());
   }
 
+  void finalizeRange(size_t Offset, size_t Size) override {
+#if defined(__linux__)
+    // Start writing back the pages in the range and unmap them from our
+    // address space. Dirty pages of a shared file mapping stay in the page
+    // cache, so accessing them again simply faults them back in.
+    size_t PageSize = fs::mapped_file_region::alignment();
+    size_t Begin = alignTo(Offset, PageSize);
+    size_t End = alignDown(Offset + Size, PageSize);
+    if (Begin >= End)
+      return;
+    ::sync_file_range(Temp.FD, Begin, End - Begin, SYNC_FILE_RANGE_WRITE);
+    ::madvise(Buffer->data() + Begin, End - Begin, MADV_DONTNEED);
+#endif
+  }
+
 private:
   std::unique_ptr<fs::mapped_file_region> Buffer;
   fs::TempFile Temp;
@@ -112,16 +136,137 @@ private:
   size_t BufferSize;
   unsigned Mode;
 };
+
+// A FileOutputBuffer which keeps data in memory and, on commit(), overwrites
+// the parts of the existing output file that differ from the buffer. Blocks
+// that are already up to date are neither written nor dirtied, which makes
+// repeatedly producing a mostly unchanged large file cheap.
+class InPlaceBuffer : public FileOutputBuffer {
+public:
+  InPlaceBuffer(StringRef Path, MemoryBlock Buf, std::size_t BufSize,
+                unsigned Mode)
+      : FileOutputBuffer(Path), Buffer(Buf), BufferSize(BufSize), Mode(Mode) {}
+
+  uint8_t *getBufferStart() const override { return (uint8_t *)Buffer.base(); }
+
+  uint8_t *getBufferEnd() const override {
+    return (uint8_t *)Buffer.base() + BufferSize;
+  }
+
+  size_t getBufferSize() const override { return BufferSize; }
+
+  Error commit() override {
+    using namespace sys::fs;
+    int FD;
+    if (openFileForReadWrite(FinalPath, FD, CD_OpenExisting, OF_None))
+      return replace();
+
+    // Another process updating the file at the same time, such as a
+    // concurrent link with the same output, would interleave its blocks with
+    // ours. So we only update the file in place if we can lock it.
+    if (!lockExclusively(FD)) {
+      Process::SafelyCloseFileDescriptor(FD);
+      return replace();
+    }
+
+    // Until all blocks are written, the file is a mix of its old and new
+    // contents. If we are interrupted, remove it rather than leave it
+    // corrupt.
+    sys::RemoveFileOnSignal(FinalPath);
+    std::error_code EC;
+    {
+      // If we cannot map the existing file, we just write everything.
+      std::error_code MapEC;
+      mapped_file_region Old(convertFDToNativeFile(FD),
+                             mapped_file_region::readonly, BufferSize, 0,
+                             MapEC);
+
+      raw_fd_ostream OS(FD, /*shouldClose=*/true, /*unbuffered=*/true);
+      const char *New = (const char *)Buffer.base();
+      const size_t BlockSize = 64 * 1024;
+      for (size_t I = 0; I < BufferSize; I += BlockSize) {
+        size_t N = std::min(BlockSize, BufferSize - I);
+        if (!MapEC && memcmp(Old.const_data() + I, New + I, N) == 0)
+          continue;
+        OS.seek(I);
+        OS.write(New + I, N);
+      }
+
+      // If no block changed, nothing updated the modification time, but
+      // build systems expect the output to be newer than its inputs.
+      EC = OS.error();
+      OS.clear_error();
+      if (!EC)
+        EC = setLastAccessAndModificationTime(FD,
+                                              std::chrono::system_clock::now());
+    }
+    sys::DontRemoveFileOnSignal(FinalPath);
+    return errorCodeToError(EC);
+  }
+
+private:
+  // Returns true if we got an exclusive advisory lock on the file, which is
+  // released when FD is closed. The lock does not interrupt other processes,
+  // unlike a lease, which would send them SIGIO, but it only keeps out
+  // processes that lock the file too.
+  static bool lockExclusively(int FD) {
+#if !defined(_MSC_VER) && !defined(__MINGW32__)
+    return ::flock(FD, LOCK_EX | LOCK_NB) == 0;
+#else
+    return false;
+#endif
+  }
+
+  // Otherwise, or if the existing file is not writable (e.g. it may be an
+  // executable that is currently running), we atomically replace it with a
+  // new file just like OnDiskBuffer does.
+  Error replace() {
+    Expected<fs::TempFile> FileOrErr =
+        fs::TempFile::create(FinalPath + ".tmp%%%%%%%", Mode);
+    if (!FileOrErr)
+      return FileOrErr.takeError();
+    fs::TempFile File = std::move(*FileOrErr);
+    {
+      raw_fd_ostream OS(File.FD, /*shouldClose=*/false, /*unbuffered=*/true);
+      OS << StringRef((const char *)Buffer.base(), BufferSize);
+      if (std::error_code EC = OS.error()) {
+        OS.clear_error();
+        consumeError(File.discard());
+        return errorCodeToError(EC);
+      }
+    }
+    return File.keep(FinalPath);
+  }
+
+  OwningMemoryBlock Buffer;
+  size_t BufferSize;
+  unsigned Mode;
+};
 } // namespace
 
-static Expected<std::unique_ptr<InMemoryBuffer>>
-createInMemoryBuffer(StringRef Path, size_t Size, unsigned Mode) {
+static Expected<MemoryBlock> allocateBuffer(size_t Size) {
   std::error_code EC;
   MemoryBlock MB = Memory::allocateMappedMemory(
       Size, nullptr, sys::Memory::MF_READ | sys::Memory::MF_WRITE, EC);
   if (EC)
     return errorCodeToError(EC);
-  return std::make_unique<InMemoryBuffer>(Path, MB, Size, Mode);
+  return MB;
+}
+
+static Expected<std::unique_ptr<InMemoryBuffer>>
+createInMemoryBuffer(StringRef Path, size_t Size, unsigned Mode) {
+  Expected<MemoryBlock> MBOrErr = allocateBuffer(Size);
+  if (!MBOrErr)
+    return MBOrErr.takeError();
+  return std::make_unique<InMemoryBuffer>(Path, *MBOrErr, Size, Mode);
+}
+
+static Expected<std::unique_ptr<InPlaceBuffer>>
+createInPlaceBuffer(StringRef Path, size_t Size, unsigned Mode) {
+  Expected<MemoryBlock> MBOrErr = allocateBuffer(Size);
+  if (!MBOrErr)
+    return MBOrErr.takeError();
+  return std::make_unique<InPlaceBuffer>(Path, *MBOrErr, Size, Mode);
 }
 
 static Expected<std::unique_ptr<FileOutputBuffer>>
@@ -187,6 +332,9 @@ FileOutputBuffer::create(StringRef Path, size_t Size, unsigned Flags) {
   case fs::file_type::directory_file:
     return errorCodeToError(errc::is_a_directory);
   case fs::file_type::regular_file:
+    if ((Flags & F_modify) && Stat.getSize() == Size)
+      return createInPlaceBuffer(Path, Size, Mode);
+    LLVM_FALLTHROUGH;
   case fs::file_type::file_not_found:
   case fs::file_type::status_error:
     if (Flags & F_no_mmap)
@@ -31,6 +31,18 @@ static bool skipIfAtLineEnd(const char *&P) {
   return false;
 }
 
+/// Return the end of the line starting at \p Start: the first "\n", "\r\n"
+/// or null byte at or after \p Start. \p End is the end of the buffer.
+static const char *findLineEnd(const char *Start, const char *End) {
+  // Searching for both bytes at once is much faster than looking at every
+  // byte. A null byte is always found at End.
+  StringRef Rest(Start, End - Start + 1);
+  const char *P = Start + Rest.find_first_of(StringRef("\n\0", 2));
+  if (*P == '\n' && P != Start && P[-1] == '\r')
+    --P;
+  return P;
+}
+
 line_iterator::line_iterator(const MemoryBuffer &Buffer, bool SkipBlanks,
                              char CommentMarker)
     : Buffer(Buffer.getBufferSize() ? &Buffer : nullptr),
@@ -67,9 +79,7 @@ void line_iterator::advance() {
       if (isAtLineEnd(Pos) && !SkipBlanks)
         break;
       if (*Pos == CommentMarker)
-        do {
-          ++Pos;
-        } while (*Pos != '\0' && !isAtLineEnd(Pos));
+        Pos = findLineEnd(Pos + 1, Buffer->getBufferEnd());
       if (!skipIfAtLineEnd(Pos))
         break;
       ++LineNumber;
@@ -84,10 +94,5 @@ void line_iterator::advance() {
   }
 
   // Measure the line.
-  size_t Length = 0;
-  while (Pos[Length] != '\0' && !isAtLineEnd(&Pos[Length])) {
-    ++Length;
-  }
-
-  CurrentLine = StringRef(Pos, Length);
+  CurrentLine = StringRef(Pos, findLineEnd(Pos, Buffer->getBufferEnd()) - Pos);
 }
@@ -21,9 +21,12 @@
 #include "llvm/Support/Process.h"
 #include "llvm/Support/Program.h"
 #include "llvm/Support/SmallVectorMemoryBuffer.h"
+#include "llvm/Support/ThreadPool.h"
+#include <atomic>
 #include <cassert>
 #include <cerrno>
 #include <cstring>
+#include <future>
 #include <new>
 #include <sys/types.h>
 #include <system_error>
@@ -32,6 +35,9 @@
 #else
 #include <io.h>
 #endif
+#if defined(LLVM_ON_UNIX)
+#include <sys/mman.h>
+#endif
 using namespace llvm;
 
 //===----------------------------------------------------------------------===//
@@ -516,6 +522,102 @@ MemoryBuffer::getFileAsStream(const Twine &Filename) {
   return Ret;
 }
 
+namespace {
+/// Wraps a memory mapped buffer whose pages are being read in by a thread pool
+/// task.
+class PrefetchedMemoryBuffer : public MemoryBuffer {
+  std::unique_ptr<MemoryBuffer> Buffer;
+  std::atomic<bool> Cancelled{false};
+  std::shared_future<void> Done;
+
+  // Touch one byte of each page so that it is read in and mapped.
+  void populate() {
+    uint64_t PageSize = sys::fs::mapped_file_region::alignment();
+    const char *End = getBufferEnd();
+    for (const char *P = getBufferStart(); P < End;
+         P = reinterpret_cast<const char *>(
+             alignTo(reinterpret_cast<uintptr_t>(P) + 1, PageSize))) {
+      if (Cancelled.load(std::memory_order_relaxed))
+        return;
+      (void)*static_cast<const volatile char *>(P);
+    }
+  }
+
+public:
+  PrefetchedMemoryBuffer(std::unique_ptr<MemoryBuffer> Buffer, ThreadPool &Pool,
+                         bool RequiresNullTerminator)
+      : Buffer(std::move(Buffer)) {
+    init(this->Buffer->getBufferStart(), this->Buffer->getBufferEnd(),
+         RequiresNullTerminator);
+    Done = Pool.async([this] { populate(); });
+  }
+
+  ~PrefetchedMemoryBuffer() override {
+    // The task must not touch the mapping once it is gone.
+    Cancelled = true;
+    Done.wait();
+  }
+
+  StringRef getBufferIdentifier() const override {
+    return Buffer->getBufferIdentifier();
+  }
+
+  BufferKind getBufferKind() const override {
+    return Buffer->getBufferKind();
+  }
+};
+} // namespace
+
+/// Ask the OS to start reading in the pages of a memory mapped buffer.
+static void adviseWillNeed(const MemoryBuffer &Buffer) {
+#if defined(LLVM_ON_UNIX) && defined(MADV_WILLNEED)
+  uintptr_t Start = reinterpret_cast<uintptr_t>(Buffer.getBufferStart());
+  uintptr_t End = reinterpret_cast<uintptr_t>(Buffer.getBufferEnd());
+  uintptr_t MapStart =
+      alignDown(Start, sys::fs::mapped_file_region::alignment());
+  ::madvise(reinterpret_cast<void *>(MapStart), End - MapStart, MADV_WILLNEED);
+#endif
+}
+
+std::vector<Expected<std::unique_ptr<MemoryBuffer>>>
+MemoryBuffer::getFiles(ArrayRef<StringRef> Filenames, ThreadPool &Pool,
+                       bool RequiresNullTerminator, bool IsVolatile) {
+  std::vector<std::unique_ptr<MemoryBuffer>> Buffers(Filenames.size());
+  std::vector<std::error_code> Errors(Filenames.size());
+  std::vector<std::shared_future<void>> Opened;
+  Opened.reserve(Filenames.size());
+  for (size_t I = 0, E = Filenames.size(); I != E; ++I) {
+    Opened.push_back(Pool.async([&, I] {
+      ErrorOr<std::unique_ptr<MemoryBuffer>> BufOrErr =
+          getFile(Filenames[I], -1, RequiresNullTerminator, IsVolatile);
+      if (!BufOrErr) {
+        Errors[I] = BufOrErr.getError();
+        return;
+      }
+      Buffers[I] = std::move(*BufOrErr);
+      if (Buffers[I]->getBufferKind() == MemoryBuffer_MMap)
+        adviseWillNeed(*Buffers[I]);
+    }));
+  }
+  for (std::shared_future<void> &F : Opened)
+    F.wait();
+
+  // Files are populated in the order they were given, which is usually the
+  // order in which they will be read.
+  std::vector<Expected<std::unique_ptr<MemoryBuffer>>> Ret;
+  Ret.reserve(Filenames.size());
+  for (size_t I = 0, E = Filenames.size(); I != E; ++I) {
+    if (Errors[I])
+      Ret.push_back(errorCodeToError(Errors[I]));
+    else if (Buffers[I]->getBufferKind() == MemoryBuffer_MMap)
+      Ret.push_back(std::unique_ptr<MemoryBuffer>(new PrefetchedMemoryBuffer(
+          std::move(Buffers[I]), Pool, RequiresNullTerminator)));
+    else
+      Ret.push_back(std::move(Buffers[I]));
+  }
+  return Ret;
+}
+
 MemoryBufferRef MemoryBuffer::getMemBufferRef() const {
   StringRef Data = getBuffer();
   StringRef Identifier = getBufferIdentifier();
@@ -12,10 +12,13 @@
 #if LLVM_ENABLE_THREADS
 
 #include "llvm/Support/Threading.h"
+#include "llvm/Support/TimeProfiler.h"
 
+#include <algorithm>
 #include <atomic>
-#include <stack>
+#include <deque>
 #include <thread>
+#include <vector>
 
 namespace llvm {
 namespace parallel {
@@ -27,89 +30,189 @@ namespace {
 class Executor {
 public:
   virtual ~Executor() = default;
-  virtual void add(std::function<void()> func) = 0;
+  virtual void add(std::function<void()> func,
+                   const void *Group = nullptr) = 0;
+
+  /// Run one queued closure of \p Group on the calling thread, if there is
+  /// one. Returns false if there was nothing to run.
+  virtual bool runPendingTask(const void *Group) = 0;
 
   static Executor *getDefaultExecutor();
 };
 
-/// An implementation of an Executor that runs closures on a thread pool
-///   in filo order.
+/// An implementation of an Executor that runs closures on a thread pool with
+///   work stealing.
+///
+/// Each worker owns a deque of tasks. Tasks added by a worker go to the back
+/// of its own deque and are run in filo order, which keeps the working set of
+/// recursive algorithms such as parallel_sort small. An idle worker steals the
+/// oldest task from the front of another worker's deque. Tasks added from
+/// outside the pool are spread over the deques round-robin. Each deque has
+/// its own lock, so there is no single lock that all threads contend on.
 class ThreadPoolExecutor : public Executor {
 public:
   explicit ThreadPoolExecutor(unsigned ThreadCount = hardware_concurrency())
       : Done(ThreadCount) {
+    for (unsigned I = 0; I < ThreadCount; ++I)
+      Workers.push_back(std::make_unique<Worker>());
+
     // Spawn all but one of the threads in another thread as spawning threads
     // can take a while.
     std::thread([&, ThreadCount] {
-      for (size_t i = 1; i < ThreadCount; ++i) {
-        std::thread([=] { work(); }).detach();
+      for (unsigned I = 1; I < ThreadCount; ++I) {
+        std::thread([=] { work(I); }).detach();
       }
-      work();
+      work(0);
     }).detach();
   }
 
   ~ThreadPoolExecutor() override {
-    std::unique_lock<std::mutex> Lock(Mutex);
+    std::unique_lock<std::mutex> Lock(SleepMutex);
     Stop = true;
     Lock.unlock();
-    Cond.notify_all();
+    SleepCond.notify_all();
     // Wait for ~Latch.
   }
 
-  void add(std::function<void()> F) override {
-    std::unique_lock<std::mutex> Lock(Mutex);
-    WorkStack.push(F);
-    Lock.unlock();
-    Cond.notify_one();
+  void add(std::function<void()> F, const void *Group) override {
+    unsigned I = CurrentWorker >= 0 ? CurrentWorker
+                                    : NextWorker++ % Workers.size();
+    Worker &W = *Workers[I];
+    {
+      std::lock_guard<std::mutex> Lock(W.Mutex);
+      W.Tasks.push_back({Group, std::move(F)});
+    }
+    Pending.fetch_add(1);
+
+    // Only take the sleep lock if a worker may be waiting on it. Sleepers is
+    // incremented before a worker checks Pending, so either we see it here or
+    // the worker sees our task.
+    if (Sleepers.load() > 0) {
+      std::lock_guard<std::mutex> Lock(SleepMutex);
+      SleepCond.notify_one();
+    }
+  }
+
+  bool runPendingTask(const void *Group) override {
+    std::function<void()> Task;
+    unsigned Start = CurrentWorker >= 0 ? CurrentWorker
+                                        : NextWorker.load() % Workers.size();
+    if (!getTask(Start, Task, Group))
+      return false;
+    Task();
+    return true;
   }
 
 private:
-  void work() {
+  struct QueuedTask {
+    const void *Group;
+    std::function<void()> F;
+  };
+
+  struct Worker {
+    std::mutex Mutex;
+    std::deque<QueuedTask> Tasks;
+  };
+
+  // Takes a task from the back of Workers[Self], or steals one from the front
+  // of another worker's deque. If Group is non-null, only tasks of that group
+  // are taken.
+  bool getTask(unsigned Self, std::function<void()> &Task,
+               const void *Group = nullptr) {
+    if (Pending.load() == 0)
+      return false;
+    auto Matches = [&](const QueuedTask &T) {
+      return !Group || T.Group == Group;
+    };
+    for (size_t N = 0, E = Workers.size(); N != E; ++N) {
+      Worker &W = *Workers[(Self + N) % E];
+      std::lock_guard<std::mutex> Lock(W.Mutex);
+      if (N == 0) {
+        auto It = std::find_if(W.Tasks.rbegin(), W.Tasks.rend(), Matches);
+        if (It == W.Tasks.rend())
+          continue;
+        Task = std::move(It->F);
+        W.Tasks.erase(std::next(It).base());
+      } else {
+        auto It = std::find_if(W.Tasks.begin(), W.Tasks.end(), Matches);
+        if (It == W.Tasks.end())
+          continue;
+        Task = std::move(It->F);
+        W.Tasks.erase(It);
+      }
+      Pending.fetch_sub(1);
+      return true;
+    }
+    return false;
+  }
+
+  void work(unsigned Self) {
+    CurrentWorker = Self;
     while (true) {
-      std::unique_lock<std::mutex> Lock(Mutex);
-      Cond.wait(Lock, [&] { return Stop || !WorkStack.empty(); });
+      std::function<void()> Task;
+      if (getTask(Self, Task)) {
+        Task();
+        continue;
+      }
+
+      std::unique_lock<std::mutex> Lock(SleepMutex);
+      Sleepers.fetch_add(1);
+      SleepCond.wait(Lock, [&] { return Stop || Pending.load() > 0; });
+      Sleepers.fetch_sub(1);
       if (Stop)
         break;
-      auto Task = WorkStack.top();
-      WorkStack.pop();
-      Lock.unlock();
-      Task();
     }
     Done.dec();
   }
 
+  // The index of the worker running on this thread, or -1 for threads that
+  // are not part of the pool.
+  static LLVM_THREAD_LOCAL int CurrentWorker;
+
+  std::vector<std::unique_ptr<Worker>> Workers;
+  std::atomic<unsigned> NextWorker{0};
+  std::atomic<size_t> Pending{0};
+  std::atomic<unsigned> Sleepers{0};
   std::atomic<bool> Stop{false};
-  std::stack<std::function<void()>> WorkStack;
-  std::mutex Mutex;
-  std::condition_variable Cond;
+  std::mutex SleepMutex;
+  std::condition_variable SleepCond;
   parallel::detail::Latch Done;
 };
 
+LLVM_THREAD_LOCAL int ThreadPoolExecutor::CurrentWorker = -1;
+
 Executor *Executor::getDefaultExecutor() {
   static ThreadPoolExecutor exec;
   return &exec;
 }
 } // namespace
 
-static std::atomic<int> TaskGroupInstances;
-
-// Latch::sync() called by the dtor may cause one thread to block. If is a dead
-// lock if all threads in the default executor are blocked. To prevent the dead
-// lock, only allow the first TaskGroup to run tasks parallelly. In the scenario
-// of nested parallel_for_each(), only the outermost one runs parallelly.
-TaskGroup::TaskGroup() : Parallel(TaskGroupInstances++ == 0) {}
-TaskGroup::~TaskGroup() { --TaskGroupInstances; }
+TaskGroup::~TaskGroup() { sync(); }
 
 void TaskGroup::spawn(std::function<void()> F) {
-  if (Parallel) {
-    L.inc();
-    Executor::getDefaultExecutor()->add([&, F] {
-      F();
-      L.dec();
-    });
-  } else {
-    F();
-  }
+  L.inc();
+  Executor::getDefaultExecutor()->add(
+      [&, F] {
+        {
+          TimeTraceScope TimeScope("Parallel task", StringRef());
+          F();
+        }
+        L.dec();
+      },
+      this);
+}
+
+// Rather than blocking, help run this group's queued tasks until all of them
+// have finished. Every queued task of the group can thus be run by the thread
+// waiting for it, so TaskGroups can be nested without deadlock even when all
+// workers are busy. Tasks of other groups are never run here: they might take
+// a lock the caller holds, and running them would let the stack grow without
+// bound. The stack only grows as deep as the TaskGroups are nested.
+void TaskGroup::sync() const {
+  Executor *E = Executor::getDefaultExecutor();
+  while (!L.isZero())
+    if (!E->runPendingTask(this))
+      L.syncFor(std::chrono::milliseconds(1));
 }
 
 } // namespace detail
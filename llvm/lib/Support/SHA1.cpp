@@ -16,12 +16,23 @@
 
 #include "llvm/Support/SHA1.h"
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Endian.h"
 #include "llvm/Support/Host.h"
 using namespace llvm;
 
 #include <stdint.h>
 #include <string.h>
 
+// Use the SHA extensions of x86 processors when the host supports them. The
+// code is compiled for them regardless of the target flags and selected at
+// run time.
+#if (defined(__x86_64__) || defined(__i386__)) &&                             \
+    (defined(__clang__) || LLVM_GNUC_PREREQ(5, 0, 0))
+#define SHA1_X86_SHANI
+#include <immintrin.h>
+#endif
+
 #if defined(BYTE_ORDER) && defined(BIG_ENDIAN) && BYTE_ORDER == BIG_ENDIAN
 #define SHA_BIG_ENDIAN
 #endif
@@ -190,6 +201,119 @@ void SHA1::hashBlock() {
   InternalState.State[4] += E;
 }
 
+#ifdef SHA1_X86_SHANI
+static bool hasSHANI() {
+  static const bool Result = [] {
+    StringMap<bool> Features;
+    return sys::getHostCPUFeatures(Features) && Features.lookup("sha") &&
+           Features.lookup("sse4.1");
+  }();
+  return Result;
+}
+
+#define SHA1_TARGET __attribute__((target("sha,sse4.1")))
+
+// Four rounds with round function and constant F, using the message words
+// already added into E. E is then advanced to the next four words W.
+template <int F>
+SHA1_TARGET LLVM_ATTRIBUTE_ALWAYS_INLINE static void
+sha1Rounds4(__m128i &ABCD, __m128i &E, __m128i W) {
+  __m128i PrevABCD = ABCD;
+  ABCD = _mm_sha1rnds4_epu32(ABCD, E, F);
+  E = _mm_sha1nexte_epu32(PrevABCD, W);
+}
+
+// Compute the next four message words from the previous sixteen.
+SHA1_TARGET LLVM_ATTRIBUTE_ALWAYS_INLINE static __m128i
+sha1Schedule(__m128i W0, __m128i W1, __m128i W2, __m128i W3) {
+  return _mm_sha1msg2_epu32(_mm_xor_si128(_mm_sha1msg1_epu32(W0, W1), W2), W3);
+}
+
+SHA1_TARGET static void hashBlocksSHANI(uint32_t *State, const uint8_t *Data,
+                                        size_t NumBlocks) {
+  // Reverses the bytes of a 16-byte vector, which turns four big-endian
+  // message words into the lane order the SHA instructions expect.
+  const __m128i Mask =
+      _mm_set_epi64x(0x0001020304050607ULL, 0x08090a0b0c0d0e0fULL);
+  __m128i ABCD = _mm_shuffle_epi32(
+      _mm_loadu_si128(reinterpret_cast<const __m128i *>(State)), 0x1B);
+  __m128i E0 = _mm_set_epi32(State[4], 0, 0, 0);
+
+  for (; NumBlocks; --NumBlocks, Data += 64) {
+    const __m128i *Block = reinterpret_cast<const __m128i *>(Data);
+    __m128i SavedABCD = ABCD;
+    __m128i W0 = _mm_shuffle_epi8(_mm_loadu_si128(Block), Mask);
+    __m128i W1 = _mm_shuffle_epi8(_mm_loadu_si128(Block + 1), Mask);
+    __m128i W2 = _mm_shuffle_epi8(_mm_loadu_si128(Block + 2), Mask);
+    __m128i W3 = _mm_shuffle_epi8(_mm_loadu_si128(Block + 3), Mask);
+    __m128i E = _mm_add_epi32(E0, W0);
+
+    sha1Rounds4<0>(ABCD, E, W1);
+    sha1Rounds4<0>(ABCD, E, W2);
+    sha1Rounds4<0>(ABCD, E, W3);
+    W0 = sha1Schedule(W0, W1, W2, W3);
+    sha1Rounds4<0>(ABCD, E, W0);
+    W1 = sha1Schedule(W1, W2, W3, W0);
+    sha1Rounds4<0>(ABCD, E, W1);
+    W2 = sha1Schedule(W2, W3, W0, W1);
+    sha1Rounds4<1>(ABCD, E, W2);
+    W3 = sha1Schedule(W3, W0, W1, W2);
+    sha1Rounds4<1>(ABCD, E, W3);
+    W0 = sha1Schedule(W0, W1, W2, W3);
+    sha1Rounds4<1>(ABCD, E, W0);
+    W1 = sha1Schedule(W1, W2, W3, W0);
+    sha1Rounds4<1>(ABCD, E, W1);
+    W2 = sha1Schedule(W2, W3, W0, W1);
+    sha1Rounds4<1>(ABCD, E, W2);
+    W3 = sha1Schedule(W3, W0, W1, W2);
+    sha1Rounds4<2>(ABCD, E, W3);
+    W0 = sha1Schedule(W0, W1, W2, W3);
+    sha1Rounds4<2>(ABCD, E, W0);
+    W1 = sha1Schedule(W1, W2, W3, W0);
+    sha1Rounds4<2>(ABCD, E, W1);
+    W2 = sha1Schedule(W2, W3, W0, W1);
+    sha1Rounds4<2>(ABCD, E, W2);
+    W3 = sha1Schedule(W3, W0, W1, W2);
+    sha1Rounds4<2>(ABCD, E, W3);
+    W0 = sha1Schedule(W0, W1, W2, W3);
+    sha1Rounds4<3>(ABCD, E, W0);
+    W1 = sha1Schedule(W1, W2, W3, W0);
+    sha1Rounds4<3>(ABCD, E, W1);
+    W2 = sha1Schedule(W2, W3, W0, W1);
+    sha1Rounds4<3>(ABCD, E, W2);
+    W3 = sha1Schedule(W3, W0, W1, W2);
+    sha1Rounds4<3>(ABCD, E, W3);
+    // The last step rotates the saved E into place instead of message words.
+    sha1Rounds4<3>(ABCD, E, E0);
+
+    E0 = E;
+    ABCD = _mm_add_epi32(ABCD, SavedABCD);
+  }
+
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(State),
+                   _mm_shuffle_epi32(ABCD, 0x1B));
+  State[4] = _mm_extract_epi32(E0, 3);
+}
+
+#undef SHA1_TARGET
+#endif
+
+// Hash whole blocks directly from the input rather than copying them into the
+// buffer a byte at a time.
+void SHA1::hashBlocks(const uint8_t *Data, size_t NumBlocks) {
+#ifdef SHA1_X86_SHANI
+  if (hasSHANI()) {
+    hashBlocksSHANI(InternalState.State, Data, NumBlocks);
+    return;
+  }
+#endif
+  for (; NumBlocks; --NumBlocks, Data += BLOCK_LENGTH) {
+    for (int I = 0; I < BLOCK_LENGTH / 4; ++I)
+      InternalState.Buffer.L[I] = support::endian::read32be(Data + 4 * I);
+    hashBlock();
+  }
+}
+
 void SHA1::addUncounted(uint8_t Data) {
 #ifdef SHA_BIG_ENDIAN
   InternalState.Buffer.C[InternalState.BufferOffset] = Data;
@@ -210,8 +334,25 @@ void SHA1::writebyte(uint8_t Data) {
 }
 
 void SHA1::update(ArrayRef<uint8_t> Data) {
-  for (auto &C : Data)
-    writebyte(C);
+  InternalState.ByteCount += Data.size();
+
+  // Finish the current block.
+  if (InternalState.BufferOffset > 0) {
+    size_t Remainder = std::min<size_t>(
+        Data.size(), BLOCK_LENGTH - InternalState.BufferOffset);
+    for (uint8_t C : Data.take_front(Remainder))
+      addUncounted(C);
+    Data = Data.drop_front(Remainder);
+  }
+
+  // Process whole blocks in place, then buffer what is left.
+  size_t NumBlocks = Data.size() / BLOCK_LENGTH;
+  if (NumBlocks) {
+    hashBlocks(Data.data(), NumBlocks);
+    Data = Data.drop_front(NumBlocks * BLOCK_LENGTH);
+  }
+  for (uint8_t C : Data)
+    addUncounted(C);
 }
 
 void SHA1::pad() {
@@ -77,14 +77,11 @@ unsigned SourceMgr::SrcBuffer::getLineNumber(const char *Ptr) const {
   if (OffsetCache.isNull()) {
     Offsets = new std::vector<T>();
     OffsetCache = Offsets;
-    size_t Sz = Buffer->getBufferSize();
-    assert(Sz <= std::numeric_limits<T>::max());
     StringRef S = Buffer->getBuffer();
-    for (size_t N = 0; N < Sz; ++N) {
-      if (S[N] == '\n') {
-        Offsets->push_back(static_cast<T>(N));
-      }
-    }
+    assert(S.size() <= std::numeric_limits<T>::max());
+    for (size_t N = S.find('\n'); N != StringRef::npos;
+         N = S.find('\n', N + 1))
+      Offsets->push_back(static_cast<T>(N));
   } else {
     Offsets = OffsetCache.get<std::vector<T> *>();
   }
@@ -12,8 +12,15 @@
 #include "llvm/ADT/Hashing.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/edit_distance.h"
+#include "llvm/Support/MathExtras.h"
 #include <bitset>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
 using namespace llvm;
 
 // MSVC emits references to this into the translation units which reference it.
@@ -120,6 +127,91 @@ std::string StringRef::upper() const {
   return Result;
 }
 
+//===----------------------------------------------------------------------===//
+// Vectorized Searching
+//===----------------------------------------------------------------------===//
+
+// The searches below look at 16 bytes at a time, and turn a byte-wise
+// comparison into a bit mask with one bit set for each matching byte, at a
+// stride of MaskBitsPerByte bits.
+#if defined(__SSE2__)
+#define STRINGREF_HAS_SIMD 1
+namespace {
+using Bytes16 = __m128i;
+const unsigned MaskBitsPerByte = 1;
+
+inline Bytes16 load16(const char *P) {
+  return _mm_loadu_si128(reinterpret_cast<const __m128i *>(P));
+}
+inline Bytes16 splat16(char C) { return _mm_set1_epi8(C); }
+inline Bytes16 cmpeq16(Bytes16 A, Bytes16 B) { return _mm_cmpeq_epi8(A, B); }
+inline Bytes16 or16(Bytes16 A, Bytes16 B) { return _mm_or_si128(A, B); }
+inline Bytes16 and16(Bytes16 A, Bytes16 B) { return _mm_and_si128(A, B); }
+inline Bytes16 sub16(Bytes16 A, Bytes16 B) { return _mm_sub_epi8(A, B); }
+inline Bytes16 zero16() { return _mm_setzero_si128(); }
+inline uint64_t toMask(Bytes16 V) { return _mm_movemask_epi8(V); }
+// Sum the bytes of V.
+inline uint64_t sumBytes(Bytes16 V) {
+  __m128i Sums = _mm_sad_epu8(V, _mm_setzero_si128());
+  return _mm_cvtsi128_si32(Sums) + _mm_extract_epi16(Sums, 4);
+}
+} // namespace
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#define STRINGREF_HAS_SIMD 1
+namespace {
+using Bytes16 = uint8x16_t;
+const unsigned MaskBitsPerByte = 4;
+
+inline Bytes16 load16(const char *P) {
+  return vld1q_u8(reinterpret_cast<const uint8_t *>(P));
+}
+inline Bytes16 splat16(char C) { return vdupq_n_u8(C); }
+inline Bytes16 cmpeq16(Bytes16 A, Bytes16 B) { return vceqq_u8(A, B); }
+inline Bytes16 or16(Bytes16 A, Bytes16 B) { return vorrq_u8(A, B); }
+inline Bytes16 and16(Bytes16 A, Bytes16 B) { return vandq_u8(A, B); }
+inline Bytes16 sub16(Bytes16 A, Bytes16 B) { return vsubq_u8(A, B); }
+inline Bytes16 zero16() { return vdupq_n_u8(0); }
+// NEON has no movemask; narrowing each byte to a nibble is the cheapest way
+// to get a scalar mask. Keep one bit per nibble so that masks can be counted
+// and iterated like SSE2 ones.
+inline uint64_t toMask(Bytes16 V) {
+  return vget_lane_u64(
+             vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(V), 4)), 0) &
+         0x8888888888888888ULL;
+}
+// Sum the bytes of V.
+inline uint64_t sumBytes(Bytes16 V) { return vaddlvq_u8(V); }
+} // namespace
+#endif
+
+/// Return the offset of the first candidate in a mask from toMask().
+#ifdef STRINGREF_HAS_SIMD
+static inline size_t firstInMask(uint64_t Mask) {
+  return countTrailingZeros(Mask) / MaskBitsPerByte;
+}
+#endif
+
+size_t StringRef::count(char C) const {
+  size_t Count = 0;
+  size_t I = 0;
+#ifdef STRINGREF_HAS_SIMD
+  // A matching byte compares as 0xff, so subtracting the comparison counts
+  // matches in each byte lane. Sum the lanes before they can overflow.
+  Bytes16 Needle = splat16(C);
+  while (I + 16 <= Length) {
+    Bytes16 Counts = zero16();
+    for (size_t Blocks = 0; Blocks != 255 && I + 16 <= Length;
+         ++Blocks, I += 16)
+      Counts = sub16(Counts, cmpeq16(load16(Data + I), Needle));
+    Count += sumBytes(Counts);
+  }
+#endif
+  for (; I != Length; ++I)
+    if (Data[I] == C)
+      ++Count;
+  return Count;
+}
+
 //===----------------------------------------------------------------------===//
 // String Searching
 //===----------------------------------------------------------------------===//
@@ -149,6 +241,29 @@ size_t StringRef::find(StringRef Str, size_t From) const {
 
   const char *Stop = Start + (Size - N + 1);
 
+#ifdef STRINGREF_HAS_SIMD
+  // Check 16 positions at a time for the first and the last byte of the
+  // needle, and only compare the rest at positions where both match. Longer
+  // needles skip more bytes at a time with the bad char heuristic below.
+  if (N < 32) {
+    Bytes16 First = splat16(Needle[0]);
+    Bytes16 Last = splat16(Needle[N - 1]);
+    for (; Stop - Start >= 16; Start += 16) {
+      uint64_t Mask = toMask(and16(cmpeq16(load16(Start), First),
+                                   cmpeq16(load16(Start + N - 1), Last)));
+      for (; Mask; Mask &= Mask - 1) {
+        const char *P = Start + firstInMask(Mask);
+        if (std::memcmp(P + 1, Needle + 1, N - 2) == 0)
+          return P - Data;
+      }
+    }
+    for (; Start < Stop; ++Start)
+      if (std::memcmp(Start, Needle, N) == 0)
+        return Start - Data;
+    return npos;
+  }
+#endif
+
   // For short haystacks or unsupported needles fall back to the naive algorithm
   if (Size < 16 || N > 255) {
     do {
@@ -234,11 +349,32 @@ size_t StringRef::rfind_lower(StringRef Str) const {
 /// Note: O(size() + Chars.size())
 StringRef::size_type StringRef::find_first_of(StringRef Chars,
                                               size_t From) const {
+  size_type i = std::min(From, Length);
+
+#ifdef STRINGREF_HAS_SIMD
+  // Compare against each character in turn while that is cheaper than
+  // testing each byte against the bitset.
+  const size_t MaxSIMDChars = 16;
+  if (!Chars.empty() && Chars.size() <= MaxSIMDChars) {
+    Bytes16 Splats[MaxSIMDChars];
+    for (size_t j = 0; j != Chars.size(); ++j)
+      Splats[j] = splat16(Chars[j]);
+    for (; i + 16 <= Length; i += 16) {
+      Bytes16 Bytes = load16(Data + i);
+      Bytes16 Matches = cmpeq16(Bytes, Splats[0]);
+      for (size_t j = 1; j != Chars.size(); ++j)
+        Matches = or16(Matches, cmpeq16(Bytes, Splats[j]));
+      if (uint64_t Mask = toMask(Matches))
+        return i + firstInMask(Mask);
+    }
+  }
+#endif
+
   std::bitset<1 << CHAR_BIT> CharBits;
-  for (size_type i = 0; i != Chars.size(); ++i)
-    CharBits.set((unsigned char)Chars[i]);
+  for (size_type j = 0; j != Chars.size(); ++j)
+    CharBits.set((unsigned char)Chars[j]);
 
-  for (size_type i = std::min(From, Length), e = Length; i != e; ++i)
+  for (size_type e = Length; i != e; ++i)
     if (CharBits.test((unsigned char)Data[i]))
       return i;
   return npos;
@@ -371,12 +507,8 @@ void StringRef::split(SmallVectorImpl<StringRef> &A, char Separator,
 /// the string.
 size_t StringRef::count(StringRef Str) const {
   size_t Count = 0;
-  size_t N = Str.size();
-  if (N > Length)
-    return 0;
-  for (size_t i = 0, e = Length - N + 1; i != e; ++i)
-    if (substr(i, N).equals(Str))
-      ++Count;
+  for (size_t i = find(Str); i != npos; i = find(Str, i + 1))
+    ++Count;
   return Count;
 }
 
@@ -14,6 +14,7 @@
 
 #include "llvm/Config/llvm-config.h"
 #include "llvm/Support/Threading.h"
+#include "llvm/Support/TimeProfiler.h"
 #include "llvm/Support/raw_ostream.h"
 
 using namespace llvm;
@@ -53,7 +54,10 @@ ThreadPool::ThreadPool(unsigned ThreadCount)
           Tasks.pop();
         }
         // Run the task we just grabbed
-        Task();
+        {
+          TimeTraceScope TimeScope("ThreadPool task", StringRef());
+          Task();
+        }
 
         {
           // Adjust `ActiveThreads`, in case someone waits on ThreadPool::wait()
@@ -13,10 +13,13 @@
 #include "llvm/Support/TimeProfiler.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Compiler.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/JSON.h"
 #include <cassert>
 #include <chrono>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -58,17 +61,23 @@ struct Entry {
   }
 };
 
-struct TimeTraceProfiler {
-  TimeTraceProfiler() {
-    StartTime = steady_clock::now();
-  }
+struct CounterEntry {
+  TimePointType Time;
+  std::string Name;
+  std::vector<std::pair<std::string, int64_t>> Values;
+};
+
+// Events recorded by a single thread. Only the owning thread appends to a
+// buffer, so recording needs no locking; buffers are merged when writing.
+struct TimeTraceThreadBuffer {
+  TimeTraceThreadBuffer(int Tid) : Tid(Tid) {}
 
   void begin(std::string Name, llvm::function_ref<std::string()> Detail) {
     Stack.emplace_back(steady_clock::now(), TimePointType(), std::move(Name),
                        Detail());
   }
 
-  void end() {
+  void end(TimePointType StartTime, unsigned TimeTraceGranularity) {
     assert(!Stack.empty() && "Must call begin() first");
     auto &E = Stack.back();
     E.End = steady_clock::now();
@@ -103,36 +112,121 @@ struct TimeTraceProfiler {
     Stack.pop_back();
   }
 
+  void counter(StringRef Name,
+               ArrayRef<std::pair<StringRef, int64_t>> Values) {
+    Counters.push_back({steady_clock::now(), Name, {}});
+    for (const auto &V : Values)
+      Counters.back().Values.emplace_back(V.first, V.second);
+  }
+
+  SmallVector<Entry, 16> Stack;
+  SmallVector<Entry, 128> Entries;
+  std::vector<CounterEntry> Counters;
+  StringMap<CountAndDurationType> CountAndTotalPerName;
+
+  // Thread ID used in the trace output. The thread that initialized the
+  // profiler is 0, other threads are numbered in the order they first record
+  // an event.
+  int Tid;
+};
+
+// The generation of the current profiler. Thread-local buffer pointers from an
+// earlier generation refer to a profiler that has since been destroyed.
+static unsigned ProfilerGeneration = 0;
+static LLVM_THREAD_LOCAL TimeTraceThreadBuffer *ThreadBuffer = nullptr;
+static LLVM_THREAD_LOCAL unsigned ThreadBufferGeneration = 0;
+
+struct TimeTraceProfiler {
+  TimeTraceProfiler(unsigned TimeTraceGranularity)
+      : StartTime(steady_clock::now()),
+        TimeTraceGranularity(TimeTraceGranularity) {}
+
+  // Returns the calling thread's buffer, creating it on the thread's first
+  // event. Only creation takes the lock.
+  TimeTraceThreadBuffer &getThreadBuffer() {
+    if (ThreadBuffer && ThreadBufferGeneration == ProfilerGeneration)
+      return *ThreadBuffer;
+    std::lock_guard<std::mutex> Lock(BuffersMutex);
+    Buffers.push_back(std::make_unique<TimeTraceThreadBuffer>(Buffers.size()));
+    ThreadBuffer = Buffers.back().get();
+    ThreadBufferGeneration = ProfilerGeneration;
+    return *ThreadBuffer;
+  }
+
+  void begin(std::string Name, llvm::function_ref<std::string()> Detail) {
+    getThreadBuffer().begin(std::move(Name), Detail);
+  }
+
+  void end() { getThreadBuffer().end(StartTime, TimeTraceGranularity); }
+
+  void counter(StringRef Name,
+               ArrayRef<std::pair<StringRef, int64_t>> Values) {
+    getThreadBuffer().counter(Name, Values);
+  }
+
   void Write(raw_pwrite_stream &OS) {
-    assert(Stack.empty() &&
-           "All profiler sections should be ended when calling Write");
+    std::lock_guard<std::mutex> Lock(BuffersMutex);
     json::OStream J(OS);
     J.objectBegin();
     J.attributeBegin("traceEvents");
     J.arrayBegin();
 
-    // Emit all events for the main flame graph.
-    for (const auto &E : Entries) {
-      auto StartUs = E.getFlameGraphStartUs(StartTime);
-      auto DurUs = E.getFlameGraphDurUs();
+    // Emit all events for the main flame graph, one track per thread.
+    for (const auto &B : Buffers) {
+      assert(B->Stack.empty() &&
+             "All profiler sections should be ended when calling Write");
+      for (const auto &E : B->Entries) {
+        auto StartUs = E.getFlameGraphStartUs(StartTime);
+        auto DurUs = E.getFlameGraphDurUs();
+
+        J.object([&]{
+          J.attribute("pid", 1);
+          J.attribute("tid", B->Tid);
+          J.attribute("ph", "X");
+          J.attribute("ts", StartUs);
+          J.attribute("dur", DurUs);
+          J.attribute("name", E.Name);
+          J.attributeObject("args", [&] { J.attribute("detail", E.Detail); });
+        });
+      }
+    }
 
-      J.object([&]{
-        J.attribute("pid", 1);
-        J.attribute("tid", 0);
-        J.attribute("ph", "X");
-        J.attribute("ts", StartUs);
-        J.attribute("dur", DurUs);
-        J.attribute("name", E.Name);
-        J.attributeObject("args", [&] { J.attribute("detail", E.Detail); });
-      });
+    // Emit counter samples. Trace viewers draw each name as a separate track.
+    for (const auto &B : Buffers) {
+      for (const auto &C : B->Counters) {
+        auto TimeUs = (time_point_cast<microseconds>(C.Time) -
+                       time_point_cast<microseconds>(StartTime))
+                          .count();
+        J.object([&] {
+          J.attribute("pid", 1);
+          J.attribute("tid", B->Tid);
+          J.attribute("ph", "C");
+          J.attribute("ts", TimeUs);
+          J.attribute("name", C.Name);
+          J.attributeObject("args", [&] {
+            for (const auto &V : C.Values)
+              J.attribute(V.first, V.second);
+          });
+        });
+      }
     }
 
     // Emit totals by section name as additional "thread" events, sorted from
-    // longest one.
-    int Tid = 1;
+    // longest one. Totals are summed over all threads, and are numbered after
+    // the real threads.
+    StringMap<CountAndDurationType> AllCountAndTotalPerName;
+    for (const auto &B : Buffers) {
+      for (const auto &E : B->CountAndTotalPerName) {
+        auto &CountAndTotal = AllCountAndTotalPerName[E.getKey()];
+        CountAndTotal.first += E.getValue().first;
+        CountAndTotal.second += E.getValue().second;
+      }
+    }
+
+    int Tid = Buffers.size();
     std::vector<NameAndCountAndDurationType> SortedTotals;
-    SortedTotals.reserve(CountAndTotalPerName.size());
-    for (const auto &E : CountAndTotalPerName)
+    SortedTotals.reserve(AllCountAndTotalPerName.size());
+    for (const auto &E : AllCountAndTotalPerName)
       SortedTotals.emplace_back(E.getKey(), E.getValue());
 
     llvm::sort(SortedTotals.begin(), SortedTotals.end(),
@@ -142,7 +236,7 @@ struct TimeTraceProfiler {
                });
     for (const auto &E : SortedTotals) {
       auto DurUs = duration_cast<microseconds>(E.second.second).count();
-      auto Count = CountAndTotalPerName[E.first].first;
+      auto Count = E.second.first;
 
       J.object([&]{
         J.attribute("pid", 1);
@@ -171,14 +265,31 @@ struct TimeTraceProfiler {
       J.attributeObject("args", [&] { J.attribute("name", "clang"); });
     });
 
+    // Name the thread tracks so worker threads can be told apart from the
+    // totals.
+    for (const auto &B : Buffers) {
+      J.object([&] {
+        J.attribute("cat", "");
+        J.attribute("pid", 1);
+        J.attribute("tid", B->Tid);
+        J.attribute("ts", 0);
+        J.attribute("ph", "M");
+        J.attribute("name", "thread_name");
+        J.attributeObject("args", [&] {
+          J.attribute("name", B->Tid == 0
+                                  ? std::string("main")
+                                  : "thread " + std::to_string(B->Tid));
+        });
+      });
+    }
+
     J.arrayEnd();
     J.attributeEnd();
     J.objectEnd();
   }
 
-  SmallVector<Entry, 16> Stack;
-  SmallVector<Entry, 128> Entries;
-  StringMap<CountAndDurationType> CountAndTotalPerName;
+  std::mutex BuffersMutex;
+  std::vector<std::unique_ptr<TimeTraceThreadBuffer>> Buffers;
   TimePointType StartTime;
 
   // Minimum time granularity (in microseconds)
@@ -188,8 +299,10 @@ struct TimeTraceProfiler {
 void timeTraceProfilerInitialize(unsigned TimeTraceGranularity) {
   assert(TimeTraceProfilerInstance == nullptr &&
          "Profiler should not be initialized");
-  TimeTraceProfilerInstance = new TimeTraceProfiler();
-  TimeTraceProfilerInstance->TimeTraceGranularity = TimeTraceGranularity;
+  ++ProfilerGeneration;
+  TimeTraceProfilerInstance = new TimeTraceProfiler(TimeTraceGranularity);
+  // Register the initializing thread first so that it gets thread ID 0.
+  TimeTraceProfilerInstance->getThreadBuffer();
 }
 
 void timeTraceProfilerCleanup() {
@@ -219,4 +332,10 @@ void timeTraceProfilerEnd() {
     TimeTraceProfilerInstance->end();
 }
 
+void timeTraceProfilerCounter(
+    StringRef Name, ArrayRef<std::pair<StringRef, int64_t>> Values) {
+  if (TimeTraceProfilerInstance != nullptr)
+    TimeTraceProfilerInstance->counter(Name, Values);
+}
+
 } // namespace llvm
@@ -31,6 +31,17 @@
 #include <iterator>
 #include <sys/stat.h>
 #include <system_error>
+#include <vector>
+
+#if LLVM_ENABLE_THREADS
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
+
+#if defined(LLVM_ON_UNIX)
+#include <sys/uio.h>
+#endif
 
 // <fcntl.h> may provide O_BINARY.
 #if defined(HAVE_FCNTL_H)
@@ -611,6 +622,7 @@ raw_fd_ostream::raw_fd_ostream(int fd, bool shouldClose, bool unbuffered)
 raw_fd_ostream::~raw_fd_ostream() {
   if (FD >= 0) {
     flush();
+    waitForBackgroundWrites();
     if (ShouldClose) {
       if (auto EC = sys::Process::SafelyCloseFileDescriptor(FD))
         error_detected(EC);
@@ -684,18 +696,8 @@ static bool write_console_impl(int FD, StringRef Data) {
 }
 #endif
 
-void raw_fd_ostream::write_impl(const char *Ptr, size_t Size) {
-  assert(FD >= 0 && "File already closed.");
-  pos += Size;
-
-#if defined(_WIN32)
-  // If this is a Windows console device, try re-encoding from UTF-8 to UTF-16
-  // and using WriteConsoleW. If that fails, fall back to plain write().
-  if (IsWindowsConsole)
-    if (write_console_impl(FD, StringRef(Ptr, Size)))
-      return;
-#endif
-
+/// Write all of \p Size bytes at \p Ptr to \p FD.
+static std::error_code write_fd(int FD, const char *Ptr, size_t Size) {
   // The maximum write size is limited to INT32_MAX. A write
   // greater than SSIZE_MAX is implementation-defined in POSIX,
   // and Windows _write requires 32 bit input.
@@ -727,9 +729,8 @@ void raw_fd_ostream::write_impl(const char *Ptr, size_t Size) {
           )
         continue;
 
-      // Otherwise it's a non-recoverable error. Note it and quit.
-      error_detected(std::error_code(errno, std::generic_category()));
-      break;
+      // Otherwise it's a non-recoverable error.
+      return std::error_code(errno, std::generic_category());
     }
 
     // The write may have written some or all of the data. Update the
@@ -738,12 +739,228 @@ void raw_fd_ostream::write_impl(const char *Ptr, size_t Size) {
     Ptr += ret;
     Size -= ret;
   } while (Size > 0);
+  return std::error_code();
+}
+
+/// Write the buffers in \p Bufs to \p FD, in order.
+static std::error_code
+write_fd_vectored(int FD, ArrayRef<std::pair<char *, size_t>> Bufs) {
+#if defined(LLVM_ON_UNIX)
+  SmallVector<struct iovec, 4> IOV;
+  for (const std::pair<char *, size_t> &Buf : Bufs)
+    IOV.push_back({Buf.first, Buf.second});
+
+  size_t I = 0;
+  while (I != IOV.size()) {
+    ssize_t ret = ::writev(FD, &IOV[I], IOV.size() - I);
+    if (ret < 0) {
+      // Retry the same errors as write_fd.
+      if (errno == EINTR || errno == EAGAIN
+#ifdef EWOULDBLOCK
+          || errno == EWOULDBLOCK
+#endif
+          )
+        continue;
+      return std::error_code(errno, std::generic_category());
+    }
+
+    // Skip the buffers that were written, and the written part of the next.
+    size_t Written = ret;
+    while (I != IOV.size() && Written >= IOV[I].iov_len)
+      Written -= IOV[I++].iov_len;
+    if (Written) {
+      IOV[I].iov_base = static_cast<char *>(IOV[I].iov_base) + Written;
+      IOV[I].iov_len -= Written;
+    }
+  }
+  return std::error_code();
+#else
+  for (const std::pair<char *, size_t> &Buf : Bufs)
+    if (std::error_code EC = write_fd(FD, Buf.first, Buf.second))
+      return EC;
+  return std::error_code();
+#endif
+}
+
+/// Owns a few large buffers that a raw_fd_ostream fills while a thread writes
+/// out the full ones. Without threads, buffers are written out as soon as they
+/// are queued.
+class raw_fd_ostream::BackgroundWriter {
+  // One buffer is being filled by the stream while the others are queued or
+  // being written, which also bounds the number of buffers in a writev call.
+  static constexpr size_t NumBuffers = 4;
+
+  const int FD;
+  const size_t BufferSize;
+  std::unique_ptr<char[]> Storage;
+  std::vector<char *> Free;
+  std::vector<std::pair<char *, size_t>> Queue;
+  std::error_code EC;
+
+#if LLVM_ENABLE_THREADS
+  bool Busy = false;
+  bool Stop = false;
+  std::mutex Mutex;
+  std::condition_variable Cond;
+  std::thread Thread;
+
+  void run() {
+    std::unique_lock<std::mutex> Lock(Mutex);
+    while (true) {
+      Cond.wait(Lock, [&] { return Stop || !Queue.empty(); });
+      if (Queue.empty())
+        return;
+
+      std::vector<std::pair<char *, size_t>> Bufs;
+      Bufs.swap(Queue);
+      Busy = true;
+      Lock.unlock();
+      std::error_code WriteEC = write_fd_vectored(FD, Bufs);
+      Lock.lock();
+
+      if (WriteEC && !EC)
+        EC = WriteEC;
+      for (std::pair<char *, size_t> &Buf : Bufs)
+        Free.push_back(Buf.first);
+      Busy = false;
+      Cond.notify_all();
+    }
+  }
+#endif
+
+public:
+  BackgroundWriter(int FD, size_t BufferSize)
+      : FD(FD), BufferSize(BufferSize),
+        Storage(new char[NumBuffers * BufferSize]) {
+    for (size_t I = 0; I != NumBuffers; ++I)
+      Free.push_back(Storage.get() + I * BufferSize);
+#if LLVM_ENABLE_THREADS
+    Thread = std::thread([this] { run(); });
+#endif
+  }
+
+  ~BackgroundWriter() {
+#if LLVM_ENABLE_THREADS
+    {
+      std::lock_guard<std::mutex> Lock(Mutex);
+      Stop = true;
+    }
+    Cond.notify_all();
+    Thread.join();
+#endif
+  }
+
+  size_t getBufferSize() const { return BufferSize; }
+
+  bool ownsBuffer(const char *Ptr) const {
+    return Ptr >= Storage.get() &&
+           Ptr < Storage.get() + NumBuffers * BufferSize;
+  }
+
+  /// Return an empty buffer, waiting for one to be written if necessary.
+  char *getFreeBuffer() {
+#if LLVM_ENABLE_THREADS
+    std::unique_lock<std::mutex> Lock(Mutex);
+    Cond.wait(Lock, [&] { return !Free.empty(); });
+#endif
+    char *Buf = Free.back();
+    Free.pop_back();
+    return Buf;
+  }
+
+  /// Write the first \p Size bytes of \p Buf, which came from getFreeBuffer().
+  void queue(char *Buf, size_t Size) {
+#if LLVM_ENABLE_THREADS
+    {
+      std::lock_guard<std::mutex> Lock(Mutex);
+      Queue.emplace_back(Buf, Size);
+    }
+    Cond.notify_all();
+#else
+    std::error_code WriteEC = write_fd(FD, Buf, Size);
+    if (WriteEC && !EC)
+      EC = WriteEC;
+    Free.push_back(Buf);
+#endif
+  }
+
+  /// Wait until all queued buffers are written, and return and clear the
+  /// first error seen since the last call.
+  std::error_code wait() {
+#if LLVM_ENABLE_THREADS
+    std::unique_lock<std::mutex> Lock(Mutex);
+    Cond.wait(Lock, [&] { return !Busy && Queue.empty(); });
+#endif
+    std::error_code Ret = EC;
+    EC = std::error_code();
+    return Ret;
+  }
+};
+
+void raw_fd_ostream::write_impl(const char *Ptr, size_t Size) {
+  assert(FD >= 0 && "File already closed.");
+  pos += Size;
+
+  if (Writer) {
+    queueBackgroundWrite(Ptr, Size);
+    return;
+  }
+
+#if defined(_WIN32)
+  // If this is a Windows console device, try re-encoding from UTF-8 to UTF-16
+  // and using WriteConsoleW. If that fails, fall back to plain write().
+  if (IsWindowsConsole)
+    if (write_console_impl(FD, StringRef(Ptr, Size)))
+      return;
+#endif
+
+  if (std::error_code EC = write_fd(FD, Ptr, Size))
+    error_detected(EC);
+}
+
+void raw_fd_ostream::enableBackgroundWrites(size_t BufferSize) {
+  assert(BufferSize > 0 && "BufferSize must not be zero");
+  if (FD < 0 || Writer)
+    return;
+#if defined(_WIN32)
+  if (IsWindowsConsole)
+    return;
+#endif
+  flush();
+  Writer = std::make_unique<BackgroundWriter>(FD, BufferSize);
+  SetBuffer(Writer->getFreeBuffer(), BufferSize);
+}
+
+void raw_fd_ostream::queueBackgroundWrite(const char *Ptr, size_t Size) {
+  // A full stream buffer is handed over as is and replaced by an empty one.
+  if (Writer->ownsBuffer(Ptr)) {
+    Writer->queue(const_cast<char *>(Ptr), Size);
+    SetBuffer(Writer->getFreeBuffer(), Writer->getBufferSize());
+    return;
+  }
+
+  // Large writes bypass the stream buffer, so copy them.
+  while (Size > 0) {
+    size_t ChunkSize = std::min(Size, Writer->getBufferSize());
+    char *Buf = Writer->getFreeBuffer();
+    memcpy(Buf, Ptr, ChunkSize);
+    Writer->queue(Buf, ChunkSize);
+    Ptr += ChunkSize;
+    Size -= ChunkSize;
+  }
+}
+
+void raw_fd_ostream::waitForBackgroundWrites() {
+  if (Writer)
+    if (std::error_code EC = Writer->wait())
+      error_detected(EC);
 }
 
 void raw_fd_ostream::close() {
   assert(ShouldClose);
   ShouldClose = false;
   flush();
+  waitForBackgroundWrites();
   if (auto EC = sys::Process::SafelyCloseFileDescriptor(FD))
     error_detected(EC);
   FD = -1;
@@ -752,6 +969,7 @@ void raw_fd_ostream::close() {
 uint64_t raw_fd_ostream::seek(uint64_t off) {
   assert(SupportsSeeking && "Stream does not support seeking!");
   flush();
+  waitForBackgroundWrites();
 #ifdef _WIN32
   pos = ::_lseeki64(FD, off, SEEK_SET);
 #elif defined(HAVE_LSEEK64)
@@ -766,10 +984,39 @@ uint64_t raw_fd_ostream::seek(uint64_t off) {
 
 void raw_fd_ostream::pwrite_impl(const char *Ptr, size_t Size,
                                  uint64_t Offset) {
+  assert(SupportsSeeking && "Stream does not support seeking!");
+
+  // If the range has not been written out yet, patch the buffer.
+  if (Offset >= pos && GetNumBytesInBuffer() > 0) {
+    memcpy(const_cast<char *>(getBufferStart()) + (Offset - pos), Ptr, Size);
+    return;
+  }
+
+  flush();
+  waitForBackgroundWrites();
+#if defined(LLVM_ON_UNIX)
+  while (Size > 0) {
+    ssize_t ret = ::pwrite(FD, Ptr, Size, Offset);
+    if (ret < 0) {
+      if (errno == EINTR || errno == EAGAIN
+#ifdef EWOULDBLOCK
+          || errno == EWOULDBLOCK
+#endif
+          )
+        continue;
+      error_detected(std::error_code(errno, std::generic_category()));
+      return;
+    }
+    Ptr += ret;
+    Size -= ret;
+    Offset += ret;
+  }
+#else
   uint64_t Pos = tell();
   seek(Offset);
   write(Ptr, Size);
   seek(Pos);
+#endif
 }
 
 size_t raw_fd_ostream::preferred_buffer_size() const {
@@ -794,8 +1041,10 @@ size_t raw_fd_ostream::preferred_buffer_size() const {
   // the complexity.
   if (S_ISCHR(statbuf.st_mode) && isatty(FD))
     return 0;
-  // Return the preferred block size.
-  return statbuf.st_blksize;
+  // Return the preferred block size, but no less than 64 KiB. st_blksize is
+  // usually a single page, which makes large outputs cost a system call per
+  // page.
+  return std::max<size_t>(statbuf.st_blksize, 64 * 1024);
 #else
   return raw_ostream::preferred_buffer_size();
 #endif
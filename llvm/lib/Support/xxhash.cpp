@@ -33,14 +33,24 @@
 */
 
 /* based on revision d2df04efcbef7d7f6886d345861e5dfda4edacc1 Removed
- * everything but a simple interface for computing XXh64. */
+ * everything but a simple interface for computing XXh64. The XXH3 code is
+ * based on release 0.8.2, reduced to the seedless 64-bit variant. */
 
 #include "llvm/Support/xxhash.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Compiler.h"
 #include "llvm/Support/Endian.h"
+#include "llvm/Support/Host.h"
 
 #include <stdlib.h>
 #include <string.h>
 
+#if (defined(__x86_64__) || defined(__i386__)) &&                             \
+    (defined(__clang__) || LLVM_GNUC_PREREQ(5, 0, 0))
+#define XXH3_X86_AVX2
+#include <immintrin.h>
+#endif
+
 using namespace llvm;
 using namespace support;
 
@@ -136,3 +146,306 @@ uint64_t llvm::xxHash64(StringRef Data) {
 uint64_t llvm::xxHash64(ArrayRef<uint8_t> Data) {
   return xxHash64({(const char *)Data.data(), Data.size()});
 }
+
+static const uint32_t PRIME32_1 = 0x9E3779B1U;
+static const uint32_t PRIME32_2 = 0x85EBCA77U;
+static const uint32_t PRIME32_3 = 0xC2B2AE3DU;
+
+static const uint64_t PRIME_MX1 = 0x165667919E3779F9ULL;
+static const uint64_t PRIME_MX2 = 0x9FB21C651E98DF25ULL;
+
+// The default secret of XXH3.
+constexpr size_t XXH3_SECRET_SIZE = 192;
+constexpr size_t XXH3_SECRET_SIZE_MIN = 136;
+static const uint8_t kSecret[XXH3_SECRET_SIZE] = {
+    0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c,
+    0xf7, 0x21, 0xad, 0x1c, 0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb,
+    0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f, 0xcb, 0x79, 0xe6, 0x4e,
+    0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+    0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6,
+    0x81, 0x3a, 0x26, 0x4c, 0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb,
+    0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3, 0x71, 0x64, 0x48, 0x97,
+    0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+    0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7,
+    0xc7, 0x0b, 0x4f, 0x1d, 0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31,
+    0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64, 0xea, 0xc5, 0xac, 0x83,
+    0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+    0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26,
+    0x29, 0xd4, 0x68, 0x9e, 0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc,
+    0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce, 0x45, 0xcb, 0x3a, 0x8f,
+    0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e,
+};
+
+// Multiply two 64-bit values to 128 bits and fold the halves with XOR.
+static uint64_t mul128Fold64(uint64_t Lhs, uint64_t Rhs) {
+#if defined(__SIZEOF_INT128__)
+  __uint128_t Product = (__uint128_t)Lhs * Rhs;
+  return uint64_t(Product) ^ uint64_t(Product >> 64);
+#else
+  uint64_t LoLo = (Lhs & 0xffffffff) * (Rhs & 0xffffffff);
+  uint64_t HiLo = (Lhs >> 32) * (Rhs & 0xffffffff);
+  uint64_t LoHi = (Lhs & 0xffffffff) * (Rhs >> 32);
+  uint64_t HiHi = (Lhs >> 32) * (Rhs >> 32);
+  uint64_t Cross = (LoLo >> 32) + (HiLo & 0xffffffff) + LoHi;
+  uint64_t Upper = (HiLo >> 32) + (Cross >> 32) + HiHi;
+  uint64_t Lower = (Cross << 32) | (LoLo & 0xffffffff);
+  return Lower ^ Upper;
+#endif
+}
+
+static uint64_t XXH64_avalanche(uint64_t Hash) {
+  Hash ^= Hash >> 33;
+  Hash *= PRIME64_2;
+  Hash ^= Hash >> 29;
+  Hash *= PRIME64_3;
+  Hash ^= Hash >> 32;
+  return Hash;
+}
+
+static uint64_t XXH3_avalanche(uint64_t Hash) {
+  Hash ^= Hash >> 37;
+  Hash *= PRIME_MX1;
+  Hash ^= Hash >> 32;
+  return Hash;
+}
+
+static uint64_t XXH3_len_1to3_64b(const uint8_t *Input, size_t Len,
+                                  const uint8_t *Secret) {
+  const uint8_t C1 = Input[0];
+  const uint8_t C2 = Input[Len >> 1];
+  const uint8_t C3 = Input[Len - 1];
+  uint32_t Combined = ((uint32_t)C1 << 16) | ((uint32_t)C2 << 24) |
+                      ((uint32_t)C3 << 0) | ((uint32_t)Len << 8);
+  uint64_t Bitflip =
+      (uint64_t)(endian::read32le(Secret) ^ endian::read32le(Secret + 4));
+  return XXH64_avalanche(uint64_t(Combined) ^ Bitflip);
+}
+
+static uint64_t XXH3_len_4to8_64b(const uint8_t *Input, size_t Len,
+                                  const uint8_t *Secret) {
+  uint32_t Input1 = endian::read32le(Input);
+  uint32_t Input2 = endian::read32le(Input + Len - 4);
+  uint64_t Bitflip =
+      endian::read64le(Secret + 8) ^ endian::read64le(Secret + 16);
+  uint64_t Acc = (Input2 + ((uint64_t)Input1 << 32)) ^ Bitflip;
+
+  // rrmxmx mix.
+  Acc ^= rotl64(Acc, 49) ^ rotl64(Acc, 24);
+  Acc *= PRIME_MX2;
+  Acc ^= (Acc >> 35) + Len;
+  Acc *= PRIME_MX2;
+  return Acc ^ (Acc >> 28);
+}
+
+static uint64_t XXH3_len_9to16_64b(const uint8_t *Input, size_t Len,
+                                   const uint8_t *Secret) {
+  uint64_t InputLo = endian::read64le(Input) ^ (endian::read64le(Secret + 24) ^
+                                                endian::read64le(Secret + 32));
+  uint64_t InputHi =
+      endian::read64le(Input + Len - 8) ^
+      (endian::read64le(Secret + 40) ^ endian::read64le(Secret + 48));
+  uint64_t Acc = Len + ByteSwap_64(InputLo) + InputHi +
+                 mul128Fold64(InputLo, InputHi);
+  return XXH3_avalanche(Acc);
+}
+
+static uint64_t XXH3_len_0to16_64b(const uint8_t *Input, size_t Len,
+                                   const uint8_t *Secret) {
+  if (Len > 8)
+    return XXH3_len_9to16_64b(Input, Len, Secret);
+  if (Len >= 4)
+    return XXH3_len_4to8_64b(Input, Len, Secret);
+  if (Len)
+    return XXH3_len_1to3_64b(Input, Len, Secret);
+  return XXH64_avalanche(endian::read64le(Secret + 56) ^
+                         endian::read64le(Secret + 64));
+}
+
+static uint64_t XXH3_mix16B(const uint8_t *Input, const uint8_t *Secret) {
+  uint64_t InputLo = endian::read64le(Input);
+  uint64_t InputHi = endian::read64le(Input + 8);
+  return mul128Fold64(InputLo ^ endian::read64le(Secret),
+                      InputHi ^ endian::read64le(Secret + 8));
+}
+
+static uint64_t XXH3_len_17to128_64b(const uint8_t *Input, size_t Len,
+                                     const uint8_t *Secret) {
+  uint64_t Acc = Len * PRIME64_1;
+  if (Len > 32) {
+    if (Len > 64) {
+      if (Len > 96) {
+        Acc += XXH3_mix16B(Input + 48, Secret + 96);
+        Acc += XXH3_mix16B(Input + Len - 64, Secret + 112);
+      }
+      Acc += XXH3_mix16B(Input + 32, Secret + 64);
+      Acc += XXH3_mix16B(Input + Len - 48, Secret + 80);
+    }
+    Acc += XXH3_mix16B(Input + 16, Secret + 32);
+    Acc += XXH3_mix16B(Input + Len - 32, Secret + 48);
+  }
+  Acc += XXH3_mix16B(Input + 0, Secret + 0);
+  Acc += XXH3_mix16B(Input + Len - 16, Secret + 16);
+  return XXH3_avalanche(Acc);
+}
+
+constexpr size_t XXH3_MIDSIZE_MAX = 240;
+
+static uint64_t XXH3_len_129to240_64b(const uint8_t *Input, size_t Len,
+                                      const uint8_t *Secret) {
+  constexpr size_t XXH3_MIDSIZE_STARTOFFSET = 3;
+  constexpr size_t XXH3_MIDSIZE_LASTOFFSET = 17;
+  uint64_t Acc = Len * PRIME64_1;
+  const unsigned NbRounds = Len / 16;
+  for (unsigned I = 0; I < 8; ++I)
+    Acc += XXH3_mix16B(Input + 16 * I, Secret + 16 * I);
+  Acc = XXH3_avalanche(Acc);
+
+  for (unsigned I = 8; I < NbRounds; ++I)
+    Acc += XXH3_mix16B(Input + 16 * I,
+                       Secret + 16 * (I - 8) + XXH3_MIDSIZE_STARTOFFSET);
+  // Last 16 bytes.
+  Acc += XXH3_mix16B(Input + Len - 16,
+                     Secret + XXH3_SECRET_SIZE_MIN - XXH3_MIDSIZE_LASTOFFSET);
+  return XXH3_avalanche(Acc);
+}
+
+// Long inputs are consumed in 64-byte stripes that update eight 64-bit
+// accumulators. Each stripe uses the secret shifted by 8 bytes, and after a
+// block of 16 stripes the accumulators are scrambled with the secret's tail.
+constexpr size_t XXH_STRIPE_LEN = 64;
+constexpr size_t XXH_SECRET_CONSUME_RATE = 8;
+constexpr size_t XXH_ACC_NB = XXH_STRIPE_LEN / sizeof(uint64_t);
+constexpr size_t XXH_STRIPES_PER_BLOCK =
+    (XXH3_SECRET_SIZE - XXH_STRIPE_LEN) / XXH_SECRET_CONSUME_RATE;
+constexpr size_t XXH_BLOCK_LEN = XXH_STRIPE_LEN * XXH_STRIPES_PER_BLOCK;
+
+typedef void AccumulateFn(uint64_t *Acc, const uint8_t *Input,
+                          const uint8_t *Secret, size_t NbStripes);
+typedef void ScrambleFn(uint64_t *Acc, const uint8_t *Secret);
+
+static void accumulateScalar(uint64_t *Acc, const uint8_t *Input,
+                             const uint8_t *Secret, size_t NbStripes) {
+  for (size_t N = 0; N < NbStripes; ++N) {
+    const uint8_t *In = Input + N * XXH_STRIPE_LEN;
+    const uint8_t *Key = Secret + N * XXH_SECRET_CONSUME_RATE;
+    for (size_t I = 0; I < XXH_ACC_NB; ++I) {
+      uint64_t DataVal = endian::read64le(In + 8 * I);
+      uint64_t DataKey = DataVal ^ endian::read64le(Key + 8 * I);
+      Acc[I ^ 1] += DataVal;
+      Acc[I] += uint32_t(DataKey) * (DataKey >> 32);
+    }
+  }
+}
+
+static void scrambleScalar(uint64_t *Acc, const uint8_t *Secret) {
+  for (size_t I = 0; I < XXH_ACC_NB; ++I) {
+    Acc[I] ^= Acc[I] >> 47;
+    Acc[I] ^= endian::read64le(Secret + 8 * I);
+    Acc[I] *= PRIME32_1;
+  }
+}
+
+#ifdef XXH3_X86_AVX2
+__attribute__((target("avx2"))) static void
+accumulateAVX2(uint64_t *Acc, const uint8_t *Input, const uint8_t *Secret,
+               size_t NbStripes) {
+  // Keep the accumulators in registers for the whole block.
+  __m256i *const XAcc = reinterpret_cast<__m256i *>(Acc);
+  __m256i Accs[2] = {_mm256_loadu_si256(XAcc), _mm256_loadu_si256(XAcc + 1)};
+  for (size_t N = 0; N < NbStripes; ++N) {
+    const __m256i *In =
+        reinterpret_cast<const __m256i *>(Input + N * XXH_STRIPE_LEN);
+    const __m256i *Key = reinterpret_cast<const __m256i *>(
+        Secret + N * XXH_SECRET_CONSUME_RATE);
+    for (int I = 0; I < 2; ++I) {
+      __m256i Data = _mm256_loadu_si256(In + I);
+      __m256i DataKey = _mm256_xor_si256(Data, _mm256_loadu_si256(Key + I));
+      __m256i DataKeyHi =
+          _mm256_shuffle_epi32(DataKey, _MM_SHUFFLE(0, 3, 0, 1));
+      __m256i Product = _mm256_mul_epu32(DataKey, DataKeyHi);
+      __m256i DataSwap = _mm256_shuffle_epi32(Data, _MM_SHUFFLE(1, 0, 3, 2));
+      Accs[I] = _mm256_add_epi64(Product, _mm256_add_epi64(Accs[I], DataSwap));
+    }
+  }
+  _mm256_storeu_si256(XAcc, Accs[0]);
+  _mm256_storeu_si256(XAcc + 1, Accs[1]);
+}
+
+__attribute__((target("avx2"))) static void
+scrambleAVX2(uint64_t *Acc, const uint8_t *Secret) {
+  __m256i *const XAcc = reinterpret_cast<__m256i *>(Acc);
+  const __m256i *const Key = reinterpret_cast<const __m256i *>(Secret);
+  const __m256i Prime32 = _mm256_set1_epi32((int)PRIME32_1);
+  for (int I = 0; I < 2; ++I) {
+    __m256i AccVec = _mm256_loadu_si256(XAcc + I);
+    AccVec = _mm256_xor_si256(AccVec, _mm256_srli_epi64(AccVec, 47));
+    __m256i DataKey = _mm256_xor_si256(AccVec, _mm256_loadu_si256(Key + I));
+    __m256i DataKeyHi = _mm256_shuffle_epi32(DataKey, _MM_SHUFFLE(0, 3, 0, 1));
+    __m256i ProdLo = _mm256_mul_epu32(DataKey, Prime32);
+    __m256i ProdHi = _mm256_mul_epu32(DataKeyHi, Prime32);
+    _mm256_storeu_si256(
+        XAcc + I, _mm256_add_epi64(ProdLo, _mm256_slli_epi64(ProdHi, 32)));
+  }
+}
+
+static bool hasAVX2() {
+  static const bool Result = [] {
+    StringMap<bool> Features;
+    return sys::getHostCPUFeatures(Features) && Features.lookup("avx2");
+  }();
+  return Result;
+}
+#endif
+
+static uint64_t XXH3_hashLong_64b(const uint8_t *Input, size_t Len,
+                                  const uint8_t *Secret) {
+  AccumulateFn *Accumulate = accumulateScalar;
+  ScrambleFn *Scramble = scrambleScalar;
+#ifdef XXH3_X86_AVX2
+  if (hasAVX2()) {
+    Accumulate = accumulateAVX2;
+    Scramble = scrambleAVX2;
+  }
+#endif
+
+  uint64_t Acc[XXH_ACC_NB] = {PRIME32_3, PRIME64_1, PRIME64_2, PRIME64_3,
+                              PRIME64_4, PRIME32_2, PRIME64_5, PRIME32_1};
+  const size_t NbBlocks = (Len - 1) / XXH_BLOCK_LEN;
+  for (size_t N = 0; N < NbBlocks; ++N) {
+    Accumulate(Acc, Input + N * XXH_BLOCK_LEN, Secret, XXH_STRIPES_PER_BLOCK);
+    Scramble(Acc, Secret + XXH3_SECRET_SIZE - XXH_STRIPE_LEN);
+  }
+
+  // Last partial block, then the last stripe, which may overlap it.
+  const size_t NbStripes =
+      ((Len - 1) - XXH_BLOCK_LEN * NbBlocks) / XXH_STRIPE_LEN;
+  Accumulate(Acc, Input + NbBlocks * XXH_BLOCK_LEN, Secret, NbStripes);
+  constexpr size_t XXH_SECRET_LASTACC_START = 7;
+  Accumulate(Acc, Input + Len - XXH_STRIPE_LEN,
+             Secret + XXH3_SECRET_SIZE - XXH_STRIPE_LEN -
+                 XXH_SECRET_LASTACC_START,
+             1);
+
+  // Merge the accumulators.
+  constexpr size_t XXH_SECRET_MERGEACCS_START = 11;
+  uint64_t Result = Len * PRIME64_1;
+  for (size_t I = 0; I < 4; ++I)
+    Result += mul128Fold64(
+        Acc[2 * I] ^
+            endian::read64le(Secret + XXH_SECRET_MERGEACCS_START + 16 * I),
+        Acc[2 * I + 1] ^
+            endian::read64le(Secret + XXH_SECRET_MERGEACCS_START + 16 * I + 8));
+  return XXH3_avalanche(Result);
+}
+
+uint64_t llvm::xxh3_64bits(ArrayRef<uint8_t> Data) {
+  const uint8_t *In = Data.data();
+  size_t Len = Data.size();
+  if (Len <= 16)
+    return XXH3_len_0to16_64b(In, Len, kSecret);
+  if (Len <= 128)
+    return XXH3_len_17to128_64b(In, Len, kSecret);
+  if (Len <= XXH3_MIDSIZE_MAX)
+    return XXH3_len_129to240_64b(In, Len, kSecret);
+  return XXH3_hashLong_64b(In, Len, kSecret);
+}
@@ -41,6 +41,7 @@
 #include "llvm/Support/Error.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Parallel.h"
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Transforms/IPO/Internalize.h"
@@ -132,6 +133,12 @@ static cl::opt<bool> EnableImportMetadata(
                                   ),
     cl::Hidden, cl::desc("Enable import metadata like 'thinlto_src_module'"));
 
+/// Run the index-based ThinLTO analyses (dead symbols, imports, and in LTO.cpp
+/// the prevailing and internalization decisions) on several threads.
+cl::opt<bool> EnableParallelThinLink(
+    "thinlto-parallel-thin-link", cl::init(true), cl::Hidden,
+    cl::desc("Run the index-based ThinLTO analyses in parallel"));
+
 /// Summary file to use for function importing when using -function-import from
 /// the command line.
 static cl::opt<std::string>
@@ -512,7 +519,8 @@ static void computeImportForFunction(
 
     const auto AdjThreshold = GetAdjustedThreshold(Threshold, IsHotCallsite);
 
-    ImportCount++;
+    if (ImportCutoff >= 0)
+      ImportCount++;
 
     // Insert the newly imported function to the worklist.
     Worklist.emplace_back(ResolvedCalleeSummary, AdjThreshold, VI.getGUID());
@@ -621,29 +629,56 @@ void llvm::ComputeCrossModuleImport(
     StringMap<FunctionImporter::ImportMapTy> &ImportLists,
     StringMap<FunctionImporter::ExportSetTy> &ExportLists) {
   // For each module that has function defined, compute the import/export lists.
-  for (auto &DefinedGVSummaries : ModuleToDefinedGVSummaries) {
-    auto &ImportList = ImportLists[DefinedGVSummaries.first()];
-    LLVM_DEBUG(dbgs() << "Computing import for Module '"
-                      << DefinedGVSummaries.first() << "'\n");
-    ComputeImportForModule(DefinedGVSummaries.second, Index,
-                           DefinedGVSummaries.first(), ImportList,
-                           &ExportLists);
-  }
-
-  // When computing imports we added all GUIDs referenced by anything
-  // imported from the module to its ExportList. Now we prune each ExportList
-  // of any not defined in that module. This is more efficient than checking
-  // while computing imports because some of the summary lists may be long
-  // due to linkonce (comdat) copies.
-  for (auto &ELI : ExportLists) {
-    const auto &DefinedGVSummaries =
-        ModuleToDefinedGVSummaries.lookup(ELI.first());
-    for (auto EI = ELI.second.begin(); EI != ELI.second.end();) {
-      if (!DefinedGVSummaries.count(*EI))
-        EI = ELI.second.erase(EI);
-      else
-        ++EI;
+  // Modules are processed in parallel, each with its own export lists, which
+  // are merged in module order afterwards.
+  struct ModuleImports {
+    StringRef ModulePath;
+    const GVSummaryMapTy &DefinedGVSummaries;
+    FunctionImporter::ImportMapTy &ImportList;
+    StringMap<FunctionImporter::ExportSetTy> ExportLists;
+  };
+  std::vector<ModuleImports> Modules;
+  Modules.reserve(ModuleToDefinedGVSummaries.size());
+  for (auto &DefinedGVSummaries : ModuleToDefinedGVSummaries)
+    Modules.push_back({DefinedGVSummaries.first(), DefinedGVSummaries.second,
+                       ImportLists[DefinedGVSummaries.first()], {}});
+
+  auto ComputeImports = [&](ModuleImports &M) {
+    LLVM_DEBUG(dbgs() << "Computing import for Module '" << M.ModulePath
+                      << "'\n");
+    ComputeImportForModule(M.DefinedGVSummaries, Index, M.ModulePath,
+                           M.ImportList, &M.ExportLists);
+
+    // When computing imports we added all GUIDs referenced by anything
+    // imported from the module to its ExportList. Now we prune each
+    // ExportList of any not defined in that module, still in parallel, so
+    // that only the pruned lists are merged. This is more efficient than
+    // checking while computing imports because some of the summary lists may
+    // be long due to linkonce (comdat) copies.
+    for (auto &ELI : M.ExportLists) {
+      FunctionImporter::ExportSetTy Pruned;
+      auto DefinedGVSummaries = ModuleToDefinedGVSummaries.find(ELI.first());
+      if (DefinedGVSummaries != ModuleToDefinedGVSummaries.end())
+        for (GlobalValue::GUID GUID : ELI.second)
+          if (DefinedGVSummaries->second.count(GUID))
+            Pruned.insert(GUID);
+      ELI.second = std::move(Pruned);
     }
+  };
+  // -import-cutoff counts the imports of all modules, and
+  // -print-import-failures prints a report per module.
+  if (EnableParallelThinLink && ImportCutoff < 0 && !PrintImportFailures)
+    parallel::for_each(parallel::par, Modules.begin(), Modules.end(),
+                       ComputeImports);
+  else
+    for_each(Modules, ComputeImports);
+
+  // Merge the pruned export lists in module order, freeing the per-module
+  // lists as we go.
+  for (ModuleImports &M : Modules) {
+    for (auto &ELI : M.ExportLists)
+      ExportLists[ELI.first()].insert(ELI.second.begin(), ELI.second.end());
+    M.ExportLists.clear();
   }
 
 #ifndef NDEBUG
@@ -763,8 +798,16 @@ void llvm::computeDeadSymbols(
       }
   }
 
-  // Make value live and add it to the worklist if it was not live before.
-  auto visit = [&](ValueInfo VI, bool IsAliasee) {
+  auto isLive = [](ValueInfo VI) {
+    return llvm::any_of(VI.getSummaryList(),
+                        [](const std::unique_ptr<llvm::GlobalValueSummary> &S) {
+                          return S->isLive();
+                        });
+  };
+
+  // Whether a value reached by a reference must be made live.
+  enum class Visit { Ignore, MakeLive, Interposable };
+  auto visit = [&](ValueInfo &VI, bool IsAliasee) {
     // FIXME: If we knew which edges were created for indirect call profiles,
     // we could skip them here. Any that are live should be reached via
     // other edges, e.g. reference edges. Otherwise, using a profile collected
@@ -775,13 +818,10 @@ void llvm::computeDeadSymbols(
     // to functions marked dead are skipped.
     VI = updateValueInfoForIndirectCalls(Index, VI);
     if (!VI)
-      return;
+      return Visit::Ignore;
 
-    if (llvm::any_of(VI.getSummaryList(),
-                     [](const std::unique_ptr<llvm::GlobalValueSummary> &S) {
-                       return S->isLive();
-                     }))
-      return;
+    if (isLive(VI))
+      return Visit::Ignore;
 
     // We only keep live symbols that are known to be non-prevailing if any are
     // available_externally, linkonceodr, weakodr. Those symbols are discarded
@@ -802,39 +842,90 @@ void llvm::computeDeadSymbols(
 
       if (!IsAliasee) {
         if (!KeepAliveLinkage)
-          return;
+          return Visit::Ignore;
 
         if (Interposable)
-          report_fatal_error(
-              "Interposable and available_externally/linkonce_odr/weak_odr "
-              "symbol");
+          return Visit::Interposable;
       }
     }
+    return Visit::MakeLive;
+  };
 
-    for (auto &S : VI.getSummaryList())
-      S->setLive(true);
-    ++LiveSymbols;
-    Worklist.push_back(VI);
+  // Find the values referenced by the live values in \p Worklist that must be
+  // made live, in the order of the references.
+  using Reference = std::pair<ValueInfo, Visit>;
+  auto visitReferences = [&](ArrayRef<ValueInfo> Worklist,
+                             std::vector<Reference> &Refs) {
+    auto Add = [&](ValueInfo VI, bool IsAliasee) {
+      Visit V = visit(VI, IsAliasee);
+      if (V != Visit::Ignore)
+        Refs.emplace_back(VI, V);
+    };
+    for (ValueInfo VI : Worklist) {
+      for (auto &Summary : VI.getSummaryList()) {
+        if (auto *AS = dyn_cast<AliasSummary>(Summary.get())) {
+          // If this is an alias, visit the aliasee VI to ensure that all
+          // copies are marked live and it is added to the worklist for
+          // further processing of its references.
+          Add(AS->getAliaseeVI(), true);
+          continue;
+        }
+        for (auto Ref : Summary->refs())
+          Add(Ref, false);
+        if (auto *FS = dyn_cast<FunctionSummary>(Summary.get()))
+          for (auto Call : FS->calls())
+            Add(Call.first, false);
+      }
+    }
   };
 
+  // Propagate liveness one level of references at a time. The references of
+  // the values made live in the previous level are visited in parallel, in
+  // chunks; the values are then made live serially, in the order of the
+  // chunks, so that the result doesn't depend on the number of threads.
+  const size_t ChunkSize = 1024;
+  std::vector<std::vector<Reference>> ChunkRefs;
+  SmallVector<ValueInfo, 128> NextWorklist;
   while (!Worklist.empty()) {
-    auto VI = Worklist.pop_back_val();
-    for (auto &Summary : VI.getSummaryList()) {
-      if (auto *AS = dyn_cast<AliasSummary>(Summary.get())) {
-        // If this is an alias, visit the aliasee VI to ensure that all copies
-        // are marked live and it is added to the worklist for further
-        // processing of its references.
-        visit(AS->getAliaseeVI(), true);
-        continue;
+    // The roots may only have some of their summaries live.
+    for (ValueInfo VI : Worklist)
+      for (auto &Summary : VI.getSummaryList())
+        if (!isa<AliasSummary>(Summary.get()))
+          Summary->setLive(true);
+
+    size_t NumChunks = (Worklist.size() + ChunkSize - 1) / ChunkSize;
+    ChunkRefs.resize(NumChunks);
+    auto VisitChunk = [&](size_t I) {
+      ChunkRefs[I].clear();
+      visitReferences(makeArrayRef(Worklist)
+                          .slice(I * ChunkSize)
+                          .take_front(ChunkSize),
+                      ChunkRefs[I]);
+    };
+    if (EnableParallelThinLink && NumChunks > 1)
+      parallel::for_each_n(parallel::par, size_t(0), NumChunks, VisitChunk);
+    else
+      for (size_t I = 0; I != NumChunks; ++I)
+        VisitChunk(I);
+
+    NextWorklist.clear();
+    for (size_t I = 0; I != NumChunks; ++I) {
+      for (Reference &Ref : ChunkRefs[I]) {
+        ValueInfo VI = Ref.first;
+        // Made live earlier in this level.
+        if (isLive(VI))
+          continue;
+        if (Ref.second == Visit::Interposable)
+          report_fatal_error(
+              "Interposable and available_externally/linkonce_odr/weak_odr "
+              "symbol");
+        for (auto &S : VI.getSummaryList())
+          S->setLive(true);
+        ++LiveSymbols;
+        NextWorklist.push_back(VI);
       }
-
-      Summary->setLive(true);
-      for (auto Ref : Summary->refs())
-        visit(Ref, false);
-      if (auto *FS = dyn_cast<FunctionSummary>(Summary.get()))
-        for (auto Call : FS->calls())
-          visit(Call.first, false);
     }
+    std::swap(Worklist, NextWorklist);
   }
   Index.setWithGlobalValueDeadStripping();
 
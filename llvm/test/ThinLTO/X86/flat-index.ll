@@ -0,0 +1,42 @@
+;; Distributed backends read the flat indexes written by
+;; -thinlto-flat-index, and import the same functions as from bitcode indexes.
+; RUN: opt -module-summary %s -o %t1.bc
+; RUN: opt -module-summary %p/Inputs/flat-index.ll -o %t2.bc
+
+; RUN: llvm-lto2 run %t1.bc %t2.bc -o %t.ref -thinlto-distributed-indexes \
+; RUN:   -r=%t1.bc,main,plx -r=%t1.bc,g, -r=%t2.bc,g,plx -r=%t2.bc,h,plx
+; RUN: mv %t1.bc.thinlto.bc %t1.ref.thinlto.bc
+; RUN: mv %t2.bc.thinlto.bc %t2.ref.thinlto.bc
+; RUN: llvm-lto2 run %t1.bc %t2.bc -o %t -thinlto-distributed-indexes \
+; RUN:   -thinlto-flat-index \
+; RUN:   -r=%t1.bc,main,plx -r=%t1.bc,g, -r=%t2.bc,g,plx -r=%t2.bc,h,plx
+; RUN: not cmp -s %t1.ref.thinlto.bc %t1.bc.thinlto.bc
+
+; RUN: opt -function-import -import-all-index -summary-file %t1.ref.thinlto.bc \
+; RUN:   %t1.bc -S -o %t1.ref.ll
+; RUN: opt -function-import -import-all-index -summary-file %t1.bc.thinlto.bc \
+; RUN:   %t1.bc -S -o %t1.ll
+; RUN: FileCheck %s < %t1.ll
+; RUN: diff %t1.ref.ll %t1.ll
+
+;; The index of the second module imports nothing.
+; RUN: opt -function-import -import-all-index -summary-file %t2.ref.thinlto.bc \
+; RUN:   %t2.bc -S -o %t2.ref.ll
+; RUN: opt -function-import -import-all-index -summary-file %t2.bc.thinlto.bc \
+; RUN:   %t2.bc -S -o %t2.ll
+; RUN: diff %t2.ref.ll %t2.ll
+
+;; g is imported, and so is h, which it calls.
+; CHECK-DAG: define available_externally void @g()
+; CHECK-DAG: define available_externally void @h()
+
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+declare void @g()
+
+define void @main() {
+entry:
+  call void @g()
+  ret void
+}
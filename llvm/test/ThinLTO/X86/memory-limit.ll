@@ -0,0 +1,35 @@
+;; -thinlto-memory-limit changes when the backend jobs run, but not what they
+;; produce.
+; RUN: opt -module-summary %s -o %t1.bc
+; RUN: opt -module-summary %p/Inputs/memory-limit.ll -o %t2.bc
+
+; RUN: llvm-lto2 run %t1.bc %t2.bc -o %t.ref -thinlto-threads=2 \
+; RUN:   -r=%t1.bc,f,plx -r=%t1.bc,g, -r=%t2.bc,g,plx
+; RUN: llvm-lto2 run %t1.bc %t2.bc -o %t -thinlto-threads=2 \
+; RUN:   -thinlto-memory-limit=1 \
+; RUN:   -r=%t1.bc,f,plx -r=%t1.bc,g, -r=%t2.bc,g,plx
+; RUN: cmp %t.ref.1 %t.1
+; RUN: cmp %t.ref.2 %t.2
+
+;; Every job is larger than the limit, so they run one at a time.
+; RUN: llvm-lto2 run %t1.bc %t2.bc -o %t -thinlto-threads=2 \
+; RUN:   -thinlto-memory-limit=1 -thinlto-backend-bytes-per-inst=1048576 \
+; RUN:   -r=%t1.bc,f,plx -r=%t1.bc,g, -r=%t2.bc,g,plx
+; RUN: cmp %t.ref.1 %t.1
+; RUN: cmp %t.ref.2 %t.2
+
+; RUN: not llvm-lto2 run %t1.bc %t2.bc -o %t -thinlto-memory-limit=-1 \
+; RUN:   -r=%t1.bc,f,plx -r=%t1.bc,g, -r=%t2.bc,g,plx 2>&1 \
+; RUN:   | FileCheck %s --check-prefix=NEGATIVE
+; NEGATIVE: '-1' value invalid for uint argument!
+
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+declare void @g()
+
+define void @f() {
+entry:
+  call void @g()
+  ret void
+}
@@ -248,6 +248,8 @@ static std::unique_ptr<ToolOutputFile> GetOutputStream(const char *TargetName,
     return nullptr;
   }
 
+  // Overlap writing the output with code generation.
+  FDOut->os().enableBackgroundWrites();
   return FDOut;
 }
 
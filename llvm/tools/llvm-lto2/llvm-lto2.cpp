@@ -68,6 +68,11 @@ static cl::opt<bool>
 static cl::opt<int> Threads("thinlto-threads",
                             cl::init(llvm::heavyweight_hardware_concurrency()));
 
+static cl::opt<unsigned> ThinLTOMemoryLimit(
+    "thinlto-memory-limit", cl::init(0),
+    cl::desc("Limit the estimated memory used by concurrent ThinLTO backend "
+             "jobs, in megabytes"));
+
 static cl::list<std::string> SymbolResolutions(
     "r",
     cl::desc("Specify a symbol resolution: filename,symbolname,resolution\n"
@@ -279,7 +284,8 @@ static int run(int argc, char **argv) {
                                             /* LinkedObjectsFile */ nullptr,
                                             /* OnWrite */ {});
   else
-    Backend = createInProcessThinBackend(Threads);
+    Backend = createInProcessThinBackend(Threads,
+                                         (uint64_t)ThinLTOMemoryLimit << 20);
   LTO Lto(std::move(Conf), std::move(Backend));
 
   bool HasErrors = false;
@@ -0,0 +1,179 @@
+//===- llvm/unittest/ADT/FlatStringMapTest.cpp - FlatStringMap tests ------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/ADT/FlatStringMap.h"
+#include "llvm/ADT/StringMap.h"
+#include "gtest/gtest.h"
+#include <memory>
+#include <string>
+using namespace llvm;
+
+namespace {
+
+// A key longer than the inline key storage.
+const char LongKey[] = "_ZN4llvm13FlatStringMapIjNS_15MallocAllocatorEE4findE";
+
+TEST(FlatStringMapTest, Empty) {
+  FlatStringMap<uint32_t> Map;
+  EXPECT_EQ(0u, Map.size());
+  EXPECT_TRUE(Map.empty());
+  EXPECT_TRUE(Map.begin() == Map.end());
+  EXPECT_EQ(0u, Map.count("key"));
+  EXPECT_TRUE(Map.find("key") == Map.end());
+  EXPECT_EQ(0u, Map.lookup("key"));
+  EXPECT_FALSE(Map.erase("key"));
+}
+
+TEST(FlatStringMapTest, InsertAndFind) {
+  FlatStringMap<uint32_t> Map;
+  auto Ret = Map.insert({"key", 1});
+  EXPECT_TRUE(Ret.second);
+  EXPECT_EQ("key", Ret.first->getKey());
+  EXPECT_EQ(1u, Ret.first->second);
+
+  Ret = Map.insert({"key", 2});
+  EXPECT_FALSE(Ret.second);
+  EXPECT_EQ(1u, Ret.first->second);
+
+  Ret = Map.try_emplace(LongKey, 3);
+  EXPECT_TRUE(Ret.second);
+  EXPECT_EQ(LongKey, Ret.first->first());
+
+  Map[""] = 4;
+  EXPECT_EQ(3u, Map.size());
+  EXPECT_EQ(1u, Map.lookup("key"));
+  EXPECT_EQ(3u, Map.lookup(LongKey));
+  EXPECT_EQ(4u, Map.lookup(""));
+  EXPECT_EQ(1u, Map.count(StringRef(LongKey)));
+  EXPECT_EQ(0u, Map.count(StringRef(LongKey).drop_back()));
+
+  EXPECT_TRUE(Map.find("key", FlatStringMap<uint32_t>::hash("key")) ==
+              Map.find("key"));
+
+  Map.insert_or_assign("key", 5u);
+  EXPECT_EQ(5u, Map.lookup("key"));
+
+  unsigned Count = 0;
+  for (const auto &E : Map) {
+    EXPECT_EQ(Map.lookup(E.getKey()), E.getValue());
+    ++Count;
+  }
+  EXPECT_EQ(3u, Count);
+}
+
+TEST(FlatStringMapTest, Erase) {
+  FlatStringMap<uint32_t> Map;
+  Map["a"] = 1;
+  Map[LongKey] = 2;
+  EXPECT_TRUE(Map.erase(LongKey));
+  EXPECT_FALSE(Map.erase(LongKey));
+  EXPECT_EQ(1u, Map.size());
+  EXPECT_EQ(0u, Map.count(LongKey));
+
+  Map.erase(Map.find("a"));
+  EXPECT_TRUE(Map.empty());
+  EXPECT_TRUE(Map.begin() == Map.end());
+
+  Map[LongKey] = 3;
+  EXPECT_EQ(3u, Map.lookup(LongKey));
+  Map.clear();
+  EXPECT_TRUE(Map.empty());
+  EXPECT_EQ(0u, Map.count(LongKey));
+}
+
+// Compare against StringMap through growth and many erasures, so that the
+// table is rehashed and runs through deleted slots.
+TEST(FlatStringMapTest, ManyKeys) {
+  FlatStringMap<unsigned> Map;
+  StringMap<unsigned> Expected;
+  for (unsigned I = 0; I < 20000; ++I) {
+    std::string Key = (I % 3 ? "short" : "a_much_longer_key_") +
+                      std::to_string(I * 7919 % 20000);
+    Map[Key] = I;
+    Expected[Key] = I;
+    if (I % 5 == 0) {
+      std::string Victim = "short" + std::to_string(I / 2);
+      EXPECT_EQ(Expected.erase(Victim), Map.erase(Victim));
+    }
+  }
+
+  EXPECT_EQ(Expected.size(), Map.size());
+  for (const auto &E : Expected) {
+    auto It = Map.find(E.getKey());
+    ASSERT_TRUE(It != Map.end());
+    EXPECT_EQ(E.getValue(), It->getValue());
+  }
+  unsigned Count = 0;
+  for (const auto &E : Map) {
+    EXPECT_EQ(1u, Expected.count(E.getKey()));
+    ++Count;
+  }
+  EXPECT_EQ(Expected.size(), Count);
+}
+
+TEST(FlatStringMapTest, Reserve) {
+  FlatStringMap<int> Map(1000);
+  unsigned NumBuckets = Map.getNumBuckets();
+  EXPECT_LE(1000u, NumBuckets - NumBuckets / 8);
+  for (int I = 0; I < 1000; ++I)
+    Map[std::to_string(I)] = I;
+  EXPECT_EQ(NumBuckets, Map.getNumBuckets());
+}
+
+TEST(FlatStringMapTest, CopyAndMove) {
+  FlatStringMap<int> Map = {{"a", 1}, {LongKey, 2}};
+  FlatStringMap<int> Copy(Map);
+  EXPECT_EQ(2u, Copy.size());
+  EXPECT_EQ(1, Copy.lookup("a"));
+  EXPECT_EQ(2, Copy.lookup(LongKey));
+
+  Map.clear();
+  EXPECT_EQ(2, Copy.lookup(LongKey));
+
+  FlatStringMap<int> Moved(std::move(Copy));
+  EXPECT_EQ(2u, Moved.size());
+  EXPECT_EQ(2, Moved.lookup(LongKey));
+
+  Map = Moved;
+  EXPECT_EQ(2u, Map.size());
+  EXPECT_EQ(1, Map.lookup("a"));
+}
+
+TEST(FlatStringMapTest, MoveOnlyValue) {
+  FlatStringMap<std::unique_ptr<int>> Map;
+  for (int I = 0; I < 100; ++I)
+    Map.try_emplace(std::to_string(I), std::make_unique<int>(I));
+  for (int I = 0; I < 100; ++I)
+    EXPECT_EQ(I, *Map.find(std::to_string(I))->second);
+}
+
+TEST(FlatStringMapTest, BumpPtrAllocator) {
+  BumpPtrAllocator Alloc;
+  FlatStringMap<int, BumpPtrAllocator &> Map(Alloc);
+  Map[LongKey] = 1;
+  EXPECT_EQ(1, Map.lookup(LongKey));
+  EXPECT_LT(0u, Alloc.getBytesAllocated());
+}
+
+TEST(FlatStringMapTest, UnownedKeys) {
+  std::string Key = LongKey;
+  FlatStringMap<int, FlatStringMapUnownedKeys> Map;
+  Map[Key] = 1;
+  Map["a"] = 2;
+  EXPECT_EQ(Key.data(), Map.find(Key)->getKey().data());
+  EXPECT_EQ(1, Map.lookup(LongKey));
+
+  // Copies refer to the same characters.
+  FlatStringMap<int, FlatStringMapUnownedKeys> Copy(Map);
+  EXPECT_EQ(Key.data(), Copy.find(LongKey)->getKey().data());
+  EXPECT_EQ(2, Copy.lookup("a"));
+  EXPECT_TRUE(Map.erase(LongKey));
+  EXPECT_EQ(1, Copy.lookup(LongKey));
+}
+
+} // end anonymous namespace
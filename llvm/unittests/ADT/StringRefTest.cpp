@@ -496,6 +496,42 @@ TEST(StringRefTest, Find) {
   EXPECT_EQ(StringRef::npos, Str.find_last_not_of("helo"));
 }
 
+// Compare against std::string on strings long enough to use the vectorized
+// searches, at every offset.
+TEST(StringRefTest, FindLong) {
+  std::string Text;
+  for (unsigned I = 0; I < 300; ++I)
+    Text += "abcabd"[I * 7919 % 6];
+  Text += "needle";
+  StringRef Str = Text;
+
+  const char *Needles[] = {"ab", "bd", "cab", "abcabd", "dn", "needle", "e",
+                           "abdabcabdabcabdabcabdabcabdabcabdabcabdabc", "zz"};
+  for (StringRef Needle : Needles) {
+    for (size_t From = 0; From <= Text.size() + 1; ++From)
+      EXPECT_EQ(Text.find(Needle.str(), From), Str.find(Needle, From))
+          << Needle << " from " << From;
+    size_t Count = 0;
+    for (size_t I = Text.find(Needle.str()); I != std::string::npos;
+         I = Text.find(Needle.str(), I + 1))
+      ++Count;
+    EXPECT_EQ(Count, Str.count(Needle)) << Needle;
+  }
+
+  const char *CharSets[] = {"d", "de", "xyzn", "0123456789ABCDEl",
+                            "0123456789ABCDEFe"};
+  for (StringRef Chars : CharSets)
+    for (size_t From = 0; From <= Text.size() + 1; ++From)
+      EXPECT_EQ(Text.find_first_of(Chars.str(), From),
+                Str.find_first_of(Chars, From))
+          << Chars << " from " << From;
+
+  for (char C : StringRef("abdez"))
+    for (size_t Size = 0; Size <= Text.size(); ++Size)
+      EXPECT_EQ(size_t(std::count(Text.begin(), Text.begin() + Size, C)),
+                Str.take_front(Size).count(C));
+}
+
 TEST(StringRefTest, Count) {
   StringRef Str("hello");
   EXPECT_EQ(2U, Str.count('l'));
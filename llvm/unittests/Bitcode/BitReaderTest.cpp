@@ -14,10 +14,12 @@
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/Verifier.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/Error.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/raw_ostream.h"
 #include "gtest/gtest.h"
 
 using namespace llvm;
@@ -190,4 +192,72 @@ TEST(BitReaderTest, MaterializeFunctionsForBlockAddrInFunctionAfter) {
   EXPECT_FALSE(verifyModule(*M, &dbgs()));
 }
 
+// Tests that decoding function bodies on other threads gives the same module
+// as decoding them while parsing.
+TEST(BitReaderTest, MaterializeAllWithDecodeThreads) {
+  std::string Assembly = "declare void @ext(i8*)\n"
+                         "@str = constant [6 x i8] c\"hello\\00\"\n";
+  for (unsigned I = 0; I < 40; ++I) {
+    std::string N = std::to_string(I);
+    Assembly += "define i32 @f" + N + "(i32 %x, i32* %p) {\n"
+                "entry:\n"
+                "  %v = load i32, i32* %p, !range !0\n"
+                "  %sum = add i32 %x, " + std::to_string(I * 1000003) + "\n"
+                "  call void @ext(i8* getelementptr ([6 x i8], [6 x i8]* @str,"
+                " i32 0, i32 " + std::to_string(I % 6) + "))\n"
+                "  switch i32 %v, label %done [i32 0, label %loop\n"
+                "                               i32 7, label %done]\n"
+                "loop:\n"
+                "  %i = phi i32 [ 0, %entry ], [ %next, %loop ]\n"
+                "  %next = add i32 %i, %sum\n"
+                "  %c = icmp ult i32 %next, 100\n"
+                "  br i1 %c, label %loop, label %done\n"
+                "done:\n"
+                "  %r = phi i32 [ %sum, %entry ], [ %sum, %entry ],"
+                " [ %next, %loop ]\n";
+    if (I)
+      Assembly +=
+          "  call i32 @f" + std::to_string(I - 1) + "(i32 %r, i32* %p)\n";
+    Assembly += "  ret i32 %r\n"
+                "}\n";
+  }
+  Assembly += "define i8* @addr() {\n"
+              "  ret i8* blockaddress(@f30, %loop)\n"
+              "}\n"
+              "!0 = !{i32 0, i32 10}\n";
+
+  SmallString<1024> Mem;
+  LLVMContext Context;
+  writeModuleToBuffer(parseAssembly(Context, Assembly.c_str()), Mem);
+
+  auto *Threads = static_cast<cl::opt<unsigned> *>(
+      cl::getRegisteredOptions().lookup("bitcode-decode-threads"));
+  ASSERT_TRUE(Threads);
+  auto Parse = [&](unsigned NumThreads, bool OutOfOrder) {
+    Expected<std::unique_ptr<Module>> ModuleOrErr =
+        getLazyBitcodeModule(MemoryBufferRef(Mem.str(), "test"), Context);
+    if (!ModuleOrErr)
+      report_fatal_error("Could not parse bitcode module");
+    std::unique_ptr<Module> M = std::move(*ModuleOrErr);
+    // Materializing @addr pulls in @f30, before the other bodies.
+    if (OutOfOrder && M->getFunction("addr")->materialize())
+      report_fatal_error("Could not materialize @addr");
+    *Threads = NumThreads;
+    Error Err = M->materializeAll();
+    *Threads = 0;
+    if (Err)
+      report_fatal_error(std::move(Err));
+    EXPECT_FALSE(verifyModule(*M, &dbgs()));
+    std::string Str;
+    raw_string_ostream OS(Str);
+    M->print(OS, nullptr);
+    return OS.str();
+  };
+
+  std::string Serial = Parse(0, false);
+  EXPECT_EQ(Serial, Parse(1, false));
+  EXPECT_EQ(Serial, Parse(4, false));
+  EXPECT_EQ(Serial, Parse(4, true));
+}
+
 } // end namespace
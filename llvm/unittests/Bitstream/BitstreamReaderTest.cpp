@@ -151,6 +151,129 @@ TEST(BitstreamReaderTest, readRecordWithBlobWhileStreaming) {
   }
 }
 
+// Read the block the cursor is positioned at into a string, skipping nested
+// blocks with ID SkipID.
+static void readBlock(BitstreamCursor &Stream, unsigned BlockID,
+                      unsigned SkipID, bool TakeBlobs, std::string &Log) {
+  ASSERT_FALSE(Stream.EnterSubBlock(BlockID));
+  Log += "<" + std::to_string(BlockID);
+  while (true) {
+    Expected<BitstreamEntry> MaybeEntry = Stream.advance();
+    ASSERT_TRUE((bool)MaybeEntry);
+    BitstreamEntry Entry = MaybeEntry.get();
+    switch (Entry.Kind) {
+    case BitstreamEntry::Error:
+      FAIL();
+    case BitstreamEntry::EndBlock:
+      Log += ">";
+      return;
+    case BitstreamEntry::SubBlock:
+      if (Entry.ID == SkipID)
+        ASSERT_FALSE(Stream.SkipBlock());
+      else
+        readBlock(Stream, Entry.ID, SkipID, TakeBlobs, Log);
+      continue;
+    case BitstreamEntry::Record:
+      break;
+    }
+    SmallVector<uint64_t, 8> Record;
+    StringRef Blob;
+    Expected<unsigned> MaybeCode =
+        Stream.readRecord(Entry.ID, Record, TakeBlobs ? &Blob : nullptr);
+    ASSERT_TRUE((bool)MaybeCode);
+    Log += " " + std::to_string(MaybeCode.get()) + ":";
+    for (uint64_t Op : Record)
+      Log += std::to_string(Op) + ",";
+    Log += Blob;
+  }
+}
+
+TEST(BitstreamReaderTest, decodeAndReplayBlock) {
+  const unsigned Magic = 0x12345678;
+  const unsigned BlockID = bitc::FIRST_APPLICATION_BLOCKID;
+  SmallVector<char, 64> Buffer;
+  {
+    BitstreamWriter Stream(Buffer);
+    Stream.Emit(Magic, 32);
+    Stream.EnterSubblock(BlockID, 3);
+
+    auto Abbrev = std::make_shared<BitCodeAbbrev>();
+    Abbrev->Add(BitCodeAbbrevOp(1));
+    Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Fixed, 4));
+    Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Array));
+    Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 6));
+    unsigned ArrayAbbrev = Stream.EmitAbbrev(std::move(Abbrev));
+    Abbrev = std::make_shared<BitCodeAbbrev>();
+    Abbrev->Add(BitCodeAbbrevOp(2));
+    Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 6));
+    Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Blob));
+    unsigned BlobAbbrev = Stream.EmitAbbrev(std::move(Abbrev));
+
+    Stream.EmitRecord(1, ArrayRef<unsigned>{7, 1000, 123456}, ArrayAbbrev);
+    Stream.EmitRecord(3, ArrayRef<uint64_t>{1ull << 40});
+    Stream.EnterSubblock(BlockID + 1, 4);
+    Stream.EmitRecord(4, ArrayRef<unsigned>{5, 6});
+    Stream.EnterSubblock(BlockID + 2, 2);
+    Stream.EmitRecord(5, ArrayRef<unsigned>{});
+    Stream.ExitBlock();
+    Stream.ExitBlock();
+    Stream.EnterSubblock(BlockID + 2, 2);
+    Stream.EmitRecord(6, ArrayRef<unsigned>{8});
+    Stream.ExitBlock();
+    unsigned Record[] = {2, 9};
+    Stream.EmitRecordWithBlob(BlobAbbrev, makeArrayRef(Record), "blob");
+    Stream.EmitRecord(7, ArrayRef<unsigned>{10});
+    Stream.ExitBlock();
+  }
+  ArrayRef<uint8_t> Bytes((const uint8_t *)Buffer.begin(), Buffer.size());
+
+  // Position a cursor after the block's ENTER_SUBBLOCK abbrevid and ID.
+  auto SeekToBlock = [&](BitstreamCursor &Stream) {
+    ASSERT_FALSE(Stream.JumpToBit(32));
+    Expected<BitstreamEntry> MaybeEntry = Stream.advance();
+    ASSERT_TRUE((bool)MaybeEntry);
+    ASSERT_EQ(BitstreamEntry::SubBlock, MaybeEntry->Kind);
+    ASSERT_EQ(BlockID, MaybeEntry->ID);
+  };
+
+  for (bool TakeBlobs : {false, true}) {
+    BitstreamCursor Stream(Bytes);
+    SeekToBlock(Stream);
+    std::string Serial;
+    readBlock(Stream, BlockID, BlockID + 2, TakeBlobs, Serial);
+    EXPECT_EQ(TakeBlobs ? "<8 1:7,1000,123456, 3:1099511627776,<9 4:5,6,>"
+                          " 2:9,blob 7:10,>"
+                        : "<8 1:7,1000,123456, 3:1099511627776,<9 4:5,6,>"
+                          " 2:9,98,108,111,98, 7:10,>",
+              Serial);
+
+    // Decoding moves the cursor past the block.
+    BitstreamCursor Decoder(Bytes);
+    SeekToBlock(Decoder);
+    DecodedBitstreamBlock Decoded;
+    ASSERT_FALSE(Decoder.decodeBlock(BlockID, Decoded));
+    EXPECT_EQ(Stream.GetCurrentBitNo(), Decoder.GetCurrentBitNo());
+
+    // Replaying gives the same entries and records, and leaves the cursor
+    // where it was.
+    BitstreamCursor Replayer(Bytes);
+    SeekToBlock(Replayer);
+    uint64_t BitNo = Replayer.GetCurrentBitNo();
+    Replayer.replay(Decoded);
+    EXPECT_TRUE(Replayer.isReplaying());
+    std::string Replayed;
+    readBlock(Replayer, BlockID, BlockID + 2, TakeBlobs, Replayed);
+    EXPECT_EQ(Serial, Replayed);
+    EXPECT_FALSE(Replayer.isReplaying());
+    EXPECT_EQ(BitNo, Replayer.GetCurrentBitNo());
+
+    // Skipping the replayed block ends the replay too.
+    Replayer.replay(Decoded);
+    EXPECT_FALSE(Replayer.SkipBlock());
+    EXPECT_FALSE(Replayer.isReplaying());
+  }
+}
+
 TEST(BitstreamReaderTest, shortRead) {
   uint8_t Bytes[] = {8, 7, 6, 5, 4, 3, 2, 1};
   for (unsigned I = 1; I != 8; ++I) {
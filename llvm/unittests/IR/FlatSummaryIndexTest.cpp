@@ -0,0 +1,393 @@
+//===- FlatSummaryIndexTest.cpp - Flat summary index unit tests -----------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/IR/FlatSummaryIndex.h"
+#include "llvm/IR/ModuleSummaryIndex.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Testing/Support/Error.h"
+#include "gtest/gtest.h"
+
+using namespace llvm;
+
+namespace {
+
+GlobalValueSummary::GVFlags makeFlags(GlobalValue::LinkageTypes Linkage,
+                                      bool Live = true) {
+  return GlobalValueSummary::GVFlags(Linkage, /*NotEligibleToImport=*/false,
+                                     Live, /*IsLocal=*/true,
+                                     /*CanAutoHide=*/false);
+}
+
+std::unique_ptr<FunctionSummary>
+makeFunction(ModuleSummaryIndex &Index, StringRef ModulePath,
+             GlobalValue::LinkageTypes Linkage, std::vector<ValueInfo> Refs,
+             std::vector<FunctionSummary::EdgeTy> Calls,
+             std::vector<GlobalValue::GUID> TypeTests = {}) {
+  FunctionSummary::FFlags FFlags{};
+  FFlags.NoRecurse = true;
+  auto FS = std::make_unique<FunctionSummary>(
+      makeFlags(Linkage), /*NumInsts=*/12, FFlags, /*EntryCount=*/3,
+      std::move(Refs), std::move(Calls), std::move(TypeTests),
+      std::vector<FunctionSummary::VFuncId>{{GlobalValue::getGUID("T"), 8}},
+      std::vector<FunctionSummary::VFuncId>(),
+      std::vector<FunctionSummary::ConstVCall>(),
+      std::vector<FunctionSummary::ConstVCall>{
+          {{GlobalValue::getGUID("T"), 16}, {1, 2}}});
+  FS->setModulePath(ModulePath);
+  return FS;
+}
+
+struct TestIndex {
+  ModuleSummaryIndex Index{/*HaveGVs=*/false};
+  GlobalValue::GUID Main = GlobalValue::getGUID("main");
+  GlobalValue::GUID Foo = GlobalValue::getGUID("foo");
+  GlobalValue::GUID FooAlias = GlobalValue::getGUID("foo_alias");
+  GlobalValue::GUID Local = GlobalValue::getGUID("b.o;local");
+  GlobalValue::GUID Var = GlobalValue::getGUID("var");
+  GlobalValue::GUID Unused = GlobalValue::getGUID("unused");
+  StringRef A, B, C;
+
+  TestIndex(bool UnusedTypeId = true) {
+    A = Index.addModule("a.o", 0, {{1, 2, 3, 4, 5}})->first();
+    B = Index.addModule("b.o", 1, {{6, 7, 8, 9, 10}})->first();
+    C = Index.addModule("c.o", 2)->first();
+    Index.setWithGlobalValueDeadStripping();
+    Index.setEnableSplitLTOUnit();
+
+    ValueInfo VarVI = Index.getOrInsertValueInfo(Var);
+    auto VS = std::make_unique<GlobalVarSummary>(
+        makeFlags(GlobalValue::ExternalLinkage),
+        GlobalVarSummary::GVarFlags(/*ReadOnly=*/true, /*WriteOnly=*/false),
+        std::vector<ValueInfo>{Index.getOrInsertValueInfo(Foo)});
+    VS->setModulePath(B);
+    Index.addGlobalValueSummary(VarVI, std::move(VS));
+
+    ValueInfo ReadOnlyVar = VarVI;
+    ReadOnlyVar.setReadOnly();
+    Index.addGlobalValueSummary(
+        Index.getOrInsertValueInfo(Main),
+        makeFunction(Index, A, GlobalValue::ExternalLinkage, {ReadOnlyVar},
+                     {{Index.getOrInsertValueInfo(Foo),
+                       CalleeInfo(CalleeInfo::HotnessType::Hot, 0)},
+                      {Index.getOrInsertValueInfo(FooAlias),
+                       CalleeInfo(CalleeInfo::HotnessType::Cold, 0)}},
+                     {GlobalValue::getGUID("T")}));
+
+    std::unique_ptr<FunctionSummary> FooSummary =
+        makeFunction(Index, B, GlobalValue::ExternalLinkage, {},
+                     {{Index.getOrInsertValueInfo(Local), CalleeInfo()}});
+    FunctionSummary *FooPtr = FooSummary.get();
+    ValueInfo FooVI = Index.getOrInsertValueInfo(Foo);
+    Index.addGlobalValueSummary(FooVI, std::move(FooSummary));
+    auto AS = std::make_unique<AliasSummary>(
+        makeFlags(GlobalValue::WeakAnyLinkage));
+    AS->setModulePath(B);
+    AS->setAliasee(FooVI, FooPtr);
+    Index.addGlobalValueSummary(Index.getOrInsertValueInfo(FooAlias),
+                                std::move(AS));
+
+    std::unique_ptr<FunctionSummary> LocalSummary = makeFunction(
+        Index, B, GlobalValue::InternalLinkage, {VarVI}, {});
+    LocalSummary->setOriginalName(GlobalValue::getGUID("local"));
+    Index.addGlobalValueSummary(Index.getOrInsertValueInfo(Local),
+                                std::move(LocalSummary));
+
+    // A second copy of foo, which is not live.
+    auto FooCopy = makeFunction(Index, C, GlobalValue::LinkOnceODRLinkage,
+                                {}, {});
+    FooCopy->setLive(false);
+    Index.addGlobalValueSummary(FooVI, std::move(FooCopy));
+
+    Index.addGlobalValueSummary(
+        Index.getOrInsertValueInfo(Unused),
+        makeFunction(Index, C, GlobalValue::ExternalLinkage, {}, {}));
+
+    Index.cfiFunctionDefs().insert("foo");
+    Index.cfiFunctionDecls().insert("external");
+    TypeIdSummary &TIS = Index.getOrInsertTypeIdSummary("T");
+    TIS.TTRes.TheKind = TypeTestResolution::Inline;
+    TIS.TTRes.SizeM1BitWidth = 5;
+    TIS.TTRes.InlineBits = 0x1234;
+    TIS.WPDRes[8].TheKind = WholeProgramDevirtResolution::SingleImpl;
+    TIS.WPDRes[8].SingleImplName = "impl";
+    TIS.WPDRes[16].ResByArg[{1, 2}].TheKind =
+        WholeProgramDevirtResolution::ByArg::UniformRetVal;
+    TIS.WPDRes[16].ResByArg[{1, 2}].Info = 42;
+    // Not referenced by any function.
+    if (UnusedTypeId)
+      Index.getOrInsertTypeIdSummary("U");
+  }
+};
+
+std::string print(const ModuleSummaryIndex &Index) {
+  std::string S;
+  raw_string_ostream OS(S);
+  Index.print(OS);
+  return OS.str();
+}
+
+SmallString<0> write(const ModuleSummaryIndex &Index,
+                     const std::map<std::string, GVSummaryMapTy>
+                         *ModuleToSummariesForIndex = nullptr) {
+  SmallString<0> Buffer;
+  raw_svector_ostream OS(Buffer);
+  writeFlatSummaryIndex(Index, OS, ModuleToSummariesForIndex);
+  return Buffer;
+}
+
+} // end anonymous namespace
+
+TEST(FlatSummaryIndexTest, RoundTrip) {
+  TestIndex T;
+  SmallString<0> Buffer = write(T.Index);
+  MemoryBufferRef Ref(Buffer, "index");
+  ASSERT_TRUE(FlatSummaryIndex::isFlatSummaryIndex(Ref));
+
+  Expected<std::unique_ptr<ModuleSummaryIndex>> Index =
+      readFlatSummaryIndex(Ref);
+  ASSERT_THAT_EXPECTED(Index, Succeeded());
+  ModuleSummaryIndex &Read = **Index;
+  EXPECT_TRUE(Read.withGlobalValueDeadStripping());
+  EXPECT_TRUE(Read.enableSplitLTOUnit());
+  EXPECT_FALSE(Read.skipModuleByDistributedBackend());
+  EXPECT_EQ(T.Index.cfiFunctionDefs(), Read.cfiFunctionDefs());
+  // The declaration is neither defined nor used by the summaries.
+  EXPECT_TRUE(Read.cfiFunctionDecls().empty());
+  EXPECT_EQ(T.Local, Read.getGUIDFromOriginalID(GlobalValue::getGUID("local")));
+  EXPECT_EQ(nullptr, Read.getTypeIdSummary("U"));
+
+  // Apart from the unreferenced type identifier, everything else matches.
+  EXPECT_EQ(print(TestIndex(/*UnusedTypeId=*/false).Index), print(Read));
+}
+
+TEST(FlatSummaryIndexTest, DistributedIndex) {
+  TestIndex T;
+  // The index of a backend for a.o, importing foo_alias and var from b.o.
+  std::map<std::string, GVSummaryMapTy> ModuleToSummariesForIndex;
+  ModuleToSummariesForIndex["a.o"][T.Main] =
+      T.Index.findSummaryInModule(T.Main, "a.o");
+  ModuleToSummariesForIndex["b.o"][T.FooAlias] =
+      T.Index.findSummaryInModule(T.FooAlias, "b.o");
+  ModuleToSummariesForIndex["b.o"][T.Var] =
+      T.Index.findSummaryInModule(T.Var, "b.o");
+  SmallString<0> Buffer = write(T.Index, &ModuleToSummariesForIndex);
+
+  Expected<std::unique_ptr<FlatSummaryIndex>> FSI =
+      FlatSummaryIndex::create(MemoryBufferRef(Buffer, "index"));
+  ASSERT_THAT_EXPECTED(FSI, Succeeded());
+  ASSERT_EQ(2u, (*FSI)->getNumModules());
+  EXPECT_EQ("a.o", (*FSI)->getModulePath(0));
+  EXPECT_EQ("b.o", (*FSI)->getModulePath(1));
+  EXPECT_EQ(1u, (*FSI)->getModuleId(1));
+  EXPECT_EQ(T.Index.getModuleHash("b.o"), (*FSI)->getModuleHash(1));
+  // foo is written because it is the aliasee of foo_alias, but without its
+  // summary.
+  EXPECT_EQ(4u, (*FSI)->getNumValues());
+  EXPECT_EQ(1u, (*FSI)->getNumSummaries(T.Main));
+  EXPECT_EQ(0u, (*FSI)->getNumSummaries(T.Foo));
+  EXPECT_TRUE((*FSI)->findValue(T.Foo).hasValue());
+  EXPECT_FALSE((*FSI)->findValue(T.Local).hasValue());
+  EXPECT_FALSE((*FSI)->findValue(T.Unused).hasValue());
+
+  Expected<std::unique_ptr<ModuleSummaryIndex>> Index = (*FSI)->createIndex();
+  ASSERT_THAT_EXPECTED(Index, Succeeded());
+  ASSERT_THAT_ERROR((*FSI)->materializeAll(**Index), Succeeded());
+  ModuleSummaryIndex &Read = **Index;
+  EXPECT_EQ(2u, Read.modulePaths().size());
+
+  // Like in bitcode, the call to foo is kept, as the aliasee of foo_alias
+  // has an entry in the GUID table.
+  auto *MainFS =
+      cast<FunctionSummary>(Read.findSummaryInModule(T.Main, "a.o"));
+  ASSERT_EQ(2u, MainFS->calls().size());
+  EXPECT_EQ(T.Foo, MainFS->calls()[0].first.getGUID());
+  EXPECT_EQ(CalleeInfo::HotnessType::Hot,
+            MainFS->calls()[0].second.getHotness());
+  EXPECT_EQ(T.FooAlias, MainFS->calls()[1].first.getGUID());
+  EXPECT_EQ(CalleeInfo::HotnessType::Cold,
+            MainFS->calls()[1].second.getHotness());
+  ASSERT_EQ(1u, MainFS->refs().size());
+  EXPECT_EQ(T.Var, MainFS->refs()[0].getGUID());
+  EXPECT_TRUE(MainFS->refs()[0].isReadOnly());
+  EXPECT_EQ(12u, MainFS->instCount());
+  EXPECT_EQ(3u, MainFS->entryCount());
+  EXPECT_TRUE(MainFS->fflags().NoRecurse);
+  EXPECT_EQ(1u, MainFS->type_test_assume_vcalls().size());
+  ASSERT_EQ(1u, MainFS->type_checked_load_const_vcalls().size());
+  EXPECT_EQ(std::vector<uint64_t>({1, 2}),
+            MainFS->type_checked_load_const_vcalls()[0].Args);
+  ASSERT_NE(nullptr, Read.getTypeIdSummary("T"));
+  EXPECT_EQ("impl", Read.getTypeIdSummary("T")->WPDRes.at(8).SingleImplName);
+
+  auto *AS = cast<AliasSummary>(Read.findSummaryInModule(T.FooAlias, "b.o"));
+  EXPECT_EQ(T.Foo, AS->getAliaseeGUID());
+  EXPECT_FALSE(AS->hasAliasee());
+  EXPECT_EQ(GlobalValue::WeakAnyLinkage, AS->linkage());
+  EXPECT_TRUE(Read.getValueInfo(T.Foo).getSummaryList().empty());
+
+  // The reference of var to foo is kept, as foo has a GUID table entry.
+  auto *VS = cast<GlobalVarSummary>(Read.findSummaryInModule(T.Var, "b.o"));
+  EXPECT_TRUE(VS->maybeReadOnly());
+  EXPECT_FALSE(VS->maybeWriteOnly());
+  ASSERT_EQ(1u, VS->refs().size());
+  EXPECT_EQ(T.Foo, VS->refs()[0].getGUID());
+}
+
+TEST(FlatSummaryIndexTest, Materialize) {
+  TestIndex T;
+  SmallString<0> Buffer = write(T.Index);
+  Expected<std::unique_ptr<FlatSummaryIndex>> FSI =
+      FlatSummaryIndex::create(MemoryBufferRef(Buffer, "index"));
+  ASSERT_THAT_EXPECTED(FSI, Succeeded());
+  Expected<std::unique_ptr<ModuleSummaryIndex>> Index = (*FSI)->createIndex();
+  ASSERT_THAT_EXPECTED(Index, Succeeded());
+  ModuleSummaryIndex &Read = **Index;
+  EXPECT_EQ(0u, Read.size());
+
+  // Materializing the alias brings in the aliasee, with both of its copies.
+  Expected<ValueInfo> VI = (*FSI)->materialize(T.FooAlias, Read);
+  ASSERT_THAT_ERROR(VI.takeError(), Succeeded());
+  ASSERT_EQ(1u, VI->getSummaryList().size());
+  auto *AS = cast<AliasSummary>(VI->getSummaryList()[0].get());
+  ASSERT_TRUE(AS->hasAliasee());
+  EXPECT_EQ("b.o", AS->getAliasee().modulePath());
+  EXPECT_EQ(2u, Read.getValueInfo(T.Foo).getSummaryList().size());
+
+  // foo calls local, which is not materialized yet.
+  ValueInfo LocalVI = Read.getValueInfo(T.Local);
+  ASSERT_TRUE(LocalVI);
+  EXPECT_TRUE(LocalVI.getSummaryList().empty());
+  VI = (*FSI)->materialize(T.Local, Read);
+  ASSERT_THAT_ERROR(VI.takeError(), Succeeded());
+  EXPECT_EQ(LocalVI, *VI);
+  ASSERT_EQ(1u, LocalVI.getSummaryList().size());
+  EXPECT_EQ(GlobalValue::InternalLinkage,
+            LocalVI.getSummaryList()[0]->linkage());
+
+  // Materializing again does not duplicate the summaries.
+  VI = (*FSI)->materialize(T.Foo, Read);
+  ASSERT_THAT_ERROR(VI.takeError(), Succeeded());
+  EXPECT_EQ(2u, VI->getSummaryList().size());
+
+  VI = (*FSI)->materialize(GlobalValue::getGUID("missing"), Read);
+  ASSERT_THAT_ERROR(VI.takeError(), Succeeded());
+  EXPECT_FALSE(*VI);
+  EXPECT_FALSE(Read.getValueInfo(T.Main));
+}
+
+TEST(FlatSummaryIndexTest, Malformed) {
+  TestIndex T;
+  SmallString<0> Buffer = write(T.Index);
+
+  SmallString<0> BadMagic = Buffer;
+  BadMagic[1] = 'X';
+  EXPECT_FALSE(
+      FlatSummaryIndex::isFlatSummaryIndex(MemoryBufferRef(BadMagic, "index")));
+  EXPECT_THAT_EXPECTED(
+      FlatSummaryIndex::create(MemoryBufferRef(BadMagic, "index")), Failed());
+
+  for (size_t Size : {size_t(20), sizeof(flatsummary::Header),
+                      Buffer.size() - 8})
+    EXPECT_THAT_EXPECTED(
+        readFlatSummaryIndex(MemoryBufferRef(Buffer.str().take_front(Size),
+                                             "index")),
+        Failed());
+
+  // Truncate the summaries of the last value.
+  SmallString<0> Truncated = Buffer;
+  auto *H = reinterpret_cast<flatsummary::Header *>(Truncated.data());
+  H->SummariesSize = H->SummariesSize - 4;
+  EXPECT_THAT_EXPECTED(
+      readFlatSummaryIndex(MemoryBufferRef(Truncated, "index")), Failed());
+
+  // Swap the first two GUIDs, then duplicate the first one.
+  SmallString<0> Unsorted = Buffer;
+  H = reinterpret_cast<flatsummary::Header *>(Unsorted.data());
+  auto *Values =
+      reinterpret_cast<flatsummary::ValueEntry *>(Unsorted.data() +
+                                                  H->ValuesOffset);
+  ASSERT_GE(H->NumValues, 2u);
+  std::swap(Values[0].GUID, Values[1].GUID);
+  Expected<std::unique_ptr<FlatSummaryIndex>> FSI =
+      FlatSummaryIndex::create(MemoryBufferRef(Unsorted, "index"));
+  ASSERT_FALSE(bool(FSI));
+  EXPECT_EQ("Malformed flat summary index: GUID table is not sorted",
+            toString(FSI.takeError()));
+  Values[0].GUID = Values[1].GUID;
+  EXPECT_THAT_EXPECTED(
+      FlatSummaryIndex::create(MemoryBufferRef(Unsorted, "index")), Failed());
+}
+
+TEST(FlatSummaryIndexTest, InvalidFlags) {
+  // f calls g. Neither has references.
+  ModuleSummaryIndex Index(/*HaveGVs=*/false);
+  StringRef M = Index.addModule("m.o", 0)->first();
+  GlobalValue::GUID F = GlobalValue::getGUID("f");
+  GlobalValue::GUID G = GlobalValue::getGUID("g");
+  Index.addGlobalValueSummary(
+      Index.getOrInsertValueInfo(G),
+      makeFunction(Index, M, GlobalValue::ExternalLinkage, {}, {}));
+  Index.addGlobalValueSummary(
+      Index.getOrInsertValueInfo(F),
+      makeFunction(Index, M, GlobalValue::ExternalLinkage, {},
+                   {{Index.getOrInsertValueInfo(G),
+                     CalleeInfo(CalleeInfo::HotnessType::Critical, 0)}}));
+  SmallString<0> Buffer = write(Index);
+  ASSERT_THAT_EXPECTED(readFlatSummaryIndex(MemoryBufferRef(Buffer, "index")),
+                       Succeeded());
+
+  // Find the summary record of f. It starts with the kind, the GVFlags, the
+  // module and the number of references, as 32-bit values, and the original
+  // name as a 64-bit value. For a function, a 40-byte header and the
+  // references follow, and then the callees, as pairs of a value index and a
+  // CalleeInfo.
+  auto GetRecord = [&](SmallString<0> &Buffer) {
+    auto *H = reinterpret_cast<flatsummary::Header *>(Buffer.data());
+    auto *Values = reinterpret_cast<flatsummary::ValueEntry *>(
+        Buffer.data() + H->ValuesOffset);
+    for (uint32_t I = 0; I != H->NumValues; ++I)
+      if (Values[I].GUID == F)
+        return Buffer.data() + H->SummariesOffset + Values[I].SummariesOffset;
+    return static_cast<char *>(nullptr);
+  };
+  ASSERT_NE(nullptr, GetRecord(Buffer));
+
+  // Both reading the whole index and materializing f fail.
+  auto ExpectError = [&](SmallString<0> &Corrupt, const std::string &Message) {
+    EXPECT_EQ(Message, toString(readFlatSummaryIndex(
+                                    MemoryBufferRef(Corrupt, "index"))
+                                    .takeError()));
+    Expected<std::unique_ptr<FlatSummaryIndex>> FSI =
+        FlatSummaryIndex::create(MemoryBufferRef(Corrupt, "index"));
+    ASSERT_THAT_EXPECTED(FSI, Succeeded());
+    Expected<std::unique_ptr<ModuleSummaryIndex>> Read = (*FSI)->createIndex();
+    ASSERT_THAT_EXPECTED(Read, Succeeded());
+    EXPECT_EQ(Message, toString((*FSI)->materialize(F, **Read).takeError()));
+  };
+
+  // Linkages go up to CommonLinkage (10); the low 4 bits of the GVFlags hold
+  // the linkage.
+  for (unsigned Linkage : {11, 15}) {
+    SmallString<0> Corrupt = Buffer;
+    char *Flags = GetRecord(Corrupt) + 4;
+    *Flags = (*Flags & 0xF0) | Linkage;
+    ExpectError(Corrupt, ("Malformed flat summary index: invalid linkage " +
+                          Twine(Linkage)).str());
+  }
+
+  // Hotness goes up to Critical (4); the low 3 bits of the CalleeInfo hold
+  // the hotness.
+  for (unsigned Hotness : {5, 7}) {
+    SmallString<0> Corrupt = Buffer;
+    char *Info = GetRecord(Corrupt) + 24 + 40 + 4;
+    ASSERT_EQ(uint8_t(CalleeInfo::HotnessType::Critical), *Info & 0x7);
+    *Info = (*Info & 0xF8) | Hotness;
+    ExpectError(Corrupt, ("Malformed flat summary index: invalid hotness " +
+                          Twine(Hotness)).str());
+  }
+}
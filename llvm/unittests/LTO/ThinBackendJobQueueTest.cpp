@@ -0,0 +1,101 @@
+//===- ThinBackendJobQueueTest.cpp - ThinLTO backend scheduling tests -----===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/LTO/LTO.h"
+#include "gtest/gtest.h"
+#include <vector>
+
+using namespace llvm;
+using namespace lto;
+
+namespace {
+
+// Queues one job per estimate. Running a job records its estimate in Ran.
+void pushJobs(ThinBackendJobQueue &Queue, std::vector<uint64_t> &Ran,
+              ArrayRef<uint64_t> Estimates) {
+  for (uint64_t Memory : Estimates)
+    Queue.push(Memory, [&Ran, Memory] { Ran.push_back(Memory); });
+}
+
+// Starts and runs jobs until none may start. Returns their estimates.
+std::vector<uint64_t> startAll(ThinBackendJobQueue &Queue) {
+  std::vector<uint64_t> Started;
+  std::function<void()> Job;
+  uint64_t Memory;
+  while (Queue.startNext(Job, Memory)) {
+    Job();
+    Started.push_back(Memory);
+  }
+  return Started;
+}
+
+TEST(ThinBackendJobQueueTest, LargestFirst) {
+  ThinBackendJobQueue Queue(/*MaxRunningJobs=*/2, /*MemoryLimit=*/0);
+  std::vector<uint64_t> Ran;
+  pushJobs(Queue, Ran, {30, 10, 50, 20});
+
+  EXPECT_EQ(startAll(Queue), std::vector<uint64_t>({50, 30}));
+  EXPECT_EQ(Ran, std::vector<uint64_t>({50, 30}));
+  EXPECT_EQ(Queue.getRunningJobs(), 2u);
+  EXPECT_EQ(Queue.getRunningMemory(), 80u);
+
+  Queue.finish(50);
+  EXPECT_EQ(startAll(Queue), std::vector<uint64_t>({20}));
+  Queue.finish(30);
+  Queue.finish(20);
+  EXPECT_EQ(startAll(Queue), std::vector<uint64_t>({10}));
+  EXPECT_TRUE(Queue.empty());
+}
+
+TEST(ThinBackendJobQueueTest, ZeroJobsMeansOne) {
+  ThinBackendJobQueue Queue(/*MaxRunningJobs=*/0, /*MemoryLimit=*/0);
+  std::vector<uint64_t> Ran;
+  pushJobs(Queue, Ran, {1, 2});
+  EXPECT_EQ(startAll(Queue), std::vector<uint64_t>({2}));
+  Queue.finish(2);
+  EXPECT_EQ(startAll(Queue), std::vector<uint64_t>({1}));
+}
+
+TEST(ThinBackendJobQueueTest, MemoryLimit) {
+  ThinBackendJobQueue Queue(/*MaxRunningJobs=*/8, /*MemoryLimit=*/100);
+  std::vector<uint64_t> Ran;
+  pushJobs(Queue, Ran, {60, 50, 30, 20, 5});
+
+  // 60 starts first. 50 does not fit next to it, but 30 does, and then 5.
+  EXPECT_EQ(startAll(Queue), std::vector<uint64_t>({60, 30, 5}));
+  EXPECT_EQ(Queue.getRunningMemory(), 95u);
+
+  // Once 60 finishes, 50 and 20 fit.
+  Queue.finish(60);
+  EXPECT_EQ(startAll(Queue), std::vector<uint64_t>({50}));
+  Queue.finish(5);
+  EXPECT_EQ(startAll(Queue), std::vector<uint64_t>({20}));
+  EXPECT_EQ(Queue.getRunningMemory(), 100u);
+  EXPECT_TRUE(Queue.empty());
+}
+
+TEST(ThinBackendJobQueueTest, JobLargerThanLimitRunsAlone) {
+  ThinBackendJobQueue Queue(/*MaxRunningJobs=*/8, /*MemoryLimit=*/100);
+  std::vector<uint64_t> Ran;
+  pushJobs(Queue, Ran, {500, 10, 10});
+
+  // Nothing else may start while the oversized job runs.
+  EXPECT_EQ(startAll(Queue), std::vector<uint64_t>({500}));
+  Queue.finish(500);
+  EXPECT_EQ(startAll(Queue), std::vector<uint64_t>({10, 10}));
+
+  // Nor may it start while anything else runs.
+  pushJobs(Queue, Ran, {500});
+  EXPECT_EQ(startAll(Queue), std::vector<uint64_t>());
+  Queue.finish(10);
+  Queue.finish(10);
+  EXPECT_EQ(startAll(Queue), std::vector<uint64_t>({500}));
+  EXPECT_EQ(Ran, std::vector<uint64_t>({500, 10, 10, 500}));
+}
+
+} // end anonymous namespace
@@ -17,6 +17,8 @@
 #include "llvm/Support/Error.h"
 #include "gtest/gtest.h"
 
+#include <string>
+
 using namespace llvm;
 
 namespace {
@@ -65,6 +67,30 @@ TEST(CompressionTest, Zlib) {
   TestZlibCompression(BinaryDataStr, zlib::DefaultCompression);
 }
 
+TEST(CompressionTest, ZlibParallel) {
+  std::string Input;
+  for (int I = 0; I < 5000; ++I)
+    Input += "line " + std::to_string(I % 97) + "\n";
+
+  // A chunk size that does not divide the input, and one larger than it.
+  for (size_t ChunkSize : {size_t(1000), size_t(1) << 20}) {
+    SmallString<32> Compressed;
+    SmallString<32> Uncompressed;
+    EXPECT_FALSE(errorToBool(zlib::compressParallel(
+        Input, Compressed, zlib::DefaultCompression, ChunkSize)));
+    EXPECT_FALSE(
+        errorToBool(zlib::uncompress(Compressed, Uncompressed, Input.size())));
+    EXPECT_EQ(Input, Uncompressed);
+
+    // The output does not depend on whether threads are used.
+    SmallString<32> Serial;
+    EXPECT_FALSE(errorToBool(zlib::compressParallel(
+        Input, Serial, zlib::DefaultCompression, ChunkSize,
+        /*UseThreads=*/false)));
+    EXPECT_EQ(Compressed, Serial);
+  }
+}
+
 TEST(CompressionTest, ZlibCRC32) {
   EXPECT_EQ(
       0x414FA339U,
@@ -73,4 +99,91 @@ TEST(CompressionTest, ZlibCRC32) {
 
 #endif
 
+void TestZstdCompression(StringRef Input, int Level) {
+  SmallString<32> Compressed;
+  SmallString<32> Uncompressed;
+
+  Error E = zstd::compress(Input, Compressed, Level);
+  EXPECT_FALSE(E);
+  consumeError(std::move(E));
+
+  // Check that uncompressed buffer is the same as original.
+  E = zstd::uncompress(Compressed, Uncompressed, Input.size());
+  EXPECT_FALSE(E);
+  consumeError(std::move(E));
+
+  EXPECT_EQ(Input, Uncompressed);
+  if (Input.size() > 0) {
+    // Uncompression fails if expected length is too short.
+    E = zstd::uncompress(Compressed, Uncompressed, Input.size() - 1);
+    EXPECT_TRUE(errorToBool(std::move(E)));
+  }
+}
+
+TEST(CompressionTest, Zstd) {
+  if (!zstd::isAvailable())
+    return;
+
+  TestZstdCompression("", zstd::DefaultCompression);
+
+  TestZstdCompression("hello, world!", zstd::HighCompression);
+  TestZstdCompression("hello, world!", zstd::BestSpeedCompression);
+  TestZstdCompression("hello, world!", zstd::DefaultCompression);
+
+  const size_t kSize = 1024;
+  char BinaryData[kSize];
+  for (size_t i = 0; i < kSize; ++i) {
+    BinaryData[i] = i & 255;
+  }
+  StringRef BinaryDataStr(BinaryData, kSize);
+
+  TestZstdCompression(BinaryDataStr, zstd::HighCompression);
+  TestZstdCompression(BinaryDataStr, zstd::BestSpeedCompression);
+  TestZstdCompression(BinaryDataStr, zstd::DefaultCompression);
+}
+
+TEST(CompressionTest, ZstdParallel) {
+  if (!zstd::isAvailable())
+    return;
+
+  std::string Input;
+  for (int I = 0; I < 5000; ++I)
+    Input += "line " + std::to_string(I % 97) + "\n";
+
+  for (size_t ChunkSize : {size_t(1000), size_t(1) << 20}) {
+    SmallString<32> Compressed;
+    SmallString<32> Uncompressed;
+    EXPECT_FALSE(errorToBool(zstd::compressParallel(
+        Input, Compressed, zstd::DefaultCompression, ChunkSize)));
+    EXPECT_FALSE(
+        errorToBool(zstd::uncompress(Compressed, Uncompressed, Input.size())));
+    EXPECT_EQ(Input, Uncompressed);
+
+    // The output does not depend on whether threads are used.
+    SmallString<32> Serial;
+    EXPECT_FALSE(errorToBool(zstd::compressParallel(
+        Input, Serial, zstd::DefaultCompression, ChunkSize,
+        /*UseThreads=*/false)));
+    EXPECT_EQ(Compressed, Serial);
+  }
+}
+
+TEST(CompressionTest, Format) {
+  using compression::Format;
+  EXPECT_STREQ("zlib", compression::getName(Format::Zlib));
+  EXPECT_STREQ("zstd", compression::getName(Format::Zstd));
+
+  for (Format F : {Format::Zlib, Format::Zstd}) {
+    if (!compression::isAvailable(F))
+      continue;
+    StringRef Input = "hello, hello, hello, world!";
+    SmallString<32> Compressed;
+    SmallString<32> Uncompressed;
+    EXPECT_FALSE(errorToBool(compression::compress(F, Input, Compressed)));
+    EXPECT_FALSE(errorToBool(
+        compression::uncompress(F, Compressed, Uncompressed, Input.size())));
+    EXPECT_EQ(Input, Uncompressed);
+  }
+}
+
 }
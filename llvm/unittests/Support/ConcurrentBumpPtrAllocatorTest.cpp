@@ -0,0 +1,105 @@
+//===- ConcurrentBumpPtrAllocatorTest.cpp ---------------------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/ConcurrentBumpPtrAllocator.h"
+#include "llvm/Config/llvm-config.h"
+#include "gtest/gtest.h"
+#include <atomic>
+#include <memory>
+#if LLVM_ENABLE_THREADS
+#include <thread>
+#endif
+
+using namespace llvm;
+
+namespace {
+
+struct Counted {
+  static std::atomic<int> Live;
+  int Value;
+  explicit Counted(int V) : Value(V) { ++Live; }
+  ~Counted() { --Live; }
+};
+std::atomic<int> Counted::Live;
+
+TEST(ConcurrentBumpPtrAllocatorTest, Basics) {
+  ConcurrentBumpPtrAllocator Alloc;
+  int *A = Alloc.Allocate<int>();
+  int *B = Alloc.Allocate<int>(10);
+  *A = 1;
+  B[9] = 2;
+  EXPECT_EQ(1, *A);
+  EXPECT_EQ(2, B[9]);
+  EXPECT_EQ(11 * sizeof(int), Alloc.getBytesAllocated());
+  EXPECT_LE(Alloc.getBytesAllocated(), Alloc.getTotalMemory());
+
+  Alloc.Reset();
+  EXPECT_EQ(0u, Alloc.getBytesAllocated());
+}
+
+// Many live allocators must not mix up each other's memory, even when they
+// compete for the same thread-local cache entries.
+TEST(ConcurrentBumpPtrAllocatorTest, ManyAllocators) {
+  std::vector<std::unique_ptr<ConcurrentBumpPtrAllocator>> Allocs;
+  for (int I = 0; I < 300; ++I) {
+    Allocs.push_back(std::make_unique<ConcurrentBumpPtrAllocator>());
+    Allocs.back()->Allocate(I + 1, 1);
+  }
+  for (int I = 0; I < 300; ++I) {
+    Allocs[I]->Allocate(1, 1);
+    EXPECT_EQ(size_t(I + 2), Allocs[I]->getBytesAllocated());
+  }
+}
+
+TEST(ConcurrentBumpPtrAllocatorTest, Specific) {
+  {
+    ConcurrentSpecificBumpPtrAllocator<Counted> Alloc;
+    for (int I = 0; I < 1000; ++I)
+      new (Alloc.Allocate()) Counted(I);
+    EXPECT_EQ(1000, Counted::Live);
+    Alloc.DestroyAll();
+    EXPECT_EQ(0, Counted::Live);
+
+    new (Alloc.Allocate()) Counted(0);
+    EXPECT_EQ(1, Counted::Live);
+  }
+  EXPECT_EQ(0, Counted::Live);
+}
+
+#if LLVM_ENABLE_THREADS
+TEST(ConcurrentBumpPtrAllocatorTest, Threads) {
+  ConcurrentSpecificBumpPtrAllocator<Counted> Alloc;
+  ConcurrentBumpPtrAllocator Bytes;
+  const int NumThreads = 8, NumObjects = 10000;
+  std::vector<std::vector<Counted *>> Objects(NumThreads);
+  std::vector<std::thread> Threads;
+  for (int T = 0; T < NumThreads; ++T) {
+    Threads.emplace_back([&, T] {
+      for (int I = 0; I < NumObjects; ++I) {
+        Counted *C = new (Alloc.Allocate()) Counted(T * NumObjects + I);
+        Objects[T].push_back(C);
+        Bytes.Allocate(16, 16);
+      }
+    });
+  }
+  for (std::thread &T : Threads)
+    T.join();
+
+  // The objects outlive the threads that created them.
+  for (int T = 0; T < NumThreads; ++T)
+    for (int I = 0; I < NumObjects; ++I)
+      EXPECT_EQ(T * NumObjects + I, Objects[T][I]->Value);
+  EXPECT_EQ(NumThreads * NumObjects, Counted::Live);
+  EXPECT_EQ(size_t(16 * NumThreads * NumObjects), Bytes.getBytesAllocated());
+
+  Alloc.DestroyAll();
+  EXPECT_EQ(0, Counted::Live);
+}
+#endif
+
+} // end anonymous namespace
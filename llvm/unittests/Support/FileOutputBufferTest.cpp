@@ -12,9 +12,14 @@
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/Process.h"
 #include "llvm/Support/raw_ostream.h"
 #include "gtest/gtest.h"
 
+#if !defined(_WIN32)
+#include <sys/file.h>
+#endif
+
 using namespace llvm;
 using namespace llvm::sys;
 
@@ -140,6 +145,114 @@ TEST(FileOutputBuffer, Test) {
   ASSERT_NO_ERROR(fs::file_size(Twine(File5), File5Size));
   ASSERT_EQ(File5Size, 8000ULL);
   ASSERT_NO_ERROR(fs::remove(File5.str()));
+
+  // TEST 6: F_modify updates an existing file of the same size in place.
+  SmallString<128> File6(TestDirectory);
+  File6.append("/file6");
+  {
+    Expected<std::unique_ptr<FileOutputBuffer>> BufferOrErr =
+        FileOutputBuffer::create(File6, 200000);
+    ASSERT_NO_ERROR(errorToErrorCode(BufferOrErr.takeError()));
+    std::unique_ptr<FileOutputBuffer> &Buffer = *BufferOrErr;
+    memset(Buffer->getBufferStart(), 'A', 200000);
+    ASSERT_NO_ERROR(errorToErrorCode(Buffer->commit()));
+  }
+  auto SetOldModificationTime = [&] {
+    int FD;
+    ASSERT_NO_ERROR(fs::openFileForReadWrite(File6, FD, fs::CD_OpenExisting,
+                                             fs::OF_None));
+    ASSERT_NO_ERROR(fs::setLastAccessAndModificationTime(
+        FD, sys::toTimePoint(946684800)));
+    Process::SafelyCloseFileDescriptor(FD);
+  };
+  auto GetModificationTime = [&] {
+    fs::file_status Status;
+    EXPECT_FALSE(fs::status(File6, Status));
+    return Status.getLastModificationTime();
+  };
+  auto Modify = [&](const char *Data) {
+    Expected<std::unique_ptr<FileOutputBuffer>> BufferOrErr =
+        FileOutputBuffer::create(File6, 200000, FileOutputBuffer::F_modify);
+    ASSERT_NO_ERROR(errorToErrorCode(BufferOrErr.takeError()));
+    std::unique_ptr<FileOutputBuffer> &Buffer = *BufferOrErr;
+    memset(Buffer->getBufferStart(), 'A', 200000);
+    memcpy(Buffer->getBufferStart() + 100000, Data, 20);
+    ASSERT_NO_ERROR(errorToErrorCode(Buffer->commit()));
+  };
+  fs::UniqueID OldID;
+  ASSERT_NO_ERROR(fs::getUniqueID(File6, OldID));
+  SetOldModificationTime();
+  Modify("AABBCCDDEEFFGGHHIIJJ");
+  // Verify the file has the new contents and a new modification time. The
+  // file cannot be locked on Windows, so it is replaced there.
+  fs::UniqueID NewID;
+  ASSERT_NO_ERROR(fs::getUniqueID(File6, NewID));
+#if !defined(_WIN32)
+  EXPECT_EQ(OldID, NewID);
+#endif
+  EXPECT_GT(GetModificationTime(), sys::toTimePoint(946684800));
+  // Unchanged contents still update the modification time.
+  SetOldModificationTime();
+  Modify("AABBCCDDEEFFGGHHIIJJ");
+  EXPECT_GT(GetModificationTime(), sys::toTimePoint(946684800));
+#if !defined(_WIN32)
+  // A file that is locked elsewhere is replaced instead of modified.
+  {
+    int FD;
+    ASSERT_NO_ERROR(fs::openFileForRead(File6, FD));
+    ASSERT_EQ(0, ::flock(FD, LOCK_EX));
+    ASSERT_NO_ERROR(fs::getUniqueID(File6, OldID));
+    Modify("AABBCCDDEEFFGGHHIIJJ");
+    ASSERT_NO_ERROR(fs::getUniqueID(File6, NewID));
+    EXPECT_NE(OldID, NewID);
+    Process::SafelyCloseFileDescriptor(FD);
+  }
+#endif
+  {
+    ErrorOr<std::unique_ptr<MemoryBuffer>> BufOrErr =
+        MemoryBuffer::getFile(File6);
+    ASSERT_NO_ERROR(BufOrErr.getError());
+    StringRef Data = (*BufOrErr)->getBuffer();
+    ASSERT_EQ(Data.size(), 200000ULL);
+    EXPECT_EQ(Data.substr(100000, 20), "AABBCCDDEEFFGGHHIIJJ");
+    EXPECT_EQ(Data.count('A'), 200000ULL - 18);
+  }
+  // A size mismatch falls back to replacing the file.
+  {
+    Expected<std::unique_ptr<FileOutputBuffer>> BufferOrErr =
+        FileOutputBuffer::create(File6, 8192, FileOutputBuffer::F_modify);
+    ASSERT_NO_ERROR(errorToErrorCode(BufferOrErr.takeError()));
+    ASSERT_NO_ERROR(errorToErrorCode((*BufferOrErr)->commit()));
+  }
+  uint64_t File6Size;
+  ASSERT_NO_ERROR(fs::file_size(Twine(File6), File6Size));
+  ASSERT_EQ(File6Size, 8192ULL);
+  ASSERT_NO_ERROR(fs::remove(File6.str()));
+
+  // TEST 7: Finalized ranges keep their contents.
+  SmallString<128> File7(TestDirectory);
+  File7.append("/file7");
+  {
+    Expected<std::unique_ptr<FileOutputBuffer>> BufferOrErr =
+        FileOutputBuffer::create(File7, 200000);
+    ASSERT_NO_ERROR(errorToErrorCode(BufferOrErr.takeError()));
+    std::unique_ptr<FileOutputBuffer> &Buffer = *BufferOrErr;
+    memset(Buffer->getBufferStart(), 'A', 100000);
+    Buffer->finalizeRange(0, 100000);
+    memset(Buffer->getBufferStart() + 100000, 'B', 100000);
+    EXPECT_EQ(Buffer->getBufferStart()[0], 'A');
+    ASSERT_NO_ERROR(errorToErrorCode(Buffer->commit()));
+  }
+  {
+    ErrorOr<std::unique_ptr<MemoryBuffer>> BufOrErr =
+        MemoryBuffer::getFile(File7);
+    ASSERT_NO_ERROR(BufOrErr.getError());
+    StringRef Data = (*BufOrErr)->getBuffer();
+    ASSERT_EQ(Data.size(), 200000ULL);
+    EXPECT_EQ(Data.count('A'), 100000ULL);
+    EXPECT_EQ(Data.count('B'), 100000ULL);
+  }
+  ASSERT_NO_ERROR(fs::remove(File7.str()));
   // Clean up.
   ASSERT_NO_ERROR(fs::remove(TestDirectory.str()));
 }
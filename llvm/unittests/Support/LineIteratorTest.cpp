@@ -165,6 +165,30 @@ TEST(LineIteratorTest, BlankKeeping) {
   EXPECT_EQ(E, I);
 }
 
+TEST(LineIteratorTest, LongLines) {
+  std::unique_ptr<MemoryBuffer> Buffer(
+      MemoryBuffer::getMemBuffer("a line that is longer than sixteen bytes\r\n"
+                                 "# a comment that is longer than sixteen bytes\n"
+                                 "a line with a lone \r in the middle\r\n"
+                                 "\r\n"
+                                 "last line ending in \r"));
+
+  line_iterator I = line_iterator(*Buffer, /*SkipBlanks=*/false, '#'), E;
+  EXPECT_EQ("a line that is longer than sixteen bytes", *I);
+  EXPECT_EQ(1, I.line_number());
+  ++I;
+  EXPECT_EQ("a line with a lone \r in the middle", *I);
+  EXPECT_EQ(3, I.line_number());
+  ++I;
+  EXPECT_EQ("", *I);
+  EXPECT_EQ(4, I.line_number());
+  ++I;
+  EXPECT_EQ("last line ending in \r", *I);
+  EXPECT_EQ(5, I.line_number());
+  ++I;
+  EXPECT_EQ(E, I);
+}
+
 TEST(LineIteratorTest, EmptyBuffers) {
   std::unique_ptr<MemoryBuffer> Buffer = MemoryBuffer::getMemBuffer("");
   EXPECT_TRUE(line_iterator(*Buffer).is_at_eof());
@@ -14,6 +14,7 @@
 #include "llvm/ADT/ScopeExit.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/FileUtilities.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Testing/Support/Error.h"
 #include "gtest/gtest.h"
@@ -148,6 +149,56 @@ TEST_F(MemoryBufferTest, NullTerminator4K) {
   EXPECT_EQ('\0', BufData[4096]);
 }
 
+TEST_F(MemoryBufferTest, getFiles) {
+  int SmallFD, LargeFD;
+  SmallString<64> SmallPath, LargePath;
+  ASSERT_NO_ERROR(sys::fs::createTemporaryFile("MemoryBufferTest_getFiles",
+                                               "temp", SmallFD, SmallPath));
+  FileRemover SmallCleanup(SmallPath);
+  ASSERT_NO_ERROR(sys::fs::createTemporaryFile("MemoryBufferTest_getFiles",
+                                               "temp", LargeFD, LargePath));
+  FileRemover LargeCleanup(LargePath);
+  {
+    raw_fd_ostream OF(SmallFD, /*shouldClose*/ true);
+    OF << "12345678";
+  }
+  // Large enough to be memory mapped.
+  {
+    raw_fd_ostream OF(LargeFD, /*shouldClose*/ true);
+    for (unsigned I = 0; I < 0x10000; ++I)
+      OF << "0123456789abcdef";
+    OF << "x";
+  }
+  SmallString<64> MissingPath(LargePath);
+  MissingPath += ".missing";
+
+  ThreadPool Pool(2);
+  StringRef Paths[] = {SmallPath, LargePath, MissingPath, LargePath};
+  std::vector<Expected<OwningBuffer>> MBs = MemoryBuffer::getFiles(Paths, Pool);
+  ASSERT_EQ(4u, MBs.size());
+
+  // Destroying a buffer while it is being read in must be safe.
+  ASSERT_THAT_EXPECTED(MBs[3], Succeeded());
+  MBs[3]->reset();
+
+  ASSERT_THAT_EXPECTED(MBs[0], Succeeded());
+  EXPECT_EQ("12345678", (*MBs[0])->getBuffer());
+  EXPECT_EQ(SmallPath, (*MBs[0])->getBufferIdentifier());
+
+  ASSERT_THAT_EXPECTED(MBs[1], Succeeded());
+  const MemoryBuffer &MB = **MBs[1];
+  EXPECT_EQ(LargePath, MB.getBufferIdentifier());
+  ASSERT_EQ(0x100001u, MB.getBufferSize());
+  for (size_t I = 0; I < 0x100000; I += 0x10)
+    ASSERT_EQ("0123456789abcdef", MB.getBuffer().substr(I, 0x10)) << "I: " << I;
+  EXPECT_EQ('x', MB.getBufferEnd()[-1]);
+  EXPECT_EQ('\0', MB.getBufferEnd()[0]);
+
+  EXPECT_EQ(std::errc::no_such_file_or_directory,
+            errorToErrorCode(MBs[2].takeError()));
+  Pool.wait();
+}
+
 TEST_F(MemoryBufferTest, copy) {
   // copy with no name
   OwningBuffer MBC1(MemoryBuffer::getMemBufferCopy(data));
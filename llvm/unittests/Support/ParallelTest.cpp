@@ -14,6 +14,8 @@
 #include "llvm/Support/Parallel.h"
 #include "gtest/gtest.h"
 #include <array>
+#include <atomic>
+#include <mutex>
 #include <random>
 
 uint32_t array[1024 * 1024];
@@ -49,4 +51,59 @@ TEST(Parallel, parallel_for) {
   ASSERT_EQ(range[2049], 1u);
 }
 
+TEST(Parallel, nested) {
+  // Nested parallel loops must not deadlock, even when there are more outer
+  // tasks than threads.
+  std::atomic<uint32_t> count{0};
+  for_each_n(parallel::par, 0, 64, [&](size_t I) {
+    for_each_n(parallel::par, 0, 1024, [&](size_t J) { ++count; });
+  });
+  ASSERT_EQ(count, 64u * 1024u);
+}
+
+TEST(Parallel, nested_sort) {
+  std::vector<std::vector<uint32_t>> vecs(16);
+  std::mt19937 randEngine;
+  std::uniform_int_distribution<uint32_t> dist;
+  for (auto &v : vecs)
+    for (size_t I = 0; I < 4096; ++I)
+      v.push_back(dist(randEngine));
+
+  for_each(parallel::par, vecs.begin(), vecs.end(),
+           [](std::vector<uint32_t> &v) {
+             sort(parallel::par, v.begin(), v.end());
+           });
+  for (auto &v : vecs)
+    ASSERT_TRUE(std::is_sorted(v.begin(), v.end()));
+}
+
+TEST(Parallel, nested_with_lock) {
+  // A thread waiting for a TaskGroup must only run tasks of that group. Here
+  // the waiting thread holds a lock that the tasks of another group take, so
+  // running one of those would deadlock. Those tasks may also occupy every
+  // worker, so the nested groups must be able to finish on this thread alone.
+  std::mutex mu;
+  std::atomic<uint32_t> count{0};
+  std::unique_lock<std::mutex> held(mu);
+  parallel::detail::TaskGroup other;
+  {
+    parallel::detail::TaskGroup outer;
+    for (size_t I = 0; I < 8; ++I)
+      outer.spawn([&] {
+        for (size_t J = 0; J < 2; ++J)
+          other.spawn([&] {
+            std::lock_guard<std::mutex> lock(mu);
+            ++count;
+          });
+        parallel::detail::TaskGroup inner;
+        for (size_t J = 0; J < 8; ++J)
+          inner.spawn([&] { ++count; });
+      });
+  }
+  EXPECT_EQ(count, 64u);
+  held.unlock();
+  other.sync();
+  ASSERT_EQ(count, 64u + 16u);
+}
+
 #endif
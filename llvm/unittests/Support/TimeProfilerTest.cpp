@@ -0,0 +1,92 @@
+//===- unittests/Support/TimeProfilerTest.cpp - TimeProfiler tests --------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/TimeProfiler.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/JSON.h"
+#include "gtest/gtest.h"
+
+#include <set>
+#include <thread>
+#include <vector>
+
+using namespace llvm;
+
+namespace {
+
+// Returns the set of thread IDs of the complete events named Name.
+static std::set<int64_t> getEventTids(StringRef Trace, StringRef Name) {
+  std::set<int64_t> Tids;
+  Expected<json::Value> V = json::parse(Trace);
+  if (!V) {
+    consumeError(V.takeError());
+    return Tids;
+  }
+  for (const json::Value &E : *V->getAsObject()->getArray("traceEvents")) {
+    const json::Object *O = E.getAsObject();
+    if (O->getString("ph") == StringRef("X") &&
+        O->getString("name") == Name)
+      Tids.insert(*O->getInteger("tid"));
+  }
+  return Tids;
+}
+
+TEST(TimeProfiler, MultipleThreads) {
+  timeTraceProfilerInitialize(0);
+  {
+    TimeTraceScope Scope("main", StringRef());
+    std::vector<std::thread> Threads;
+    for (int I = 0; I < 4; ++I)
+      Threads.emplace_back([] {
+        TimeTraceScope Outer("worker", StringRef());
+        TimeTraceScope Inner("inner", StringRef());
+      });
+    for (std::thread &T : Threads)
+      T.join();
+  }
+
+  SmallString<1024> Trace;
+  raw_svector_ostream OS(Trace);
+  timeTraceProfilerWrite(OS);
+  timeTraceProfilerCleanup();
+
+  EXPECT_EQ(std::set<int64_t>{0}, getEventTids(Trace, "main"));
+  std::set<int64_t> WorkerTids = getEventTids(Trace, "worker");
+  EXPECT_EQ(4u, WorkerTids.size());
+  EXPECT_EQ(0u, WorkerTids.count(0));
+  EXPECT_EQ(WorkerTids, getEventTids(Trace, "inner"));
+
+  // Totals are summed over all threads.
+  Expected<json::Value> V = json::parse(Trace);
+  ASSERT_TRUE(bool(V));
+  for (const json::Value &E : *V->getAsObject()->getArray("traceEvents")) {
+    const json::Object *O = E.getAsObject();
+    if (O->getString("name") == StringRef("Total worker")) {
+      EXPECT_EQ(4, *O->getObject("args")->getInteger("count"));
+    }
+  }
+}
+
+TEST(TimeProfiler, Reinitialize) {
+  // Buffers of a destroyed profiler must not be reused by a new one.
+  for (int I = 0; I < 2; ++I) {
+    timeTraceProfilerInitialize(0);
+    std::thread([] { TimeTraceScope Scope("worker", StringRef()); }).join();
+    { TimeTraceScope Scope("main", StringRef()); }
+
+    SmallString<1024> Trace;
+    raw_svector_ostream OS(Trace);
+    timeTraceProfilerWrite(OS);
+    timeTraceProfilerCleanup();
+
+    EXPECT_EQ(std::set<int64_t>{0}, getEventTids(Trace, "main"));
+    EXPECT_EQ(std::set<int64_t>{1}, getEventTids(Trace, "worker"));
+  }
+}
+
+} // namespace
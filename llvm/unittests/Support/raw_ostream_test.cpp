@@ -8,7 +8,9 @@
 
 #include "llvm/ADT/SmallString.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/FileUtilities.h"
 #include "llvm/Support/Format.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/raw_ostream.h"
 #include "gtest/gtest.h"
 
@@ -342,4 +344,62 @@ TEST(raw_fd_ostreamTest, multiple_raw_fd_ostream_to_stdout) {
   { raw_fd_ostream("-", EC, sys::fs::OpenFlags::OF_None); }
   { raw_fd_ostream("-", EC, sys::fs::OpenFlags::OF_None); }
 }
+
+static std::string readFile(StringRef Path) {
+  ErrorOr<std::unique_ptr<MemoryBuffer>> MB = MemoryBuffer::getFile(Path);
+  EXPECT_FALSE(MB.getError());
+  return MB ? (*MB)->getBuffer().str() : "";
+}
+
+TEST(raw_fd_ostreamTest, pwrite) {
+  int FD;
+  SmallString<64> Path;
+  ASSERT_FALSE(sys::fs::createTemporaryFile("raw_fd_ostream", "tmp", FD, Path));
+  FileRemover Cleanup(Path);
+  {
+    raw_fd_ostream OS(FD, true);
+    OS << "abcdefgh";
+    // Still in the buffer.
+    OS.pwrite("XY", 2, 2);
+    OS.flush();
+    OS << "ijkl";
+    // Partly written out.
+    OS.pwrite("12345", 5, 6);
+    OS << "mn";
+    EXPECT_EQ(14u, OS.tell());
+  }
+  EXPECT_EQ("abXYef12345lmn", readFile(Path));
+}
+
+TEST(raw_fd_ostreamTest, BackgroundWrites) {
+  int FD;
+  SmallString<64> Path;
+  ASSERT_FALSE(sys::fs::createTemporaryFile("raw_fd_ostream", "tmp", FD, Path));
+  FileRemover Cleanup(Path);
+
+  std::string Expected;
+  raw_string_ostream ExpectedOS(Expected);
+  {
+    raw_fd_ostream OS(FD, true);
+    OS << "head";
+    OS.enableBackgroundWrites(64);
+    std::string Large(1000, 'x');
+    for (unsigned I = 0; I < 1000; ++I) {
+      OS << I << ' ';
+      ExpectedOS << I << ' ';
+      if (I % 100 == 0) {
+        OS << Large;
+        ExpectedOS << Large;
+      }
+      if (I % 250 == 0)
+        OS.flush();
+    }
+    EXPECT_EQ(4 + ExpectedOS.str().size(), OS.tell());
+    OS.pwrite("HEAD", 4, 0);
+    OS << "tail";
+    OS.close();
+    EXPECT_FALSE(OS.has_error());
+  }
+  EXPECT_EQ("HEAD" + Expected + "tail", readFile(Path));
+}
 }
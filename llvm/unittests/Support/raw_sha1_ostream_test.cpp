@@ -11,6 +11,7 @@
 #include "gtest/gtest.h"
 
 #include <string>
+#include <vector>
 
 using namespace llvm;
 
@@ -75,3 +76,23 @@ TEST(raw_sha1_ostreamTest, Reset) {
 
   ASSERT_EQ("7447F2A5A42185C8CF91E632789C431830B59067", Hash);
 }
+
+// Check that hashing whole blocks in place agrees with the buffered path, no
+// matter how the input is split.
+TEST(sha1_hash_test, Large) {
+  std::vector<uint8_t> Data;
+  for (size_t I = 0; I < 100000; ++I)
+    Data.push_back(I * 31 + 7);
+  ArrayRef<uint8_t> Input(Data);
+
+  std::array<uint8_t, 20> Vec = SHA1::hash(Input);
+  ASSERT_EQ("35AB00C96F47C268B087D40D0DCD7245809F0D5C",
+            toHex({(const char *)Vec.data(), 20}));
+
+  for (size_t Split : {1, 63, 64, 65, 1000}) {
+    SHA1 Hash;
+    Hash.update(Input.take_front(Split));
+    Hash.update(Input.drop_front(Split));
+    ASSERT_EQ("35AB00C96F47C268B087D40D0DCD7245809F0D5C", toHex(Hash.final()));
+  }
+}
@@ -9,6 +9,8 @@
 #include "llvm/Support/xxhash.h"
 #include "gtest/gtest.h"
 
+#include <vector>
+
 using namespace llvm;
 
 TEST(xxhashTest, Basic) {
@@ -17,3 +19,22 @@ TEST(xxhashTest, Basic) {
   EXPECT_EQ(0x69196c1b3af0bff9U,
             xxHash64("0123456789abcdefghijklmnopqrstuvwxyz"));
 }
+
+TEST(xxhashTest, xxh3) {
+  EXPECT_EQ(0x2d06800538d394c2U, xxh3_64bits(""));
+  EXPECT_EQ(0xe6c632b61e964e1fU, xxh3_64bits("a"));
+  EXPECT_EQ(0xab6e5f64077e7d8aU, xxh3_64bits("foo"));
+  EXPECT_EQ(0x1808e40d6723f646U, xxh3_64bits("01234567"));
+  EXPECT_EQ(0x64439946d8fa212dU, xxh3_64bits("0123456789abcdef"));
+  EXPECT_EQ(0xffb92a87c6306d55U,
+            xxh3_64bits("0123456789abcdefghijklmnopqrstuvwxyz"));
+
+  // Exercise the mid-size and long input paths.
+  std::vector<uint8_t> Data;
+  for (size_t I = 0; I < 100000; ++I)
+    Data.push_back(I * 31 + 7);
+  ArrayRef<uint8_t> Ref(Data);
+  EXPECT_EQ(0x12fdb864685f344dU, xxh3_64bits(Ref.take_front(200)));
+  EXPECT_EQ(0x19f6f9c987331373U, xxh3_64bits(Ref.take_front(2048)));
+  EXPECT_EQ(0xccf90df7e7e37036U, xxh3_64bits(Ref));
+}
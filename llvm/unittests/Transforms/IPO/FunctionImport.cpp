@@ -0,0 +1,151 @@
+//===- FunctionImport.cpp - Unit tests for the thin link analyses ---------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Transforms/IPO/FunctionImport.h"
+#include "llvm/IR/ModuleSummaryIndex.h"
+#include "llvm/Support/CommandLine.h"
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <random>
+
+using namespace llvm;
+
+namespace {
+
+// Build a combined index of modules whose functions call functions of other
+// modules and reference variables, with a few aliases and linkonce_odr
+// functions defined in several modules. There are enough liveness roots to
+// be processed in several chunks.
+void buildIndex(ModuleSummaryIndex &Index,
+                DenseSet<GlobalValue::GUID> &Preserved) {
+  const unsigned NumModules = 100, NumFunctions = 40;
+  std::mt19937 Gen(1);
+  auto Random = [&](unsigned N) { return Gen() % N; };
+  auto GUID = [](const char *Kind, unsigned M, unsigned I) {
+    return GlobalValue::getGUID((Kind + Twine(M) + "_" + Twine(I)).str());
+  };
+  auto Flags = [](GlobalValue::LinkageTypes Linkage) {
+    return GlobalValueSummary::GVFlags(Linkage, /*NotEligibleToImport=*/false,
+                                       /*Live=*/false, /*IsLocal=*/false,
+                                       /*CanAutoHide=*/false);
+  };
+
+  for (unsigned M = 0; M < NumModules; ++M) {
+    StringRef Path = Index.addModule(("m" + Twine(M)).str(), M)->first();
+    auto Var = std::make_unique<GlobalVarSummary>(
+        Flags(GlobalValue::ExternalLinkage),
+        GlobalVarSummary::GVarFlags(/*ReadOnly=*/true, /*WriteOnly=*/false),
+        std::vector<ValueInfo>());
+    Var->setModulePath(Path);
+    Index.addGlobalValueSummary(Index.getOrInsertValueInfo(GUID("v", M, 0)),
+                                std::move(Var));
+
+    for (unsigned F = 0; F < NumFunctions; ++F) {
+      std::vector<FunctionSummary::EdgeTy> Calls;
+      for (unsigned C = 0; C < 3; ++C) {
+        GlobalValue::GUID Callee =
+            Random(10) ? GUID("f", Random(NumModules), Random(NumFunctions))
+                       : GUID("l", 0, Random(20));
+        Calls.push_back({Index.getOrInsertValueInfo(Callee), CalleeInfo()});
+      }
+      auto Fn = std::make_unique<FunctionSummary>(
+          Flags(Random(5) ? GlobalValue::ExternalLinkage
+                          : GlobalValue::InternalLinkage),
+          /*NumInsts=*/1 + Random(150), FunctionSummary::FFlags{},
+          /*EntryCount=*/0,
+          std::vector<ValueInfo>{
+              Index.getOrInsertValueInfo(GUID("v", Random(NumModules), 0))},
+          std::move(Calls), std::vector<GlobalValue::GUID>(),
+          std::vector<FunctionSummary::VFuncId>(),
+          std::vector<FunctionSummary::VFuncId>(),
+          std::vector<FunctionSummary::ConstVCall>(),
+          std::vector<FunctionSummary::ConstVCall>());
+      Fn->setModulePath(Path);
+      FunctionSummary *Aliasee = Fn.get();
+      ValueInfo AliaseeVI = Index.getOrInsertValueInfo(GUID("f", M, F));
+      Index.addGlobalValueSummary(AliaseeVI, std::move(Fn));
+      if (F % 8 == 0) {
+        auto Alias =
+            std::make_unique<AliasSummary>(Flags(GlobalValue::ExternalLinkage));
+        Alias->setAliasee(AliaseeVI, Aliasee);
+        Alias->setModulePath(Path);
+        Index.addGlobalValueSummary(
+            Index.getOrInsertValueInfo(GUID("a", M, F)), std::move(Alias));
+      }
+    }
+
+    // Each module defines one of the linkonce_odr functions.
+    auto LinkOnce = std::make_unique<FunctionSummary>(
+        Flags(GlobalValue::LinkOnceODRLinkage), /*NumInsts=*/5,
+        FunctionSummary::FFlags{}, /*EntryCount=*/0, std::vector<ValueInfo>(),
+        std::vector<FunctionSummary::EdgeTy>(),
+        std::vector<GlobalValue::GUID>(),
+        std::vector<FunctionSummary::VFuncId>(),
+        std::vector<FunctionSummary::VFuncId>(),
+        std::vector<FunctionSummary::ConstVCall>(),
+        std::vector<FunctionSummary::ConstVCall>());
+    LinkOnce->setModulePath(Path);
+    Index.addGlobalValueSummary(
+        Index.getOrInsertValueInfo(GUID("l", 0, M % 20)), std::move(LinkOnce));
+  }
+
+  for (unsigned M = 0; M < NumModules; ++M)
+    for (unsigned F = 0; F < NumFunctions; F += 3)
+      Preserved.insert(GUID(F % 8 ? "f" : "a", M, F));
+}
+
+// Run the dead symbol and import analyses, and print their results in a
+// canonical order.
+std::vector<std::string> analyze(bool Parallel) {
+  auto *Opt = static_cast<cl::opt<bool> *>(
+      cl::getRegisteredOptions().lookup("thinlto-parallel-thin-link"));
+  bool OldParallel = *Opt;
+  *Opt = Parallel;
+
+  ModuleSummaryIndex Index(/*HaveGVs=*/false);
+  DenseSet<GlobalValue::GUID> Preserved;
+  buildIndex(Index, Preserved);
+  computeDeadSymbols(Index, Preserved, [](GlobalValue::GUID) {
+    return PrevailingType::Unknown;
+  });
+  StringMap<GVSummaryMapTy> ModuleToDefinedGVSummaries;
+  Index.collectDefinedGVSummariesPerModule(ModuleToDefinedGVSummaries);
+  StringMap<FunctionImporter::ImportMapTy> ImportLists;
+  StringMap<FunctionImporter::ExportSetTy> ExportLists;
+  ComputeCrossModuleImport(Index, ModuleToDefinedGVSummaries, ImportLists,
+                           ExportLists);
+  *Opt = OldParallel;
+
+  std::vector<std::string> Result;
+  for (auto &I : Index)
+    for (auto &S : I.second.SummaryList)
+      if (S->isLive())
+        Result.push_back(("live " + Twine(I.first) + " " + S->modulePath())
+                             .str());
+  for (auto &IL : ImportLists)
+    for (auto &Src : IL.second)
+      for (GlobalValue::GUID G : Src.second)
+        Result.push_back(("import " + IL.first() + " " + Src.first() + " " +
+                          Twine(G))
+                             .str());
+  for (auto &EL : ExportLists)
+    for (GlobalValue::GUID G : EL.second)
+      Result.push_back(("export " + EL.first() + " " + Twine(G)).str());
+  llvm::sort(Result);
+  return Result;
+}
+
+} // end anonymous namespace
+
+TEST(FunctionImport, ParallelThinLinkMatchesSerial) {
+  std::vector<std::string> Serial = analyze(false);
+  EXPECT_NE(0, llvm::count_if(Serial, [](const std::string &S) {
+              return StringRef(S).startswith("import ");
+            }));
+  EXPECT_EQ(Serial, analyze(true));
+}